@@ -18,11 +18,30 @@
 #define BME280_CTRL_HUM_VAL  0x01U                // Humidity oversampling x1
 #define BME280_CTRL_MEAS_FORCED (0x20U | 0x04U | 0x01U) // Temp x1 (bits 7:5), Press x1 (4:2), forced (1:0)
 #define BME280_CONFIG_VAL    0x00U                // No filter, 0.5 ms standby; simplest path for labs
+#define BME280_MODE_SLEEP    0x00U
+#define BME280_MODE_NORMAL   0x03U
+
+// Datasheet appendix B: maximum measurement time is 1.25 ms plus 2.3 ms per oversampling step,
+// and 0.575 ms more for each of pressure and humidity when enabled.
+#define BME280_MEAS_BASE_US  1250U
+#define BME280_MEAS_STEP_US  2300U
+#define BME280_MEAS_EXTRA_US 575U
+
+// Datasheet register map: a skipped measurement, or one that has not run since reset, reads back as
+// 0x80000 in the 20-bit temperature and pressure registers and as 0x8000 in the 16-bit humidity one.
+#define BME280_ADC_SKIPPED_20 0x80000
+#define BME280_ADC_SKIPPED_16 0x8000
 
 static bme280_status_t bme280_read_calibration(bme280_sensor_t *sensor);
+static bme280_status_t bme280_hal_status(HAL_StatusTypeDef status);
 static bme280_status_t bme280_write8(bme280_sensor_t *sensor, uint8_t reg, uint8_t value);
 static bme280_status_t bme280_read8(bme280_sensor_t *sensor, uint8_t reg, uint8_t *value);
 static bme280_status_t bme280_read_block(bme280_sensor_t *sensor, uint8_t reg, uint8_t *buf, uint16_t len);
+static bme280_status_t bme280_read_latest(bme280_sensor_t *sensor, bme280_reading_t *reading);
+static uint32_t bme280_oversampling_steps(bme280_oversampling_t osrs);
+static uint32_t bme280_measure_time_us(bme280_oversampling_t temperature, bme280_oversampling_t pressure, bme280_oversampling_t humidity);
+static void bme280_async_read(bme280_async_t *async);
+static void bme280_async_finish(bme280_async_t *async, bme280_status_t status);
 static float bme280_compensate_temperature(bme280_sensor_t *sensor, int32_t adc_T);
 static float bme280_compensate_pressure(const bme280_sensor_t *sensor, int32_t adc_P);
 static float bme280_compensate_humidity(const bme280_sensor_t *sensor, int32_t adc_H);
@@ -78,6 +97,7 @@ bme280_status_t BME280_Sensor_Begin(bme280_sensor_t *sensor)
     {
         return BME280_ERROR;
     }
+    sensor->measure_us = bme280_measure_time_us(BME280_OSRS_X1, BME280_OSRS_X1, BME280_OSRS_X1);
 
     return BME280_OK;
 }
@@ -89,6 +109,12 @@ bme280_status_t BME280_Sensor_Read(bme280_sensor_t *sensor, bme280_reading_t *re
         return BME280_ERROR;
     }
 
+    // Normal mode converts on its own; the data registers always hold the latest result.
+    if (sensor->normal_mode)
+    {
+        return bme280_read_latest(sensor, reading);
+    }
+
     // Kick off one forced conversion using the chosen oversampling.
     if (bme280_write8(sensor, BME280_REG_CTRL_MEAS, BME280_CTRL_MEAS_FORCED) != BME280_OK)
     {
@@ -115,9 +141,89 @@ bme280_status_t BME280_Sensor_Read(bme280_sensor_t *sensor, bme280_reading_t *re
         return BME280_TIMEOUT;
     }
 
-    // Read pressure (3 bytes), temperature (3 bytes), humidity (2 bytes) in one burst.
-    uint8_t raw[8] = {0};
-    if (bme280_read_block(sensor, BME280_REG_PRESS_MSB, raw, sizeof(raw)) != BME280_OK)
+    return bme280_read_latest(sensor, reading);
+}
+
+bme280_status_t BME280_Sensor_StartNormal(bme280_sensor_t *sensor, const bme280_normal_config_t *config)
+{
+    // Temperature cannot be skipped: pressure and humidity compensation depend on it.
+    if (sensor == NULL || sensor->hi2c == NULL || config == NULL || config->temperature == BME280_OSRS_SKIP)
+    {
+        return BME280_ERROR;
+    }
+
+    // The config register may ignore writes outside sleep mode, so stop any running cycle first.
+    if (bme280_write8(sensor, BME280_REG_CTRL_MEAS, BME280_MODE_SLEEP) != BME280_OK)
+    {
+        return BME280_ERROR;
+    }
+    sensor->normal_mode = 0U;
+
+    uint8_t config_val = (uint8_t)(((config->standby & 0x07U) << 5) | ((config->filter & 0x07U) << 2));
+    if (bme280_write8(sensor, BME280_REG_CONFIG, config_val) != BME280_OK)
+    {
+        return BME280_ERROR;
+    }
+    // ctrl_hum only takes effect with the next ctrl_meas write.
+    if (bme280_write8(sensor, BME280_REG_CTRL_HUM, (uint8_t)(config->humidity & 0x07U)) != BME280_OK)
+    {
+        return BME280_ERROR;
+    }
+    uint8_t ctrl_meas = (uint8_t)(((config->temperature & 0x07U) << 5) | ((config->pressure & 0x07U) << 2) | BME280_MODE_NORMAL);
+    if (bme280_write8(sensor, BME280_REG_CTRL_MEAS, ctrl_meas) != BME280_OK)
+    {
+        return BME280_ERROR;
+    }
+
+    static const uint32_t standby_us[8] = {500U, 62500U, 125000U, 250000U, 500000U, 1000000U, 10000U, 20000U};
+    sensor->measure_us = bme280_measure_time_us(config->temperature, config->pressure, config->humidity);
+    sensor->period_us = sensor->measure_us + standby_us[config->standby & 0x07U];
+    sensor->normal_mode = 1U;
+
+    return BME280_OK;
+}
+
+bme280_status_t BME280_Sensor_StopNormal(bme280_sensor_t *sensor)
+{
+    if (sensor == NULL || sensor->hi2c == NULL)
+    {
+        return BME280_ERROR;
+    }
+
+    sensor->normal_mode = 0U;
+    sensor->period_us = 0U;
+    sensor->measure_us = bme280_measure_time_us(BME280_OSRS_X1, BME280_OSRS_X1, BME280_OSRS_X1);
+
+    // Back to the state BME280_Sensor_Begin leaves: sleeping, no filter, humidity x1.
+    if (bme280_write8(sensor, BME280_REG_CTRL_MEAS, BME280_MODE_SLEEP) != BME280_OK)
+    {
+        return BME280_ERROR;
+    }
+    if (bme280_write8(sensor, BME280_REG_CONFIG, BME280_CONFIG_VAL) != BME280_OK)
+    {
+        return BME280_ERROR;
+    }
+    if (bme280_write8(sensor, BME280_REG_CTRL_HUM, BME280_CTRL_HUM_VAL) != BME280_OK)
+    {
+        return BME280_ERROR;
+    }
+
+    return BME280_OK;
+}
+
+uint32_t BME280_Sensor_GetPeriodUs(const bme280_sensor_t *sensor)
+{
+    return (sensor != NULL && sensor->normal_mode) ? sensor->period_us : 0U;
+}
+
+uint32_t BME280_Sensor_GetMeasureTimeUs(const bme280_sensor_t *sensor)
+{
+    return (sensor != NULL) ? sensor->measure_us : 0U;
+}
+
+bme280_status_t BME280_Sensor_Compensate(bme280_sensor_t *sensor, const uint8_t *raw, bme280_reading_t *reading)
+{
+    if (sensor == NULL || raw == NULL || reading == NULL)
     {
         return BME280_ERROR;
     }
@@ -126,6 +232,12 @@ bme280_status_t BME280_Sensor_Read(bme280_sensor_t *sensor, bme280_reading_t *re
     int32_t adc_T = ((int32_t)raw[3] << 12) | ((int32_t)raw[4] << 4) | ((int32_t)raw[5] >> 4);
     int32_t adc_H = ((int32_t)raw[6] << 8)  | ((int32_t)raw[7]);
 
+    // Temperature still holds its reset value until the first conversion completes.
+    if (sensor->normal_mode && adc_T == BME280_ADC_SKIPPED_20)
+    {
+        return BME280_BUSY;
+    }
+
     reading->temperature_c = bme280_compensate_temperature(sensor, adc_T);
     reading->pressure_pa   = bme280_compensate_pressure(sensor, adc_P);
     reading->humidity_rh   = bme280_compensate_humidity(sensor, adc_H);
@@ -133,6 +245,229 @@ bme280_status_t BME280_Sensor_Read(bme280_sensor_t *sensor, bme280_reading_t *re
     return BME280_OK;
 }
 
+// --- Non-blocking reads ---
+void BME280_Async_Init(bme280_async_t *async, bme280_sensor_t *sensor, uint8_t use_dma, bme280_async_callback_t callback, void *context)
+{
+    if (async == NULL)
+    {
+        return;
+    }
+
+    memset(async, 0, sizeof(*async));
+    async->sensor = sensor;
+    async->use_dma = use_dma;
+    async->timeout_ms = BME280_ASYNC_TIMEOUT_MS;
+    async->callback = callback;
+    async->context = context;
+}
+
+bme280_status_t BME280_Async_Start(bme280_async_t *async)
+{
+    if (async == NULL || async->sensor == NULL || async->sensor->hi2c == NULL)
+    {
+        return BME280_ERROR;
+    }
+    if (async->state != BME280_ASYNC_IDLE)
+    {
+        return BME280_BUSY;
+    }
+
+    async->started_ms = HAL_GetTick();
+
+    // Normal mode: the data registers already hold the latest conversion.
+    if (async->sensor->normal_mode)
+    {
+        bme280_async_read(async);
+        return BME280_OK;
+    }
+
+    // Forced mode: trigger first; the conversion wait starts when the write has completed.
+    async->ctrl_meas = BME280_CTRL_MEAS_FORCED;
+    async->state = BME280_ASYNC_TRIGGER;
+    if (HAL_I2C_Mem_Write_IT(async->sensor->hi2c, async->sensor->i2c_address, BME280_REG_CTRL_MEAS, I2C_MEMADD_SIZE_8BIT,
+                             &async->ctrl_meas, 1U) != HAL_OK)
+    {
+        async->state = BME280_ASYNC_IDLE;
+        return BME280_ERROR;
+    }
+
+    return BME280_OK;
+}
+
+void BME280_Async_Poll(bme280_async_t *async)
+{
+    if (async == NULL || async->state == BME280_ASYNC_IDLE)
+    {
+        return;
+    }
+
+    // Claim an expired read with interrupts off, so a completion arriving at the same moment
+    // cannot report the read a second time.
+    uint32_t now = HAL_GetTick();
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bme280_async_state_t state = async->state;
+    uint8_t expired = (state != BME280_ASYNC_IDLE && (now - async->started_ms) >= async->timeout_ms) ? 1U : 0U;
+    if (expired)
+    {
+        async->state = BME280_ASYNC_IDLE;
+    }
+    __set_PRIMASK(primask);
+
+    if (expired)
+    {
+        if (state != BME280_ASYNC_CONVERTING)
+        {
+            // A transfer is still pending on a stuck bus: reset the peripheral to drop it.
+            HAL_I2C_DeInit(async->sensor->hi2c);
+            HAL_I2C_Init(async->sensor->hi2c);
+        }
+        bme280_async_finish(async, BME280_TIMEOUT);
+        return;
+    }
+
+    if (state == BME280_ASYNC_CONVERTING && (now - async->converting_ms) >= async->wait_ms)
+    {
+        bme280_async_read(async);
+    }
+}
+
+uint8_t BME280_Async_IsBusy(const bme280_async_t *async)
+{
+    return (async != NULL && async->state != BME280_ASYNC_IDLE) ? 1U : 0U;
+}
+
+void BME280_Async_HandleTxComplete(bme280_async_t *async, I2C_HandleTypeDef *hi2c)
+{
+    if (async == NULL || async->sensor == NULL || async->sensor->hi2c != hi2c || async->state != BME280_ASYNC_TRIGGER)
+    {
+        return;
+    }
+
+    // Round the datasheet maximum up to whole ticks, plus one because the current tick is partly over.
+    async->wait_ms = (async->sensor->measure_us + 999U) / 1000U + 1U;
+    async->converting_ms = HAL_GetTick();
+    async->state = BME280_ASYNC_CONVERTING;
+}
+
+void BME280_Async_HandleRxComplete(bme280_async_t *async, I2C_HandleTypeDef *hi2c)
+{
+    if (async == NULL || async->sensor == NULL || async->sensor->hi2c != hi2c || async->state != BME280_ASYNC_READING)
+    {
+        return;
+    }
+
+    async->state = BME280_ASYNC_IDLE;
+    bme280_async_finish(async, BME280_Sensor_Compensate(async->sensor, async->raw, &async->reading));
+}
+
+void BME280_Async_HandleError(bme280_async_t *async, I2C_HandleTypeDef *hi2c)
+{
+    if (async == NULL || async->sensor == NULL || async->sensor->hi2c != hi2c)
+    {
+        return;
+    }
+    if (async->state != BME280_ASYNC_TRIGGER && async->state != BME280_ASYNC_READING)
+    {
+        return;
+    }
+
+    async->state = BME280_ASYNC_IDLE;
+    bme280_async_finish(async, BME280_ERROR);
+}
+
+void BME280_Async_GetStats(const bme280_async_t *async, bme280_async_stats_t *stats)
+{
+    if (async == NULL || stats == NULL)
+    {
+        return;
+    }
+
+    *stats = async->stats;
+}
+
+// Read pressure (3 bytes), temperature (3 bytes), humidity (2 bytes) in one burst. The sensor
+// shadows the data registers during a burst read, so all three belong to the same conversion.
+static bme280_status_t bme280_read_latest(bme280_sensor_t *sensor, bme280_reading_t *reading)
+{
+    uint8_t raw[BME280_DATA_LEN] = {0};
+    bme280_status_t status = bme280_read_block(sensor, BME280_REG_PRESS_MSB, raw, sizeof(raw));
+    if (status != BME280_OK)
+    {
+        return status;
+    }
+
+    return BME280_Sensor_Compensate(sensor, raw, reading);
+}
+
+// Oversampling x1..x16 as a count of samples; SKIP takes none.
+static uint32_t bme280_oversampling_steps(bme280_oversampling_t osrs)
+{
+    return (osrs == BME280_OSRS_SKIP) ? 0U : (1UL << ((osrs > BME280_OSRS_X16 ? BME280_OSRS_X16 : osrs) - 1U));
+}
+
+static uint32_t bme280_measure_time_us(bme280_oversampling_t temperature, bme280_oversampling_t pressure, bme280_oversampling_t humidity)
+{
+    uint32_t measure_us = BME280_MEAS_BASE_US + BME280_MEAS_STEP_US * bme280_oversampling_steps(temperature);
+    if (pressure != BME280_OSRS_SKIP)
+    {
+        measure_us += BME280_MEAS_STEP_US * bme280_oversampling_steps(pressure) + BME280_MEAS_EXTRA_US;
+    }
+    if (humidity != BME280_OSRS_SKIP)
+    {
+        measure_us += BME280_MEAS_STEP_US * bme280_oversampling_steps(humidity) + BME280_MEAS_EXTRA_US;
+    }
+    return measure_us;
+}
+
+// Start the data burst; a refused start ends the read at once.
+static void bme280_async_read(bme280_async_t *async)
+{
+    bme280_sensor_t *sensor = async->sensor;
+    HAL_StatusTypeDef status;
+
+    async->state = BME280_ASYNC_READING;
+    if (async->use_dma)
+    {
+        status = HAL_I2C_Mem_Read_DMA(sensor->hi2c, sensor->i2c_address, BME280_REG_PRESS_MSB, I2C_MEMADD_SIZE_8BIT, async->raw,
+                                      BME280_DATA_LEN);
+    }
+    else
+    {
+        status = HAL_I2C_Mem_Read_IT(sensor->hi2c, sensor->i2c_address, BME280_REG_PRESS_MSB, I2C_MEMADD_SIZE_8BIT, async->raw,
+                                     BME280_DATA_LEN);
+    }
+
+    if (status != HAL_OK)
+    {
+        async->state = BME280_ASYNC_IDLE;
+        bme280_async_finish(async, BME280_ERROR);
+    }
+}
+
+// Count the outcome and hand it to the application. The state is already idle, so the callback
+// may start the next read.
+static void bme280_async_finish(bme280_async_t *async, bme280_status_t status)
+{
+    if (status == BME280_OK)
+    {
+        async->stats.completed++;
+    }
+    else if (status == BME280_TIMEOUT)
+    {
+        async->stats.timeouts++;
+    }
+    else if (status == BME280_ERROR)
+    {
+        async->stats.errors++;
+    }
+
+    if (async->callback != NULL)
+    {
+        async->callback(status, (status == BME280_OK) ? &async->reading : NULL, async->context);
+    }
+}
+
 // --- Low-level helpers ---
 static bme280_status_t bme280_read_calibration(bme280_sensor_t *sensor)
 {
@@ -171,31 +506,38 @@ static bme280_status_t bme280_read_calibration(bme280_sensor_t *sensor)
     return BME280_OK;
 }
 
+// Blocking transfers are bounded by BME280_I2C_TIMEOUT_MS so a stuck bus cannot hang the caller.
+static bme280_status_t bme280_hal_status(HAL_StatusTypeDef status)
+{
+    if (status == HAL_OK)
+    {
+        return BME280_OK;
+    }
+    return (status == HAL_TIMEOUT) ? BME280_TIMEOUT : BME280_ERROR;
+}
+
 static bme280_status_t bme280_write8(bme280_sensor_t *sensor, uint8_t reg, uint8_t value)
 {
-    return (HAL_I2C_Mem_Write(sensor->hi2c, sensor->i2c_address, reg, I2C_MEMADD_SIZE_8BIT, &value, 1U, HAL_MAX_DELAY) == HAL_OK)
-               ? BME280_OK
-               : BME280_ERROR;
+    return bme280_hal_status(HAL_I2C_Mem_Write(sensor->hi2c, sensor->i2c_address, reg, I2C_MEMADD_SIZE_8BIT, &value, 1U,
+                                               BME280_I2C_TIMEOUT_MS));
 }
 
 static bme280_status_t bme280_read8(bme280_sensor_t *sensor, uint8_t reg, uint8_t *value)
 {
-    return (HAL_I2C_Mem_Read(sensor->hi2c, sensor->i2c_address, reg, I2C_MEMADD_SIZE_8BIT, value, 1U, HAL_MAX_DELAY) == HAL_OK)
-               ? BME280_OK
-               : BME280_ERROR;
+    return bme280_hal_status(HAL_I2C_Mem_Read(sensor->hi2c, sensor->i2c_address, reg, I2C_MEMADD_SIZE_8BIT, value, 1U,
+                                              BME280_I2C_TIMEOUT_MS));
 }
 
 static bme280_status_t bme280_read_block(bme280_sensor_t *sensor, uint8_t reg, uint8_t *buf, uint16_t len)
 {
-    return (HAL_I2C_Mem_Read(sensor->hi2c, sensor->i2c_address, reg, I2C_MEMADD_SIZE_8BIT, buf, len, HAL_MAX_DELAY) == HAL_OK)
-               ? BME280_OK
-               : BME280_ERROR;
+    return bme280_hal_status(HAL_I2C_Mem_Read(sensor->hi2c, sensor->i2c_address, reg, I2C_MEMADD_SIZE_8BIT, buf, len,
+                                              BME280_I2C_TIMEOUT_MS));
 }
 
 // --- Compensation formulas from datasheet section 4.2.3 ---
 static float bme280_compensate_temperature(bme280_sensor_t *sensor, int32_t adc_T)
 {
-    if (adc_T == 0x800000)
+    if (adc_T == BME280_ADC_SKIPPED_20)
     {
         return 0.0f;
     }
@@ -211,9 +553,9 @@ static float bme280_compensate_temperature(bme280_sensor_t *sensor, int32_t adc_
 
 static float bme280_compensate_pressure(const bme280_sensor_t *sensor, int32_t adc_P)
 {
-    if (adc_P == 0x800000)
+    if (adc_P == BME280_ADC_SKIPPED_20)
     {
-        return 0.0f;
+        return 0.0f; // Pressure oversampling is BME280_OSRS_SKIP.
     }
 
     float var1 = (sensor->t_fine / 2.0f) - 64000.0f;
@@ -239,6 +581,11 @@ static float bme280_compensate_pressure(const bme280_sensor_t *sensor, int32_t a
 
 static float bme280_compensate_humidity(const bme280_sensor_t *sensor, int32_t adc_H)
 {
+    if (adc_H == BME280_ADC_SKIPPED_16)
+    {
+        return 0.0f; // Humidity oversampling is BME280_OSRS_SKIP.
+    }
+
     float var1 = ((float)sensor->t_fine) - 76800.0f;
     float var2 = (sensor->calib.dig_H4 * 64.0f) + ((sensor->calib.dig_H5 / 16384.0f) * var1);
     float var3 = adc_H - var2;
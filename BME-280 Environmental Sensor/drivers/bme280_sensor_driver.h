@@ -8,13 +8,64 @@
 #define BME280_I2C_ADDR_LOW  (0x76U << 1) // Shifted for HAL 8-bit addressing.
 #define BME280_I2C_ADDR_HIGH (0x77U << 1)
 
+#define BME280_DATA_LEN 8U             // Pressure, temperature and humidity burst starting at 0xF7.
+#ifndef BME280_I2C_TIMEOUT_MS
+    #define BME280_I2C_TIMEOUT_MS 25U  // Bound for each blocking transfer; an 8-byte burst at 100 kHz takes about 1 ms.
+#endif
+#define BME280_ASYNC_TIMEOUT_MS 100U   // Default limit for a whole non-blocking read, trigger to data.
+
 typedef enum
 {
     BME280_OK = 0,
     BME280_ERROR,
-    BME280_TIMEOUT
+    BME280_TIMEOUT,
+    BME280_BUSY     // Normal mode: the first conversion has not finished yet.
 } bme280_status_t;
 
+// Oversampling field values for ctrl_hum and ctrl_meas. SKIP turns that measurement off.
+typedef enum
+{
+    BME280_OSRS_SKIP = 0,
+    BME280_OSRS_X1,
+    BME280_OSRS_X2,
+    BME280_OSRS_X4,
+    BME280_OSRS_X8,
+    BME280_OSRS_X16
+} bme280_oversampling_t;
+
+// IIR filter coefficient (config bits 4:2). Higher values smooth out short disturbances such as
+// a door slam, at the cost of a slower step response.
+typedef enum
+{
+    BME280_FILTER_OFF = 0,
+    BME280_FILTER_2,
+    BME280_FILTER_4,
+    BME280_FILTER_8,
+    BME280_FILTER_16
+} bme280_filter_t;
+
+// Inactive time between two normal-mode conversions (config bits 7:5, t_sb).
+typedef enum
+{
+    BME280_STANDBY_0_5MS = 0,
+    BME280_STANDBY_62_5MS,
+    BME280_STANDBY_125MS,
+    BME280_STANDBY_250MS,
+    BME280_STANDBY_500MS,
+    BME280_STANDBY_1000MS,
+    BME280_STANDBY_10MS,
+    BME280_STANDBY_20MS
+} bme280_standby_t;
+
+typedef struct
+{
+    bme280_oversampling_t temperature;
+    bme280_oversampling_t pressure;
+    bme280_oversampling_t humidity;
+    bme280_filter_t filter;
+    bme280_standby_t standby;
+} bme280_normal_config_t;
+
 // Calibration constants read from the device to convert raw counts to compensated values.
 typedef struct
 {
@@ -45,13 +96,16 @@ typedef struct
     uint8_t i2c_address;
     bme280_calibration_t calib;
     int32_t t_fine; // Shared temp compensation term reused by pressure/humidity.
+    uint8_t normal_mode; // Set by BME280_Sensor_StartNormal; reads then skip the trigger and the status poll.
+    uint32_t period_us;  // Normal mode: time between two conversions (measurement plus standby).
+    uint32_t measure_us; // Datasheet maximum conversion time for the current oversampling.
 } bme280_sensor_t;
 
 typedef struct
 {
     float temperature_c; // Degrees Celsius.
-    float humidity_rh;   // % relative humidity (0-100).
-    float pressure_pa;   // Pascals.
+    float humidity_rh;   // % relative humidity (0-100); 0 when humidity oversampling is BME280_OSRS_SKIP.
+    float pressure_pa;   // Pascals; 0 when pressure oversampling is BME280_OSRS_SKIP.
 } bme280_reading_t;
 
 // Bind the HAL I2C handle and I2C address (0x76 or 0x77). Does not talk to hardware yet.
@@ -61,7 +115,83 @@ void BME280_Sensor_Init(bme280_sensor_t *sensor, I2C_HandleTypeDef *hi2c, uint8_
 bme280_status_t BME280_Sensor_Begin(bme280_sensor_t *sensor);
 
 // Trigger one forced measurement and fill the reading struct with compensated values.
+// In normal mode it only fetches the latest conversion: one 8-byte burst, no trigger or polling.
 bme280_status_t BME280_Sensor_Read(bme280_sensor_t *sensor, bme280_reading_t *reading);
 
+// Program oversampling, IIR filter and standby once and let the sensor convert on its own.
+// Call after BME280_Sensor_Begin. A new result is ready every BME280_Sensor_GetPeriodUs.
+bme280_status_t BME280_Sensor_StartNormal(bme280_sensor_t *sensor, const bme280_normal_config_t *config);
+
+// Put the sensor back to sleep with the forced-mode settings from BME280_Sensor_Begin.
+bme280_status_t BME280_Sensor_StopNormal(bme280_sensor_t *sensor);
+
+// Normal-mode output period in microseconds (maximum measurement time plus t_sb); 0 in forced mode.
+uint32_t BME280_Sensor_GetPeriodUs(const bme280_sensor_t *sensor);
+
+// Maximum time one conversion takes with the current oversampling, in microseconds.
+uint32_t BME280_Sensor_GetMeasureTimeUs(const bme280_sensor_t *sensor);
+
+// Convert a BME280_DATA_LEN burst from 0xF7 into compensated values. Skipped fields read as 0.
+bme280_status_t BME280_Sensor_Compensate(bme280_sensor_t *sensor, const uint8_t *raw, bme280_reading_t *reading);
+
+// --- Non-blocking reads ---
+// A read runs as a small state machine: trigger (forced mode only), wait for the conversion,
+// burst-read with IT or DMA, compensate in the completion interrupt, then call the callback.
+typedef enum
+{
+    BME280_ASYNC_IDLE = 0,
+    BME280_ASYNC_TRIGGER,    // ctrl_meas write in flight.
+    BME280_ASYNC_CONVERTING, // Waiting out the measurement time.
+    BME280_ASYNC_READING     // Data burst in flight.
+} bme280_async_state_t;
+
+// Runs in interrupt context when the read completes; reading is NULL unless status is BME280_OK.
+typedef void (*bme280_async_callback_t)(bme280_status_t status, const bme280_reading_t *reading, void *context);
+
+typedef struct
+{
+    uint32_t completed;
+    uint32_t errors;   // Bus errors or refused transfers.
+    uint32_t timeouts; // Reads that did not finish within timeout_ms.
+} bme280_async_stats_t;
+
+typedef struct
+{
+    bme280_sensor_t *sensor;
+    uint8_t use_dma;                     // 1 reads the burst with DMA, 0 with interrupts.
+    uint32_t timeout_ms;                 // Whole read, from BME280_Async_Start to the data.
+    bme280_async_callback_t callback;
+    void *context;
+
+    volatile bme280_async_state_t state;
+    uint8_t ctrl_meas;                   // Trigger byte; must stay valid while the IT write runs.
+    uint8_t raw[BME280_DATA_LEN];
+    uint32_t started_ms;
+    uint32_t converting_ms;              // Tick when the trigger write completed.
+    uint32_t wait_ms;
+    bme280_reading_t reading;
+    bme280_async_stats_t stats;
+} bme280_async_t;
+
+// Bind a sensor that has been through BME280_Sensor_Begin (and optionally StartNormal).
+void BME280_Async_Init(bme280_async_t *async, bme280_sensor_t *sensor, uint8_t use_dma, bme280_async_callback_t callback, void *context);
+
+// Start one read. Returns BME280_BUSY while the previous one is still running.
+bme280_status_t BME280_Async_Start(bme280_async_t *async);
+
+// Starts the burst once the conversion time has passed and ends reads that overran timeout_ms.
+// Call it from the main loop or a 1 ms timer interrupt.
+void BME280_Async_Poll(bme280_async_t *async);
+
+uint8_t BME280_Async_IsBusy(const bme280_async_t *async);
+
+// Call from HAL_I2C_MemTxCpltCallback, HAL_I2C_MemRxCpltCallback and HAL_I2C_ErrorCallback.
+// Events for other I2C handles are ignored, so several sensors can share the callbacks.
+void BME280_Async_HandleTxComplete(bme280_async_t *async, I2C_HandleTypeDef *hi2c);
+void BME280_Async_HandleRxComplete(bme280_async_t *async, I2C_HandleTypeDef *hi2c);
+void BME280_Async_HandleError(bme280_async_t *async, I2C_HandleTypeDef *hi2c);
+
+void BME280_Async_GetStats(const bme280_async_t *async, bme280_async_stats_t *stats);
+
 
 #endif /* BME280_SENSOR_DRIVER_H */
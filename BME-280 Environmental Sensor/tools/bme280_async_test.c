@@ -0,0 +1,334 @@
+// Host-side checks for the non-blocking BME280 reads, run against the mock I2C bus in
+// mock_i2c_bus.c instead of a sensor. Build from this directory:
+//
+//     gcc -std=c11 -Ihost -I../drivers bme280_async_test.c mock_i2c_bus.c ../drivers/bme280_sensor_driver.c -o bme280_async_test
+//     ./bme280_async_test          (-v prints every bus transfer)
+//
+// Each case drives BME280_Async_Start()/BME280_Async_Poll() one tick at a time, the way a 1 ms
+// timer would, and prints "ok" or "FAIL" per check. The exit status is the number of failures.
+
+#include <stdio.h>
+#include <string.h>
+#include "bme280_sensor_driver.h"
+#include "mock_i2c_bus.h"
+
+typedef struct
+{
+    uint32_t calls;
+    bme280_status_t status;
+    bme280_reading_t reading;
+    uint32_t tick;
+    uint32_t restarts;       // Reads the callback should start back to back.
+} test_result_t;
+
+static I2C_HandleTypeDef test_bus = {(void *)1};
+static I2C_HandleTypeDef test_other_bus = {(void *)2};
+static bme280_sensor_t test_sensor;
+static bme280_async_t test_async;
+static test_result_t test_result;
+static uint8_t test_verbose;
+static int test_failures;
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    BME280_Async_HandleTxComplete(&test_async, hi2c);
+}
+
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    BME280_Async_HandleRxComplete(&test_async, hi2c);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    BME280_Async_HandleError(&test_async, hi2c);
+}
+
+static void on_reading(bme280_status_t status, const bme280_reading_t *reading, void *context)
+{
+    (void)context;
+    test_result.calls++;
+    test_result.status = status;
+    test_result.tick = HAL_GetTick();
+    if (reading != NULL)
+    {
+        test_result.reading = *reading;
+    }
+    if (test_result.restarts > 0U)
+    {
+        test_result.restarts--;
+        BME280_Async_Start(&test_async);
+    }
+}
+
+static void check(int ok, const char *what)
+{
+    printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        test_failures++;
+    }
+}
+
+static void begin_case(const char *name, uint8_t use_dma)
+{
+    printf("%s\n", name);
+    Mock_I2C_Reset(&test_bus, test_verbose);
+    BME280_Sensor_Init(&test_sensor, &test_bus, BME280_I2C_ADDR_LOW);
+    if (BME280_Sensor_Begin(&test_sensor) != BME280_OK)
+    {
+        check(0, "BME280_Sensor_Begin");
+    }
+    BME280_Async_Init(&test_async, &test_sensor, use_dma, on_reading, NULL);
+    memset(&test_result, 0, sizeof(test_result));
+}
+
+// One timer tick: the bus interrupts that are due, then the driver's poll.
+static void run(uint32_t ticks)
+{
+    for (uint32_t i = 0; i < ticks; i++)
+    {
+        Mock_I2C_Step();
+        BME280_Async_Poll(&test_async);
+        if (mock_primask != 0U)
+        {
+            check(0, "BME280_Async_Poll left interrupts disabled");
+            mock_primask = 0U;
+        }
+    }
+}
+
+static int reading_matches(void)
+{
+    return test_result.reading.temperature_c > 25.07f && test_result.reading.temperature_c < 25.09f &&
+           test_result.reading.pressure_pa > 100650.0f && test_result.reading.pressure_pa < 100660.0f &&
+           test_result.reading.humidity_rh >= 0.0f && test_result.reading.humidity_rh <= 100.0f;
+}
+
+static void test_forced_read(uint8_t use_dma)
+{
+    begin_case(use_dma ? "forced read, DMA" : "forced read, IT", use_dma);
+    uint32_t start = HAL_GetTick();
+    check(BME280_Async_Start(&test_async) == BME280_OK, "start writes the trigger");
+    check(BME280_Async_Start(&test_async) == BME280_BUSY, "a second start while busy returns BME280_BUSY");
+    run(30);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    check(test_result.calls == 1U && test_result.status == BME280_OK, "one callback with BME280_OK");
+    check(reading_matches(), "compensated values match the sample");
+    check(bus.triggers == 1U && bus.transfers == 2U, "one trigger write and one data read");
+    check(bus.early_reads == 0U, "the data read waits for the conversion to finish");
+    check(test_result.tick - start <= 15U, "read finishes within 15 ms at x1 oversampling");
+    check(!BME280_Async_IsBusy(&test_async), "idle afterwards");
+    if (test_verbose)
+    {
+        printf("    T=%.2f C P=%.0f Pa H=%.1f %%, read started %lu ms after the trigger, callback at %lu ms\n",
+               (double)test_result.reading.temperature_c, (double)test_result.reading.pressure_pa,
+               (double)test_result.reading.humidity_rh, (unsigned long)(bus.read_tick - bus.trigger_tick),
+               (unsigned long)(test_result.tick - start));
+    }
+}
+
+static void test_normal_mode(void)
+{
+    begin_case("normal mode, DMA", 1U);
+    bme280_normal_config_t config = {BME280_OSRS_X1, BME280_OSRS_X1, BME280_OSRS_X1, BME280_FILTER_4, BME280_STANDBY_0_5MS};
+    check(BME280_Sensor_StartNormal(&test_sensor, &config) == BME280_OK, "start normal mode");
+
+    BME280_Async_Start(&test_async);
+    run(3);
+    check(test_result.calls == 1U && test_result.status == BME280_BUSY, "before the first conversion: BME280_BUSY");
+
+    run(20);
+    test_result.calls = 0U;
+    BME280_Async_Start(&test_async);
+    run(3);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    check(test_result.calls == 1U && test_result.status == BME280_OK && reading_matches(), "after it: the sample, at once");
+    check(bus.triggers == 0U, "no trigger writes");
+}
+
+static void test_skipped_fields(void)
+{
+    begin_case("normal mode, pressure and humidity skipped", 1U);
+    bme280_normal_config_t config = {BME280_OSRS_X1, BME280_OSRS_SKIP, BME280_OSRS_SKIP, BME280_FILTER_OFF, BME280_STANDBY_0_5MS};
+    check(BME280_Sensor_StartNormal(&test_sensor, &config) == BME280_OK, "start normal mode");
+    run(10);
+    BME280_Async_Start(&test_async);
+    run(3);
+    check(test_result.calls == 1U && test_result.status == BME280_OK, "one callback with BME280_OK");
+    check(test_result.reading.temperature_c > 25.07f && test_result.reading.temperature_c < 25.09f, "temperature is compensated");
+    check(test_result.reading.pressure_pa == 0.0f, "skipped pressure (0x80000) reads as 0");
+    check(test_result.reading.humidity_rh == 0.0f, "skipped humidity (0x8000) reads as 0");
+}
+
+static void test_back_to_back(void)
+{
+    begin_case("back-to-back reads from the callback", 0U);
+    test_result.restarts = 2U;
+    BME280_Async_Start(&test_async);
+    run(60);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    bme280_async_stats_t stats;
+    BME280_Async_GetStats(&test_async, &stats);
+    check(test_result.calls == 3U && stats.completed == 3U, "three reads complete");
+    check(bus.triggers == 3U && bus.early_reads == 0U, "each one triggers and waits for its conversion");
+}
+
+static void test_hung_read(void)
+{
+    begin_case("hung data read", 0U);
+    uint32_t start = HAL_GetTick();
+    BME280_Async_Start(&test_async);
+    run(1);
+    Mock_I2C_FailNext(MOCK_I2C_FAULT_HANG);
+    run(150);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    check(test_result.calls == 1U && test_result.status == BME280_TIMEOUT, "one callback with BME280_TIMEOUT");
+    check(test_result.tick - start == BME280_ASYNC_TIMEOUT_MS, "after exactly timeout_ms");
+    check(bus.deinits == 1U && bus.inits == 1U && bus.dropped == 1U, "the peripheral is reset with DeInit/Init");
+
+    Mock_I2C_Raise(MOCK_I2C_EVENT_RX, &test_bus);
+    Mock_I2C_Raise(MOCK_I2C_EVENT_ERROR, &test_bus);
+    bme280_async_stats_t stats;
+    BME280_Async_GetStats(&test_async, &stats);
+    check(test_result.calls == 1U && stats.completed == 0U && stats.errors == 0U, "late completion and error are ignored");
+
+    BME280_Async_Start(&test_async);
+    run(30);
+    check(test_result.calls == 2U && test_result.status == BME280_OK, "the next read works");
+}
+
+static void test_hung_trigger(void)
+{
+    begin_case("hung trigger write", 0U);
+    Mock_I2C_FailNext(MOCK_I2C_FAULT_HANG);
+    BME280_Async_Start(&test_async);
+    run(150);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    check(test_result.calls == 1U && test_result.status == BME280_TIMEOUT, "one callback with BME280_TIMEOUT");
+    check(bus.deinits == 1U && bus.inits == 1U && bus.dropped == 1U, "the peripheral is reset with DeInit/Init");
+}
+
+static void test_timeout_converting(void)
+{
+    begin_case("timeout while converting", 0U);
+    test_async.timeout_ms = 5U;
+    BME280_Async_Start(&test_async);
+    run(30);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    check(test_result.calls == 1U && test_result.status == BME280_TIMEOUT, "one callback with BME280_TIMEOUT");
+    check(bus.deinits == 0U && bus.transfers == 1U, "no transfer pending, so no bus reset and no data read");
+}
+
+static void test_timeout_race(void)
+{
+    begin_case("read completing on the timeout tick", 0U);
+    uint32_t start = HAL_GetTick();
+    test_async.timeout_ms = 13U; // Trigger done at +1, data read at +12, complete at +13.
+    BME280_Async_Start(&test_async);
+    run(30);
+    check(test_result.calls == 1U && test_result.status == BME280_OK && test_result.tick - start == 13U,
+          "the completion interrupt runs before the poll and wins");
+
+    begin_case("read completing one tick after the timeout", 0U);
+    start = HAL_GetTick();
+    test_async.timeout_ms = 13U;
+    BME280_Async_Start(&test_async);
+    run(1);
+    Mock_I2C_SetLatency(2U);
+    run(30);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    check(test_result.calls == 1U && test_result.status == BME280_TIMEOUT && test_result.tick - start == 13U,
+          "the poll times out first");
+    check(bus.dropped == 1U && !Mock_I2C_IsPending(), "the transfer is dropped, so no completion follows");
+}
+
+static void test_refused(void)
+{
+    begin_case("refused transfers", 0U);
+    Mock_I2C_FailNext(MOCK_I2C_FAULT_REFUSE);
+    check(BME280_Async_Start(&test_async) == BME280_ERROR, "a refused trigger fails the start");
+    check(!BME280_Async_IsBusy(&test_async) && test_result.calls == 0U, "no read in flight, no callback");
+
+    BME280_Async_Start(&test_async);
+    run(1);
+    Mock_I2C_FailNext(MOCK_I2C_FAULT_REFUSE);
+    run(30);
+    bme280_async_stats_t stats;
+    BME280_Async_GetStats(&test_async, &stats);
+    check(test_result.calls == 1U && test_result.status == BME280_ERROR && stats.errors == 1U, "a refused data read: BME280_ERROR");
+}
+
+static void test_errors(void)
+{
+    begin_case("bus errors", 1U);
+    BME280_Async_Start(&test_async);
+    run(1);
+    Mock_I2C_FailNext(MOCK_I2C_FAULT_NACK);
+    run(30);
+    check(test_result.calls == 1U && test_result.status == BME280_ERROR, "a NACKed data read: BME280_ERROR");
+    Mock_I2C_Raise(MOCK_I2C_EVENT_ERROR, &test_bus);
+    bme280_async_stats_t stats;
+    BME280_Async_GetStats(&test_async, &stats);
+    check(test_result.calls == 1U && stats.errors == 1U, "a second error interrupt is ignored");
+
+    test_result.calls = 0U;
+    BME280_Async_Start(&test_async);
+    run(3);
+    Mock_I2C_Raise(MOCK_I2C_EVENT_ERROR, &test_bus);
+    check(BME280_Async_IsBusy(&test_async) && test_result.calls == 0U, "an error while converting is not ours: ignored");
+    run(30);
+    check(test_result.calls == 1U && test_result.status == BME280_OK, "the read still completes");
+}
+
+static void test_other_handle(void)
+{
+    begin_case("events from another I2C handle", 0U);
+    BME280_Async_Start(&test_async);
+    Mock_I2C_Raise(MOCK_I2C_EVENT_TX, &test_other_bus);
+    Mock_I2C_Raise(MOCK_I2C_EVENT_ERROR, &test_other_bus);
+    run(12); // The data read is in flight now.
+    Mock_I2C_Raise(MOCK_I2C_EVENT_RX, &test_other_bus);
+    Mock_I2C_Raise(MOCK_I2C_EVENT_ERROR, &test_other_bus);
+    check(test_result.calls == 0U && Mock_I2C_IsPending(), "ignored during the trigger and the data read");
+    run(10);
+
+    mock_i2c_stats_t bus;
+    Mock_I2C_GetStats(&bus);
+    check(test_result.calls == 1U && test_result.status == BME280_OK && bus.early_reads == 0U, "the read completes normally");
+}
+
+int main(int argc, char **argv)
+{
+    test_verbose = (argc > 1 && strcmp(argv[1], "-v") == 0) ? 1U : 0U;
+
+    test_forced_read(0U);
+    test_forced_read(1U);
+    test_normal_mode();
+    test_skipped_fields();
+    test_back_to_back();
+    test_hung_read();
+    test_hung_trigger();
+    test_timeout_converting();
+    test_timeout_race();
+    test_refused();
+    test_errors();
+    test_other_handle();
+
+    printf("%d failure%s\n", test_failures, (test_failures == 1) ? "" : "s");
+    return test_failures;
+}
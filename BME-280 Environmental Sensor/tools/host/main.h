@@ -0,0 +1,68 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+// Stand-in for the CubeMX main.h when the driver is built on a PC (see ../mock_i2c_bus.h).
+// Only the part of the HAL the driver uses is declared; mock_i2c_bus.c implements it for one I2C bus.
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+#define I2C_MEMADD_SIZE_8BIT 0x00000001U
+
+typedef struct
+{
+    void *Instance;
+} I2C_HandleTypeDef;
+
+// Simulated milliseconds. Time only moves in Mock_I2C_Step() and HAL_Delay().
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                    uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                   uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                       uint16_t size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                      uint16_t size);
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                       uint16_t size);
+
+// Implemented by the application, as in the firmware; the mock bus calls them as interrupts would.
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+
+// The mock bus only raises its interrupts from Mock_I2C_Step()/Mock_I2C_Raise(), never inside a
+// driver call, so masking has nothing to do. The mask state is still tracked so a test can check
+// that the driver restores it.
+extern uint32_t mock_primask;
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return mock_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+    mock_primask = primask;
+}
+
+static inline void __disable_irq(void)
+{
+    mock_primask = 1U;
+}
+
+#endif
@@ -0,0 +1,393 @@
+#include "mock_i2c_bus.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MOCK_REG_CALIB_T_P   0x88U
+#define MOCK_REG_CALIB_H2    0xE1U
+#define MOCK_REG_ID          0xD0U
+#define MOCK_REG_CTRL_HUM    0xF2U
+#define MOCK_REG_STATUS      0xF3U
+#define MOCK_REG_CTRL_MEAS   0xF4U
+#define MOCK_REG_DATA        0xF7U
+#define MOCK_DATA_LEN        8U
+#define MOCK_NEVER           0xFFFFFFFFU
+
+typedef struct
+{
+    uint8_t active;
+    uint8_t is_read;
+    mock_i2c_fault_t fault;
+    uint32_t due_tick;
+    I2C_HandleTypeDef *hi2c;
+    uint16_t reg;
+    uint8_t *data;
+    uint16_t size;
+    uint8_t bytes[32];       // Write data, or the registers as they were when the read started.
+} mock_transfer_t;
+
+uint32_t mock_primask;
+
+static uint32_t mock_tick;
+static uint8_t mock_regs[256];
+static I2C_HandleTypeDef *mock_bus;
+static uint8_t mock_verbose;
+static uint8_t mock_ready;
+static uint32_t mock_latency_ms;
+static mock_i2c_fault_t mock_next_fault;
+static mock_transfer_t mock_pending;
+static uint8_t mock_converting;
+static uint32_t mock_conversion_end;
+static mock_i2c_stats_t mock_stats;
+
+// A calibration set and raw sample from a real sensor: 25.08 C and 100655 Pa. dig_H1 is the last
+// byte of the first block (0xA1).
+static const uint8_t mock_calib_t_p[26] = {0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27,
+                                           0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17, 0x00, 0x4B};
+static const uint8_t mock_calib_h[7] = {0x6A, 0x01, 0x00, 0x13, 0x2C, 0x03, 0x1E};
+static const uint8_t mock_sample[MOCK_DATA_LEN] = {0x65, 0x5A, 0x00, 0x7E, 0xED, 0x00, 0x6F, 0x2F};
+static const uint8_t mock_reset_data[MOCK_DATA_LEN] = {0x80, 0x00, 0x00, 0x80, 0x00, 0x00, 0x80, 0x00};
+
+static void mock_trace(const char *format, ...)
+{
+    if (mock_verbose)
+    {
+        va_list args;
+        va_start(args, format);
+        printf("    %5lu ms  ", (unsigned long)mock_tick);
+        vprintf(format, args);
+        printf("\n");
+        va_end(args);
+    }
+}
+
+static uint32_t mock_oversampling(uint8_t field)
+{
+    static const uint8_t samples[8] = {0, 1, 2, 4, 8, 16, 16, 16};
+    return samples[field & 0x07U];
+}
+
+// Datasheet section 9.1, maximum measurement time, rounded up to whole ticks.
+static uint32_t mock_conversion_ticks(void)
+{
+    uint32_t osrs_t = mock_oversampling((uint8_t)(mock_regs[MOCK_REG_CTRL_MEAS] >> 5));
+    uint32_t osrs_p = mock_oversampling((uint8_t)(mock_regs[MOCK_REG_CTRL_MEAS] >> 2));
+    uint32_t osrs_h = mock_oversampling(mock_regs[MOCK_REG_CTRL_HUM]);
+    uint32_t us = 1250U + 2300U * osrs_t;
+    us += (osrs_p != 0U) ? 2300U * osrs_p + 575U : 0U;
+    us += (osrs_h != 0U) ? 2300U * osrs_h + 575U : 0U;
+    return (us + 999U) / 1000U;
+}
+
+static void mock_update_sensor(void)
+{
+    if (mock_converting && mock_tick >= mock_conversion_end)
+    {
+        mock_converting = 0U;
+        memcpy(&mock_regs[MOCK_REG_DATA], mock_sample, MOCK_DATA_LEN);
+        // Skipped measurements read back as 0x80000 (pressure) and 0x8000 (humidity).
+        if (mock_oversampling((uint8_t)(mock_regs[MOCK_REG_CTRL_MEAS] >> 2)) == 0U)
+        {
+            memcpy(&mock_regs[MOCK_REG_DATA], mock_reset_data, 3U);
+        }
+        if (mock_oversampling(mock_regs[MOCK_REG_CTRL_HUM]) == 0U)
+        {
+            memcpy(&mock_regs[MOCK_REG_DATA + 6U], mock_reset_data + 6U, 2U);
+        }
+        mock_regs[MOCK_REG_STATUS] = 0U;
+        if ((mock_regs[MOCK_REG_CTRL_MEAS] & 0x03U) == 0x03U)
+        {
+            return; // Normal mode keeps converting; the sample stays the same.
+        }
+        mock_regs[MOCK_REG_CTRL_MEAS] &= (uint8_t)~0x03U; // Forced mode falls back to sleep.
+        mock_trace("conversion done");
+    }
+}
+
+static void mock_write_regs(uint16_t reg, const uint8_t *data, uint16_t size)
+{
+    for (uint16_t i = 0; i < size; i++)
+    {
+        mock_regs[(reg + i) & 0xFFU] = data[i];
+    }
+
+    if (reg <= MOCK_REG_CTRL_MEAS && MOCK_REG_CTRL_MEAS < reg + size)
+    {
+        uint8_t mode = mock_regs[MOCK_REG_CTRL_MEAS] & 0x03U;
+        if (mode == 0x00U)
+        {
+            mock_converting = 0U;
+            return;
+        }
+        mock_converting = 1U;
+        mock_conversion_end = mock_tick + mock_conversion_ticks();
+        mock_regs[MOCK_REG_STATUS] = 0x08U; // measuring
+        if (mode == 0x01U)
+        {
+            mock_stats.triggers++;
+            mock_stats.trigger_tick = mock_tick;
+            mock_trace("forced conversion started, %lu ms", (unsigned long)mock_conversion_ticks());
+        }
+    }
+}
+
+static void mock_read_regs(uint16_t reg, uint8_t *data, uint16_t size)
+{
+    if (reg <= MOCK_REG_DATA + MOCK_DATA_LEN - 1U && MOCK_REG_DATA < reg + size)
+    {
+        mock_stats.read_tick = mock_tick;
+        if (mock_converting)
+        {
+            mock_stats.early_reads++;
+            mock_trace("data read while converting");
+        }
+    }
+    for (uint16_t i = 0; i < size; i++)
+    {
+        data[i] = mock_regs[(reg + i) & 0xFFU];
+    }
+}
+
+static HAL_StatusTypeDef mock_check_handle(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c != mock_bus || !mock_ready)
+    {
+        return HAL_ERROR;
+    }
+    if (mock_pending.active)
+    {
+        return HAL_BUSY;
+    }
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef mock_start(I2C_HandleTypeDef *hi2c, const char *kind, uint16_t reg, uint8_t *data, uint16_t size)
+{
+    uint8_t is_read = (strstr(kind, "read") != NULL) ? 1U : 0U;
+    HAL_StatusTypeDef status = mock_check_handle(hi2c);
+    mock_i2c_fault_t fault = mock_next_fault;
+    mock_next_fault = MOCK_I2C_FAULT_NONE;
+    if (status != HAL_OK || size > sizeof(mock_pending.bytes))
+    {
+        return (status != HAL_OK) ? status : HAL_ERROR;
+    }
+    if (fault == MOCK_I2C_FAULT_REFUSE)
+    {
+        mock_trace("%s %02X x%u refused", kind, reg, size);
+        return HAL_BUSY;
+    }
+
+    mock_pending.active = 1U;
+    mock_pending.is_read = is_read;
+    mock_pending.fault = fault;
+    mock_pending.due_tick = (fault == MOCK_I2C_FAULT_HANG) ? MOCK_NEVER : mock_tick + mock_latency_ms;
+    mock_pending.hi2c = hi2c;
+    mock_pending.reg = reg;
+    mock_pending.data = data;
+    mock_pending.size = size;
+    if (is_read)
+    {
+        mock_read_regs(reg, mock_pending.bytes, size);
+    }
+    else
+    {
+        memcpy(mock_pending.bytes, data, size);
+    }
+    mock_stats.transfers++;
+    mock_trace("%s %02X x%u started%s", kind, reg, size, (fault == MOCK_I2C_FAULT_HANG) ? ", bus hangs" : "");
+    return HAL_OK;
+}
+
+static void mock_deliver(void)
+{
+    if (!mock_pending.active || mock_tick < mock_pending.due_tick)
+    {
+        return;
+    }
+
+    // Clear first: the callback may start the next transfer.
+    mock_transfer_t done = mock_pending;
+    mock_pending.active = 0U;
+    if (done.fault == MOCK_I2C_FAULT_NACK)
+    {
+        mock_trace("transfer to %02X NACKed", done.reg);
+        HAL_I2C_ErrorCallback(done.hi2c);
+    }
+    else if (done.is_read)
+    {
+        memcpy(done.data, done.bytes, done.size);
+        mock_trace("read %02X x%u complete", done.reg, done.size);
+        HAL_I2C_MemRxCpltCallback(done.hi2c);
+    }
+    else
+    {
+        mock_write_regs(done.reg, done.bytes, done.size);
+        mock_trace("write %02X x%u complete", done.reg, done.size);
+        HAL_I2C_MemTxCpltCallback(done.hi2c);
+    }
+}
+
+void Mock_I2C_Reset(I2C_HandleTypeDef *hi2c, uint8_t verbose)
+{
+    mock_tick = 0U;
+    mock_primask = 0U;
+    mock_bus = hi2c;
+    mock_verbose = verbose;
+    mock_ready = 1U;
+    mock_latency_ms = MOCK_I2C_LATENCY_MS;
+    mock_next_fault = MOCK_I2C_FAULT_NONE;
+    mock_converting = 0U;
+    memset(&mock_pending, 0, sizeof(mock_pending));
+    memset(&mock_stats, 0, sizeof(mock_stats));
+
+    memset(mock_regs, 0, sizeof(mock_regs));
+    memcpy(&mock_regs[MOCK_REG_CALIB_T_P], mock_calib_t_p, sizeof(mock_calib_t_p));
+    memcpy(&mock_regs[MOCK_REG_CALIB_H2], mock_calib_h, sizeof(mock_calib_h));
+    mock_regs[MOCK_REG_ID] = 0x60U;
+    memcpy(&mock_regs[MOCK_REG_DATA], mock_reset_data, MOCK_DATA_LEN);
+}
+
+void Mock_I2C_SetLatency(uint32_t latency_ms)
+{
+    mock_latency_ms = latency_ms;
+}
+
+void Mock_I2C_FailNext(mock_i2c_fault_t fault)
+{
+    mock_next_fault = fault;
+}
+
+void Mock_I2C_Step(void)
+{
+    mock_tick++;
+    mock_update_sensor();
+    mock_deliver();
+}
+
+void Mock_I2C_Raise(mock_i2c_event_t event, I2C_HandleTypeDef *hi2c)
+{
+    static const char *const names[] = {"TxCplt", "RxCplt", "Error"};
+    if (mock_verbose)
+    {
+        printf("    %5lu ms  %s raised on %s handle\n", (unsigned long)mock_tick, names[event], (hi2c == mock_bus) ? "the" : "another");
+    }
+
+    if (event == MOCK_I2C_EVENT_TX)
+    {
+        HAL_I2C_MemTxCpltCallback(hi2c);
+    }
+    else if (event == MOCK_I2C_EVENT_RX)
+    {
+        HAL_I2C_MemRxCpltCallback(hi2c);
+    }
+    else
+    {
+        HAL_I2C_ErrorCallback(hi2c);
+    }
+}
+
+uint8_t Mock_I2C_IsPending(void)
+{
+    return mock_pending.active;
+}
+
+void Mock_I2C_GetStats(mock_i2c_stats_t *stats)
+{
+    *stats = mock_stats;
+}
+
+// --- HAL ---
+uint32_t HAL_GetTick(void)
+{
+    return mock_tick;
+}
+
+void HAL_Delay(uint32_t delay)
+{
+    for (uint32_t i = 0; i < delay; i++)
+    {
+        Mock_I2C_Step();
+    }
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c != mock_bus)
+    {
+        return HAL_ERROR;
+    }
+    mock_stats.inits++;
+    mock_ready = 1U;
+    mock_trace("HAL_I2C_Init");
+    return HAL_OK;
+}
+
+// Resetting the peripheral drops the transfer in flight without a callback, and frees a hung bus.
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c != mock_bus)
+    {
+        return HAL_ERROR;
+    }
+    if (mock_pending.active)
+    {
+        mock_pending.active = 0U;
+        mock_stats.dropped++;
+    }
+    mock_stats.deinits++;
+    mock_ready = 0U;
+    mock_trace("HAL_I2C_DeInit");
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                    uint16_t size, uint32_t timeout)
+{
+    (void)address;
+    (void)reg_size;
+    (void)timeout;
+    HAL_StatusTypeDef status = mock_check_handle(hi2c);
+    if (status == HAL_OK)
+    {
+        mock_write_regs(reg, data, size);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                   uint16_t size, uint32_t timeout)
+{
+    (void)address;
+    (void)reg_size;
+    (void)timeout;
+    HAL_StatusTypeDef status = mock_check_handle(hi2c);
+    if (status == HAL_OK)
+    {
+        mock_read_regs(reg, data, size);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                       uint16_t size)
+{
+    (void)address;
+    (void)reg_size;
+    return mock_start(hi2c, "IT write", reg, data, size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_IT(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                      uint16_t size)
+{
+    (void)address;
+    (void)reg_size;
+    return mock_start(hi2c, "IT read", reg, data, size);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read_DMA(I2C_HandleTypeDef *hi2c, uint16_t address, uint16_t reg, uint16_t reg_size, uint8_t *data,
+                                       uint16_t size)
+{
+    (void)address;
+    (void)reg_size;
+    return mock_start(hi2c, "DMA read", reg, data, size);
+}
@@ -0,0 +1,57 @@
+#ifndef MOCK_I2C_BUS_H
+#define MOCK_I2C_BUS_H
+
+#include "main.h"
+#include <stdint.h>
+
+// A BME280 on a simulated I2C bus, played by the host (see host/main.h for the HAL it implements).
+// The sensor has a register file with calibration data, and a forced or normal-mode conversion that
+// takes the datasheet's maximum measurement time. The data registers keep their reset value until
+// the first conversion finishes, skipped measurements keep it afterwards, and a read that arrives
+// while a conversion is still running is counted as early.
+// IT and DMA transfers complete latency_ms ticks after they start, from Mock_I2C_Step(), which
+// plays the I2C event interrupt. Faults can be injected into the next transfer.
+
+#define MOCK_I2C_LATENCY_MS 1U   // Default IT/DMA transfer time, in ticks.
+
+typedef enum
+{
+    MOCK_I2C_FAULT_NONE = 0,
+    MOCK_I2C_FAULT_REFUSE,   // The HAL call returns HAL_BUSY, as when the peripheral is still busy.
+    MOCK_I2C_FAULT_NACK,     // The transfer starts but ends with HAL_I2C_ErrorCallback.
+    MOCK_I2C_FAULT_HANG      // The transfer starts and never completes (SDA held low).
+} mock_i2c_fault_t;
+
+typedef enum
+{
+    MOCK_I2C_EVENT_TX = 0,   // HAL_I2C_MemTxCpltCallback
+    MOCK_I2C_EVENT_RX,       // HAL_I2C_MemRxCpltCallback
+    MOCK_I2C_EVENT_ERROR     // HAL_I2C_ErrorCallback
+} mock_i2c_event_t;
+
+typedef struct
+{
+    uint32_t transfers;      // IT and DMA transfers started.
+    uint32_t triggers;       // Forced-mode conversions started.
+    uint32_t early_reads;    // Data reads that began before the conversion had finished.
+    uint32_t dropped;        // Pending transfers dropped by HAL_I2C_DeInit.
+    uint32_t deinits;
+    uint32_t inits;
+    uint32_t trigger_tick;   // Tick the last forced conversion started.
+    uint32_t read_tick;      // Tick the last data read started.
+} mock_i2c_stats_t;
+
+// Power on: tick 0, sensor asleep with a fixed calibration and sample, no pending transfer.
+// Every transfer on hi2c reaches the sensor; transfers on other handles fail.
+void Mock_I2C_Reset(I2C_HandleTypeDef *hi2c, uint8_t verbose);
+void Mock_I2C_SetLatency(uint32_t latency_ms);
+// Applies to the next IT or DMA transfer only.
+void Mock_I2C_FailNext(mock_i2c_fault_t fault);
+// Advance time by one tick and deliver the transfers that are due.
+void Mock_I2C_Step(void);
+// Raise one HAL callback now for any handle, as a stray or late interrupt would.
+void Mock_I2C_Raise(mock_i2c_event_t event, I2C_HandleTypeDef *hi2c);
+uint8_t Mock_I2C_IsPending(void);
+void Mock_I2C_GetStats(mock_i2c_stats_t *stats);
+
+#endif
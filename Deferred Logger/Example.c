@@ -0,0 +1,49 @@
+#include "deferred_log.h"
+#include "wifi_basic_driver.h"
+
+extern UART_HandleTypeDef huart1;   // ESP-01
+extern UART_HandleTypeDef huart3;   // Log output (ST-LINK virtual COM port)
+
+wifi_handle_t wifi;
+
+// Drained records go out over the log UART. A blocking transmit is fine here: it only runs from
+// the idle loop, never inside a driver wait.
+static void Log_Output(const uint8_t *data, uint16_t length, void *context)
+{
+    HAL_UART_Transmit((UART_HandleTypeDef *)context, (uint8_t *)data, length, HAL_MAX_DELAY);
+}
+
+// Interrupt handlers may log too; their records go to a separate ring.
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    DLOG(DLOG_APP_BUTTON, GPIO_Pin);
+}
+
+int main(void)
+{
+    HAL_Init();
+    SystemClock_Config();
+    MX_GPIO_Init();
+    MX_USART1_UART_Init();
+    MX_USART3_UART_Init();
+
+    // Set up the logger first so the driver's start-up messages are kept.
+    DLog_Init(Log_Output, &huart3);
+
+    WiFi_Init(&wifi, &huart1);
+    WiFi_Connect(&wifi, "YourSSID", "YourPassword");
+
+    uint32_t loops = 0;
+    while (1)
+    {
+        WiFi_Poll(&wifi);
+
+        if (++loops % 100000U == 0U)
+        {
+            DLOG(DLOG_APP_HEARTBEAT, loops, DLog_GetDropped());
+        }
+
+        // Nothing urgent left to do: send a few records.
+        DLog_Drain(8);
+    }
+}
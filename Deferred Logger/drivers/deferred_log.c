@@ -0,0 +1,245 @@
+#include "deferred_log.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DLOG_RING_MASK (DLOG_RING_WORDS - 1U)
+
+// Record words must be visible before the index that publishes them (and read before the index
+// that frees them). A single Cortex-M core only needs the compiler to keep the order.
+#if defined(__CORTEX_M)
+    #define DLOG_BARRIER() __DMB()
+#else
+    #define DLOG_BARRIER() __sync_synchronize()
+#endif
+
+// Interrupts at different NVIC priorities share the interrupt ring, so a record written there is
+// claimed and filled with interrupts masked: a nested handler cannot interleave its words with the
+// one it preempted. That costs a few dozen cycles; the thread ring has one producer and stays lock-free.
+#if defined(__CORTEX_M)
+    #define DLOG_LOCK(context, primask)                                                                            \
+        do                                                                                                         \
+        {                                                                                                          \
+            if ((context) != 0U)                                                                                   \
+            {                                                                                                      \
+                (primask) = __get_PRIMASK();                                                                       \
+                __disable_irq();                                                                                   \
+            }                                                                                                      \
+        } while (0)
+    #define DLOG_UNLOCK(context, primask)                                                                          \
+        do                                                                                                         \
+        {                                                                                                          \
+            if ((context) != 0U)                                                                                   \
+            {                                                                                                      \
+                __set_PRIMASK(primask);                                                                            \
+            }                                                                                                      \
+        } while (0)
+#else
+    #define DLOG_LOCK(context, primask)   ((void)(context), (void)(primask))
+    #define DLOG_UNLOCK(context, primask) ((void)(context), (void)(primask))
+#endif
+
+static dlog_ring_t dlog_rings[DLOG_CONTEXTS];
+static dlog_output_t dlog_output = NULL;
+static void *dlog_output_context = NULL;
+
+static void dlog_emit(const uint32_t *words, uint32_t count);
+static void dlog_print(const char *text, const uint32_t *words, uint8_t args, uint8_t text_len);
+static void dlog_report_lost(dlog_ring_t *ring, uint8_t index);
+
+void DLog_Init(dlog_output_t output, void *context)
+{
+    memset(dlog_rings, 0, sizeof(dlog_rings));
+    dlog_output = output;
+    dlog_output_context = context;
+}
+
+void DLog_Write(const char *text, const uint32_t *words, uint8_t count)
+{
+    if (words == NULL || count == 0)
+    {
+        return;
+    }
+
+    uint8_t args = (uint8_t)(count - 1U);
+    if (args > DLOG_MAX_ARGS)
+    {
+        args = DLOG_MAX_ARGS;
+    }
+    uint8_t text_len = 0;
+    if (text != NULL)
+    {
+        while (text_len < DLOG_TEXT_LEN && text[text_len] != '\0')
+        {
+            text_len++;
+        }
+    }
+
+#if DLOG_DEFERRED
+    if (dlog_output == NULL)
+    {
+        dlog_print(text, words, args, text_len); // No drain target yet: behave like a plain printf logger.
+        return;
+    }
+
+    uint8_t context = (uint8_t)DLOG_CONTEXT();
+    dlog_ring_t *ring = &dlog_rings[context];
+    uint32_t size = DLOG_RECORD_WORDS(args, text_len);
+    uint32_t primask = 0;
+    DLOG_LOCK(context, primask);
+    uint32_t head = ring->head;
+
+    if ((DLOG_RING_WORDS - (head - ring->tail)) < size)
+    {
+        ring->dropped++;
+        DLOG_UNLOCK(context, primask);
+        return;
+    }
+
+    ring->words[head & DLOG_RING_MASK] = DLOG_HEADER(words[0] & 0xFFFFU, args, text_len, context);
+    ring->words[(head + 1U) & DLOG_RING_MASK] = HAL_GetTick();
+    for (uint8_t i = 0; i < args; i++)
+    {
+        ring->words[(head + 2U + i) & DLOG_RING_MASK] = words[1U + i];
+    }
+    for (uint8_t i = 0; i < text_len; i += 4U)
+    {
+        uint32_t packed = 0;
+        uint8_t chunk = (uint8_t)(text_len - i);
+        memcpy(&packed, text + i, (chunk < 4U) ? chunk : 4U);
+        ring->words[(head + 2U + args + i / 4U) & DLOG_RING_MASK] = packed;
+    }
+
+    DLOG_BARRIER();
+    ring->head = head + size;
+    DLOG_UNLOCK(context, primask);
+#else
+    dlog_print(text, words, args, text_len);
+#endif
+}
+
+uint16_t DLog_Drain(uint16_t max_records)
+{
+    uint16_t sent = 0;
+
+    for (uint8_t i = 0; i < DLOG_CONTEXTS; i++)
+    {
+        dlog_report_lost(&dlog_rings[i], i);
+    }
+
+    while (sent < max_records)
+    {
+        // Take the oldest record at the front of any ring, so interrupt and thread records interleave in time order.
+        dlog_ring_t *next = NULL;
+        for (uint8_t i = 0; i < DLOG_CONTEXTS; i++)
+        {
+            dlog_ring_t *ring = &dlog_rings[i];
+            if (ring->tail == ring->head)
+            {
+                continue;
+            }
+            DLOG_BARRIER();
+            if (next == NULL ||
+                (int32_t)(ring->words[(ring->tail + 1U) & DLOG_RING_MASK] - next->words[(next->tail + 1U) & DLOG_RING_MASK]) < 0)
+            {
+                next = ring;
+            }
+        }
+        if (next == NULL)
+        {
+            break;
+        }
+
+        uint32_t tail = next->tail;
+        uint32_t header = next->words[tail & DLOG_RING_MASK];
+        uint32_t size = DLOG_RECORD_WORDS(DLOG_HEADER_ARGS(header), DLOG_HEADER_TEXT_LEN(header));
+        uint32_t record[DLOG_RECORD_WORDS(DLOG_MAX_ARGS, DLOG_TEXT_LEN)];
+        for (uint32_t i = 0; i < size; i++)
+        {
+            record[i] = next->words[(tail + i) & DLOG_RING_MASK];
+        }
+
+        DLOG_BARRIER();
+        next->tail = tail + size; // Free the space before the (possibly slow) output call.
+        dlog_emit(record, size);
+        sent++;
+    }
+
+    return sent;
+}
+
+uint8_t DLog_Pending(void)
+{
+    for (uint8_t i = 0; i < DLOG_CONTEXTS; i++)
+    {
+        if (dlog_rings[i].tail != dlog_rings[i].head)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+uint32_t DLog_GetDropped(void)
+{
+    uint32_t dropped = 0;
+    for (uint8_t i = 0; i < DLOG_CONTEXTS; i++)
+    {
+        dropped += dlog_rings[i].dropped;
+    }
+    return dropped;
+}
+
+// Wire format: DLOG_SYNC, then the record words little-endian. Bytes outside records (e.g. printf
+// output on the same UART) are passed through by the decoder.
+static void dlog_emit(const uint32_t *words, uint32_t count)
+{
+    uint8_t frame[1U + 4U * DLOG_RECORD_WORDS(DLOG_MAX_ARGS, DLOG_TEXT_LEN)];
+    uint16_t length = 0;
+
+    if (dlog_output == NULL)
+    {
+        return;
+    }
+
+    frame[length++] = DLOG_SYNC;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        frame[length++] = (uint8_t)(words[i]);
+        frame[length++] = (uint8_t)(words[i] >> 8);
+        frame[length++] = (uint8_t)(words[i] >> 16);
+        frame[length++] = (uint8_t)(words[i] >> 24);
+    }
+    dlog_output(frame, length, dlog_output_context);
+}
+
+// Immediate output: format the message and write it straight away.
+static void dlog_print(const char *text, const uint32_t *words, uint8_t args, uint8_t text_len)
+{
+    char line[DLOG_LINE_LEN];
+    uint16_t length = DLog_Format(line, sizeof(line) - 2U, (uint16_t)words[0], &words[1], args, text, text_len);
+    line[length++] = '\r';
+    line[length++] = '\n';
+    line[length] = '\0';
+    if (dlog_output != NULL)
+    {
+        dlog_output((const uint8_t *)line, length, dlog_output_context);
+    }
+    else
+    {
+        printf("%s", line); // Same behaviour as a plain printf logger until an output is set.
+    }
+}
+
+// The consumer cannot reset the producer's counter, so it remembers how much it has reported.
+static void dlog_report_lost(dlog_ring_t *ring, uint8_t index)
+{
+    uint32_t dropped = ring->dropped;
+    if (dropped == ring->reported)
+    {
+        return;
+    }
+
+    uint32_t record[3] = {DLOG_HEADER(DLOG_LOST, 1U, 0U, index), HAL_GetTick(), dropped - ring->reported};
+    ring->reported = dropped;
+    dlog_emit(record, 3);
+}
@@ -0,0 +1,65 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stddef.h>
+#include "deferred_log_format.h"
+
+// 1: DLOG stores the message ID, tick and raw arguments in a ring and returns; DLog_Drain sends
+// the records later. 0: DLOG formats the text and writes it to the output at once (bring-up).
+#ifndef DLOG_DEFERRED
+    #define DLOG_DEFERRED 1
+#endif
+
+#define DLOG_RING_WORDS 256      // Ring size per context in 32-bit words; must be a power of two.
+#ifndef DLOG_CONTEXTS
+    #define DLOG_CONTEXTS 2      // One ring for thread code, one for interrupts.
+#endif
+#define DLOG_LINE_LEN 128        // Longest line rendered in immediate mode.
+
+// Ring index for the calling context: 0 for thread code, anything else for interrupts. Records in
+// interrupt rings are written with interrupts masked, so nested handlers at different priorities
+// can share ring 1. Override this macro to give busy handlers rings of their own.
+#ifndef DLOG_CONTEXT
+    #if defined(__CORTEX_M)
+        #define DLOG_CONTEXT() ((__get_IPSR() != 0U) ? 1U : 0U)
+    #else
+        #define DLOG_CONTEXT() 0U
+    #endif
+#endif
+
+// Log message id with integer arguments: DLOG(DLOG_WIFI_LINK_UP, elapsed_ms). Each argument is
+// converted to uint32_t; pass floats scaled to integers.
+#define DLOG(...) DLog_Write(NULL, (const uint32_t[]){__VA_ARGS__}, \
+                             (uint8_t)(sizeof((const uint32_t[]){__VA_ARGS__}) / sizeof(uint32_t)))
+// Same with a short string for the message's %s: DLOG_TEXT(host, DLOG_WIFI_BREAKER_OPEN, port).
+#define DLOG_TEXT(text, ...) DLog_Write((text), (const uint32_t[]){__VA_ARGS__}, \
+                                        (uint8_t)(sizeof((const uint32_t[]){__VA_ARGS__}) / sizeof(uint32_t)))
+
+// Receives drained records (or text lines in immediate mode), e.g. a blocking UART transmit.
+typedef void (*dlog_output_t)(const uint8_t *data, uint16_t length, void *context);
+
+// One single-producer, single-consumer ring. The producer only moves head, the consumer only tail.
+typedef struct
+{
+    uint32_t words[DLOG_RING_WORDS];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;   // Records rejected because the ring was full (producer side).
+    uint32_t reported;           // Part of dropped already announced with a DLOG_LOST record.
+} dlog_ring_t;
+
+// Until DLog_Init sets an output, messages are formatted and printed at once, as with printf.
+void DLog_Init(dlog_output_t output, void *context);
+// Called through DLOG/DLOG_TEXT. words[0] is the message ID, the rest are its arguments. Safe from
+// thread or interrupt context; never blocks in deferred mode.
+void DLog_Write(const char *text, const uint32_t *words, uint8_t count);
+// Send up to max_records records (oldest first across both rings) to the output. Call it from
+// the idle loop. Returns the number sent.
+uint16_t DLog_Drain(uint16_t max_records);
+// 1 while records are waiting to be drained.
+uint8_t DLog_Pending(void);
+uint32_t DLog_GetDropped(void);
+
+#endif
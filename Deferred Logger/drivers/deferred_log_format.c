@@ -0,0 +1,112 @@
+#include "deferred_log_format.h"
+#include <stdio.h>
+#include <string.h>
+
+#define DLOG_ENTRY_FORMAT(id, format) format,
+const char *const DLog_Formats[DLOG_MESSAGE_COUNT] = {DLOG_MESSAGES(DLOG_ENTRY_FORMAT)};
+
+// Walk the format and hand each conversion to snprintf with the stored argument widened to long,
+// so the same text comes out on the target and on the host regardless of their int sizes.
+uint16_t DLog_Format(char *out, uint16_t out_len, uint16_t id, const uint32_t *args, uint8_t arg_count, const char *text,
+                     uint8_t text_len)
+{
+    if (out == NULL || out_len == 0)
+    {
+        return 0;
+    }
+    if (id >= DLOG_MESSAGE_COUNT)
+    {
+        return (uint16_t)snprintf(out, out_len, "<unknown message %u>", id);
+    }
+
+    char text_copy[DLOG_TEXT_LEN + 1];
+    if (text_len > DLOG_TEXT_LEN)
+    {
+        text_len = DLOG_TEXT_LEN;
+    }
+    if (text != NULL)
+    {
+        memcpy(text_copy, text, text_len);
+    }
+    text_copy[(text != NULL) ? text_len : 0] = '\0';
+
+    const char *format = DLog_Formats[id];
+    uint8_t next_arg = 0;
+    size_t used = 0;
+    out[0] = '\0';
+
+    while (*format != '\0' && used + 1U < out_len)
+    {
+        if (*format != '%')
+        {
+            out[used++] = *format++;
+            out[used] = '\0';
+            continue;
+        }
+
+        // Copy "%[flags][width][.precision]" and skip length modifiers; the conversion is added below.
+        char spec[16];
+        size_t spec_len = 0;
+        spec[spec_len++] = *format++;
+        while (*format != '\0' && strchr("-+ #0123456789.", *format) != NULL && spec_len < sizeof(spec) - 4U)
+        {
+            spec[spec_len++] = *format++;
+        }
+        while (*format == 'l' || *format == 'h' || *format == 'z')
+        {
+            format++;
+        }
+
+        char conversion = *format;
+        if (conversion == '\0')
+        {
+            break;
+        }
+        format++;
+
+        uint32_t value = (next_arg < arg_count && args != NULL) ? args[next_arg] : 0U;
+        int written;
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            spec[spec_len++] = 'l';
+            spec[spec_len++] = 'd';
+            spec[spec_len] = '\0';
+            written = snprintf(out + used, out_len - used, spec, (long)(int32_t)value);
+            next_arg++;
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec[spec_len++] = 'l';
+            spec[spec_len++] = conversion;
+            spec[spec_len] = '\0';
+            written = snprintf(out + used, out_len - used, spec, (unsigned long)value);
+            next_arg++;
+            break;
+        case 'c':
+            spec[spec_len++] = 'c';
+            spec[spec_len] = '\0';
+            written = snprintf(out + used, out_len - used, spec, (int)(value & 0xFFU));
+            next_arg++;
+            break;
+        case 's':
+            spec[spec_len++] = 's';
+            spec[spec_len] = '\0';
+            written = snprintf(out + used, out_len - used, spec, text_copy);
+            break;
+        default: // "%%" and anything unsupported are printed literally.
+            written = snprintf(out + used, out_len - used, "%c", conversion);
+            break;
+        }
+
+        if (written > 0)
+        {
+            used += (size_t)written;
+        }
+    }
+
+    return (uint16_t)((used < out_len) ? used : (out_len - 1U));
+}
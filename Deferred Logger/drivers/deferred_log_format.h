@@ -0,0 +1,38 @@
+#ifndef DEFERRED_LOG_FORMAT_H
+#define DEFERRED_LOG_FORMAT_H
+
+// Record layout and text rendering shared by the firmware and the host decoder. Nothing here
+// depends on the HAL, so the host tool compiles this file as-is.
+
+#include <stdint.h>
+#include <stddef.h>
+#include "deferred_log_messages.h"
+
+#define DLOG_MAX_ARGS 6          // Integer arguments kept per record; extra ones are dropped.
+#define DLOG_TEXT_LEN 32         // Longest %s text kept per record; longer text is cut.
+#define DLOG_SYNC 0xD1U          // Starts every record on the wire. Never appears in ASCII text.
+
+// Record: header word, tick word, the arguments, then the text packed four bytes per word.
+// Header bits 0-15 message ID, 16-19 argument count, 20-27 text length, 28-31 ring (0 thread, 1 interrupt).
+#define DLOG_HEADER(id, args, text_len, ring) \
+    ((uint32_t)(id) | ((uint32_t)(args) << 16) | ((uint32_t)(text_len) << 20) | ((uint32_t)(ring) << 28))
+#define DLOG_HEADER_ID(header)       ((uint16_t)((header) & 0xFFFFU))
+#define DLOG_HEADER_ARGS(header)     ((uint8_t)(((header) >> 16) & 0x0FU))
+#define DLOG_HEADER_TEXT_LEN(header) ((uint8_t)(((header) >> 20) & 0xFFU))
+#define DLOG_HEADER_RING(header)     ((uint8_t)(((header) >> 28) & 0x0FU))
+#define DLOG_RECORD_WORDS(args, text_len) (2U + (uint32_t)(args) + (((uint32_t)(text_len) + 3U) / 4U))
+
+#define DLOG_ENUM_ENTRY(id, format) id,
+typedef enum
+{
+    DLOG_MESSAGES(DLOG_ENUM_ENTRY)
+    DLOG_MESSAGE_COUNT
+} dlog_id_t;
+
+extern const char *const DLog_Formats[DLOG_MESSAGE_COUNT];
+
+// Render message id with its arguments into out (always terminated). Returns the length written.
+uint16_t DLog_Format(char *out, uint16_t out_len, uint16_t id, const uint32_t *args, uint8_t arg_count, const char *text,
+                     uint8_t text_len);
+
+#endif
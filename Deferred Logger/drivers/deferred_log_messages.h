@@ -0,0 +1,48 @@
+#ifndef DEFERRED_LOG_MESSAGES_H
+#define DEFERRED_LOG_MESSAGES_H
+
+// Message catalogue shared by the firmware and the host decoder. Each entry is X(id, format):
+// the firmware only stores the ID, so the text never leaves flash and the decoder must be built
+// from the same file. Append new entries at the end of a section; reordering changes the IDs of
+// everything after it, so rebuild the decoder together with the firmware.
+//
+// Formats take printf conversions (d i u x X c s, with flags, width and precision). Integer
+// arguments are stored as 32 bits; l/h length modifiers are accepted and ignored. A message may
+// contain one %s, which is filled from the text passed to DLOG_TEXT.
+#define DLOG_MESSAGES(X)                                                                                 \
+    /* Logger */                                                                                         \
+    X(DLOG_LOST, "%lu records lost, ring full")                                                          \
+    /* ESP-01 Wi-Fi Module */                                                                            \
+    X(DLOG_WIFI_INIT_NO_SLOT, "WiFi_Init: no free UART dispatch slot")                                   \
+    X(DLOG_WIFI_INIT_BAUD_KEPT, "WiFi_Init: staying at %lu baud")                                        \
+    X(DLOG_WIFI_READY, "Wi-Fi module ready in STA mode.")                                                \
+    X(DLOG_WIFI_BAUD_OK, "WiFi_SetBaudRate: link running at %lu baud")                                   \
+    X(DLOG_WIFI_BAUD_FALLBACK, "WiFi_SetBaudRate: no answer at %lu baud, falling back")                  \
+    X(DLOG_WIFI_CONNECTED, "WiFi_Connect: connected, IP = %s")                                           \
+    X(DLOG_WIFI_CONNECT_FAILED, "WiFi_Connect: no IP, connect failed")                                   \
+    X(DLOG_WIFI_FAST_CACHE_MISS, "WiFi_Connect_Fast: cached AP %s not joined, doing a full join")        \
+    X(DLOG_WIFI_FAST_GOT_IP, "WiFi_Connect_Fast: IP after %lu ms")                                       \
+    X(DLOG_WIFI_EXPECT_TIMEOUT, "WiFi_Expect: TIMEOUT waiting for \"%s\"")                               \
+    X(DLOG_WIFI_HTTP_FAST_FAIL, "WiFi_HTTP_Send: %s:%u is down, failing fast")                           \
+    X(DLOG_WIFI_HTTP_CONNECT_FAILED, "Attempt %u --- WiFi_HTTP_Send: CIPSTART failed!")                  \
+    X(DLOG_WIFI_HTTP_NO_RESPONSE, "Attempt %u --- WiFi_HTTP_Send: No HTTP response detected")            \
+    X(DLOG_WIFI_HTTP_STATUS, "Attempt %u --- WiFi_HTTP_Send: HTTP %u received")                          \
+    X(DLOG_WIFI_SESSION_FAST_FAIL, "WiFi_HTTP_Session_Send: %s:%u is down, failing fast")                \
+    X(DLOG_WIFI_SESSION_CONNECT_FAILED, "Attempt %u --- WiFi_HTTP_Session_Send: CIPSTART failed!")       \
+    X(DLOG_WIFI_SESSION_NO_RESPONSE, "Attempt %u --- WiFi_HTTP_Session_Send: No HTTP response detected") \
+    X(DLOG_WIFI_HTTP_CIPSEND_FAILED, "WiFi_HTTP: CIPSEND failed!")                                       \
+    X(DLOG_WIFI_LINK_UP, "WiFi_Link: up after %lu ms")                                                   \
+    X(DLOG_WIFI_LINK_DOWN, "WiFi_Link: down, next join in %lu ms")                                       \
+    X(DLOG_WIFI_MQTT_CONNECT_FAILED, "WiFi_MQTT_Connect: CIPSTART failed!")                              \
+    X(DLOG_WIFI_MQTT_REFUSED, "WiFi_MQTT_Connect: broker refused (%u)")                                  \
+    X(DLOG_WIFI_MQTT_CLOSED, "WiFi_MQTT: broker closed the connection")                                  \
+    X(DLOG_WIFI_MQTT_NO_PINGRESP, "WiFi_MQTT: no PINGRESP, dropping the connection")                     \
+    X(DLOG_WIFI_BREAKER_OPEN, "WiFi_Breaker: %s:%u is down, failing fast")                               \
+    X(DLOG_WIFI_STREAM_CONNECT_FAILED, "WiFi_Stream_Begin: CIPSTART failed!")                            \
+    X(DLOG_WIFI_TELEMETRY_FAILED, "WiFi_Telemetry_Flush: upload of %u records failed")                   \
+    X(DLOG_WIFI_JOURNAL_FAILED, "WiFi_Journal_Replay: batch of %u records failed, %lu pending")          \
+    /* Application: add your own messages below. */                                                      \
+    X(DLOG_APP_BUTTON, "Button on pin 0x%04x")                                                           \
+    X(DLOG_APP_HEARTBEAT, "Alive, loop %lu, %lu records lost so far")
+
+#endif
@@ -0,0 +1,92 @@
+// Host-side decoder for the deferred log stream. Build it against the same message catalogue as
+// the firmware:
+//
+//     gcc -I../drivers dlog_decode.c ../drivers/deferred_log_format.c -o dlog_decode
+//     ./dlog_decode capture.bin        (or read a serial port: ./dlog_decode /dev/ttyACM0)
+//
+// Records are printed as "[tick ms] text"; records logged from an interrupt are marked with '*'.
+// Any other bytes on the stream (plain printf output sharing the UART) are copied through.
+
+#include <stdio.h>
+#include <string.h>
+#include "deferred_log_format.h"
+
+static int read_exact(FILE *in, uint8_t *buf, size_t len)
+{
+    return fread(buf, 1, len, in) == len;
+}
+
+static uint32_t load_word(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = stdin;
+    if (argc > 1 && (in = fopen(argv[1], "rb")) == NULL)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    unsigned long records = 0;
+    unsigned long bad = 0;
+    int c;
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c != DLOG_SYNC)
+        {
+            putchar(c);
+            continue;
+        }
+
+        uint8_t bytes[4];
+        if (!read_exact(in, bytes, 4))
+        {
+            break;
+        }
+        uint32_t header = load_word(bytes);
+        uint8_t args = DLOG_HEADER_ARGS(header);
+        uint8_t text_len = DLOG_HEADER_TEXT_LEN(header);
+        if (DLOG_HEADER_ID(header) >= DLOG_MESSAGE_COUNT || args > DLOG_MAX_ARGS || text_len > DLOG_TEXT_LEN)
+        {
+            bad++; // Not a record after all (or a catalogue mismatch); show the bytes as they were.
+            putchar(c);
+            fwrite(bytes, 1, 4, stdout);
+            continue;
+        }
+
+        uint32_t words[DLOG_RECORD_WORDS(DLOG_MAX_ARGS, DLOG_TEXT_LEN)];
+        uint32_t count = DLOG_RECORD_WORDS(args, text_len);
+        words[0] = header;
+        int complete = 1;
+        for (uint32_t i = 1; i < count && complete; i++)
+        {
+            complete = read_exact(in, bytes, 4);
+            words[i] = load_word(bytes);
+        }
+        if (!complete)
+        {
+            break;
+        }
+
+        char text[DLOG_TEXT_LEN + 4];
+        for (uint8_t i = 0; i < text_len; i++)
+        {
+            text[i] = (char)(words[2U + args + i / 4U] >> (8U * (i % 4U)));
+        }
+
+        char line[256];
+        DLog_Format(line, sizeof(line), DLOG_HEADER_ID(header), &words[2], args, text, text_len);
+        printf("[%10lu]%c %s\n", (unsigned long)words[1], DLOG_HEADER_RING(header) ? '*' : ' ', line);
+        records++;
+    }
+
+    fprintf(stderr, "%lu records decoded, %lu bad headers\n", records, bad);
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+    return 0;
+}
@@ -1,5 +1,10 @@
 #include "wifi_basic_driver.h"
 
+static wifi_handle_t wifi; // ONE HANDLE PER ESP-01 MODULE
+
+// DRIVER MESSAGES GO THROUGH THE DEFERRED LOGGER: ADD deferred_log.c AND deferred_log_format.c FROM
+// "Deferred Logger/drivers" TO THE BUILD (OR DEFINE WIFI_DEBUG=0). WITHOUT DLog_Init() THEY ARE PRINTED WITH printf.
+
 int main(void)
 {
     HAL_Init();
@@ -7,12 +12,12 @@ int main(void)
     MX_USART1_UART_Init();    // IN THIS CASE THE USART-1 WILL BE CONNECTED TO THE ESP-01 MODULE
     MX_USART3_UART_Init();    // INITIALIZE ST-LINK IN USRAT-3 TO PRINT RESULTS IN SERIAL MONITOR
 
-    WiFi_Init(&huart1);       // INITIALIZE WIFI
-    WiFi_Connect("MySSID", "MyPassword"); // CONNECT TO WIFI
+    WiFi_Init(&wifi, &huart1); // INITIALIZE WIFI
+    WiFi_Connect(&wifi, "MySSID", "MyPassword"); // CONNECT TO WIFI
 
     char ip[64];
-    WiFi_GetIP(ip, sizeof(ip));    // FETCH THE IP ADDRESS AND COPY RESULT IN A STRING
+    WiFi_GetIP(&wifi, ip, sizeof(ip));    // FETCH THE IP ADDRESS AND COPY RESULT IN A STRING
     printf("IP: %s\r\n", ip);
 
-    WiFi_SendTCP("192.168.1.105", 5000, "Hello from STM32!\r\n");
+    WiFi_SendTCP(&wifi, "192.168.1.105", 5000, "Hello from STM32!\r\n");
 }
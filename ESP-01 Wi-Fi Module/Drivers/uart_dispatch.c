@@ -0,0 +1,96 @@
+#include "uart_dispatch.h"
+
+typedef struct
+{
+    UART_HandleTypeDef *huart; // NULL when the slot is free.
+    const uart_dispatch_callbacks_t *callbacks;
+    void *context;
+} uart_dispatch_entry_t;
+
+static uart_dispatch_entry_t uart_dispatch_table[UART_DISPATCH_SLOTS];
+
+static uart_dispatch_entry_t *uart_dispatch_find(UART_HandleTypeDef *huart);
+
+HAL_StatusTypeDef UART_Dispatch_Register(UART_HandleTypeDef *huart, const uart_dispatch_callbacks_t *callbacks, void *context)
+{
+    if (huart == NULL || callbacks == NULL)
+    {
+        return HAL_ERROR;
+    }
+
+    uart_dispatch_entry_t *entry = uart_dispatch_find(huart);
+    if (entry == NULL)
+    {
+        entry = uart_dispatch_find(NULL);
+    }
+    if (entry == NULL)
+    {
+        return HAL_BUSY; // Table full; raise UART_DISPATCH_SLOTS.
+    }
+
+    // An interrupt may look the entry up while it is written, so the UART is published last.
+    entry->huart = NULL;
+    entry->callbacks = callbacks;
+    entry->context = context;
+    entry->huart = huart;
+    return HAL_OK;
+}
+
+void UART_Dispatch_Unregister(UART_HandleTypeDef *huart)
+{
+    uart_dispatch_entry_t *entry = uart_dispatch_find(huart);
+    if (entry != NULL && huart != NULL)
+    {
+        entry->huart = NULL;
+    }
+}
+
+// The HAL callbacks are weak by default, so the table owns them instead of main.c.
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    uart_dispatch_entry_t *entry = uart_dispatch_find(huart);
+    if (entry != NULL && entry->callbacks->tx_complete != NULL)
+    {
+        entry->callbacks->tx_complete(huart, entry->context);
+    }
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    uart_dispatch_entry_t *entry = uart_dispatch_find(huart);
+    if (entry != NULL && entry->callbacks->rx_complete != NULL)
+    {
+        entry->callbacks->rx_complete(huart, entry->context);
+    }
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
+{
+    uart_dispatch_entry_t *entry = uart_dispatch_find(huart);
+    if (entry != NULL && entry->callbacks->rx_event != NULL)
+    {
+        entry->callbacks->rx_event(huart, size, entry->context);
+    }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    uart_dispatch_entry_t *entry = uart_dispatch_find(huart);
+    if (entry != NULL && entry->callbacks->error != NULL)
+    {
+        entry->callbacks->error(huart, entry->context);
+    }
+}
+
+// A linear scan: the table is a handful of entries and runs in interrupt context.
+static uart_dispatch_entry_t *uart_dispatch_find(UART_HandleTypeDef *huart)
+{
+    for (uint8_t i = 0; i < UART_DISPATCH_SLOTS; i++)
+    {
+        if (uart_dispatch_table[i].huart == huart)
+        {
+            return &uart_dispatch_table[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef UART_DISPATCH_H
+#define UART_DISPATCH_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define UART_DISPATCH_SLOTS 4 // UARTs that can have a driver attached at once.
+
+// HAL's UART callbacks are single weak functions shared by every UART. This table owns them and
+// forwards each one to the driver registered for that UART, so several drivers (or several
+// instances of one driver) can coexist. Do not define the HAL callbacks below anywhere else.
+// Builds with USE_HAL_UART_REGISTER_CALLBACKS = 1 can register per-handle callbacks instead.
+typedef struct
+{
+    void (*tx_complete)(UART_HandleTypeDef *huart, void *context);             // HAL_UART_TxCpltCallback
+    void (*rx_complete)(UART_HandleTypeDef *huart, void *context);             // HAL_UART_RxCpltCallback
+    void (*rx_event)(UART_HandleTypeDef *huart, uint16_t size, void *context); // HAL_UARTEx_RxEventCallback
+    void (*error)(UART_HandleTypeDef *huart, void *context);                   // HAL_UART_ErrorCallback
+} uart_dispatch_callbacks_t;
+
+// Route huart's callbacks to callbacks (any member may be NULL). Registering the same UART again
+// replaces its entry. callbacks must stay valid while registered.
+HAL_StatusTypeDef UART_Dispatch_Register(UART_HandleTypeDef *huart, const uart_dispatch_callbacks_t *callbacks, void *context);
+void UART_Dispatch_Unregister(UART_HandleTypeDef *huart);
+
+#endif
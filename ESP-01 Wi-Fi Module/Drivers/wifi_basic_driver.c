@@ -1,243 +1,1438 @@
 #include "wifi_basic_driver.h"
+#include "wifi_retry.h"
+#include "uart_dispatch.h"
+#include <stdlib.h>
 
-static UART_HandleTypeDef *wifi_uart;
-static uint8_t wifi_rx_buffer[WIFI_RX_BUF_LEN];            // Primary buffer used to receive data.
-static uint8_t wifi_rx_shadow_buffer[WIFI_RX_BUF_LEN];     // Staging buffer used while parsing responses.
-volatile uint8_t wifi_rx_ready = 0;                        // Tracks whether a response has arrived.
-volatile uint16_t wifi_rx_size = 0;                        // Number of bytes received from the module.
-volatile uint8_t wifi_tx_done = 1;                         // Tracks whether a transmission is finished.
-volatile uint8_t wifi_response_ready = 0;
+#if (WIFI_RX_RING_LEN & (WIFI_RX_RING_LEN - 1U)) != 0
+#error "WIFI_RX_RING_LEN must be a power of two"
+#endif
 
-// The interrupt handlers are weak by default, so the driver owns them instead of main.c.
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
-// Once HAL_UART_Transmit_IT finishes transmitting bytes, HAL raises the TC interrupt and calls
-// this callback to mark the UART as free.
+#define WIFI_RX_RING_MASK (WIFI_RX_RING_LEN - 1U)
+
+#if WIFI_TRANSPORT != WIFI_TRANSPORT_IT && WIFI_TRANSPORT != WIFI_TRANSPORT_DMA
+#error "WIFI_TRANSPORT must be WIFI_TRANSPORT_IT or WIFI_TRANSPORT_DMA"
+#endif
+
+typedef struct
+{
+    const char *text;
+    wifi_event_t event;
+} wifi_token_t;
+
+// Whole-line responses the tokenizer turns into typed events.
+static const wifi_token_t wifi_tokens[] = {
+    {"OK", WIFI_EVENT_OK},
+    {"ERROR", WIFI_EVENT_ERROR},
+    {"FAIL", WIFI_EVENT_FAIL},
+    {"SEND OK", WIFI_EVENT_SEND_OK},
+    {"SEND FAIL", WIFI_EVENT_SEND_FAIL},
+    {">", WIFI_EVENT_PROMPT},
+    {"+IPD", WIFI_EVENT_IPD},
+    {"WIFI DISCONNECT", WIFI_EVENT_WIFI_DISCONNECT},
+    {"WIFI CONNECTED", WIFI_EVENT_WIFI_CONNECTED},
+    {"WIFI GOT IP", WIFI_EVENT_WIFI_GOT_IP},
+    {"CONNECT", WIFI_EVENT_CONNECT},
+    {"CLOSED", WIFI_EVENT_CLOSED},
+};
+
+// Lets the blocking wrappers wait for their own queue entry.
+typedef struct
+{
+    volatile uint8_t done;
+    volatile wifi_status_t status;
+} wifi_command_sync_t;
+
+#define WIFI_TX_TIMEOUT_MS 5000U // Upper bound for a raw transmit without an expected reply.
+
+static void wifi_rx_arm(wifi_handle_t *wifi);
+static void wifi_uart_reconfigure(wifi_handle_t *wifi, uint32_t baud_rate);
+static wifi_status_t wifi_verify_link(wifi_handle_t *wifi);
+static void wifi_rx_store(wifi_handle_t *wifi, const uint8_t *data, uint16_t size);
+static void wifi_transmit(wifi_handle_t *wifi, const uint8_t *data, uint16_t length);
+static uint8_t wifi_rx_pop(wifi_handle_t *wifi, uint8_t *byte);
+static void wifi_retire_input(wifi_handle_t *wifi);
+static wifi_status_t wifi_enqueue(wifi_handle_t *wifi, const char *text, const uint8_t *data, uint16_t length, const uint8_t *payload,
+                                  uint16_t payload_length, const char *expected, uint32_t timeout_ms, char *capture, uint16_t capture_len,
+                                  wifi_command_cb_t callback, void *context);
+static void wifi_command_start(wifi_handle_t *wifi);
+static void wifi_command_complete(wifi_handle_t *wifi, wifi_status_t status);
+static uint8_t wifi_command_match(wifi_handle_t *wifi, wifi_event_t event, wifi_status_t *status);
+static void wifi_command_sync_done(wifi_status_t status, void *context);
+static wifi_status_t wifi_run_command(wifi_handle_t *wifi, const uint8_t *data, uint16_t length, const uint8_t *payload,
+                                      uint16_t payload_length, const char *expected, uint32_t timeout_ms, char *capture,
+                                      uint16_t capture_len);
+static wifi_event_t wifi_parse_byte(wifi_handle_t *wifi, char c);
+static wifi_event_t wifi_parse_next(wifi_handle_t *wifi);
+static wifi_event_t wifi_classify_line(wifi_handle_t *wifi, const char *line);
+static wifi_event_t wifi_token_to_event(const char *token);
+static uint8_t wifi_metric_classify(const uint8_t *data, uint16_t length);
+static void wifi_metric_record(wifi_latency_t *latency, wifi_status_t status, uint32_t elapsed_ms);
+static uint8_t wifi_is_ipv4(const char *text);
+static wifi_status_t wifi_copy_ip(const char *source, char *ip, uint16_t ip_len);
+static wifi_dns_entry_t *wifi_dns_find(wifi_handle_t *wifi, const char *host);
+static wifi_dns_entry_t *wifi_dns_slot(wifi_handle_t *wifi);
+
+// The UART callbacks arrive through the shared dispatch table, which passes the instance along.
+// Once HAL_UART_Transmit_IT/_DMA finishes transmitting bytes, HAL raises the TC interrupt; mark the UART as free.
+static void wifi_uart_tx_complete(UART_HandleTypeDef *huart, void *context)
+{
+    (void)huart;
+    wifi_handle_t *wifi = (wifi_handle_t *)context;
+    wifi->tx_done = 1;
+}
+
+#if WIFI_TRANSPORT == WIFI_TRANSPORT_DMA
+// With circular DMA, HAL calls this on half-transfer, transfer-complete and IDLE. size is the DMA write
+// position inside rx_buffer, so only the bytes between the last position and this one are new.
+// The DMA keeps running; nothing is re-armed.
+static void wifi_uart_rx_event(UART_HandleTypeDef *huart, uint16_t size, void *context)
 {
-    if (huart == wifi_uart)
+    (void)huart;
+    wifi_handle_t *wifi = (wifi_handle_t *)context;
+    wifi->stats.rx_irqs++;
+    if (size > wifi->rx_dma_pos)
     {
-        wifi_tx_done = 1; // Mark transmission as complete when the target UART matches.
+        wifi_rx_store(wifi, &wifi->rx_buffer[wifi->rx_dma_pos], (uint16_t)(size - wifi->rx_dma_pos));
     }
+    wifi->rx_dma_pos = (size >= WIFI_RX_BUF_LEN) ? 0U : size; // Transfer complete wraps to the start.
 }
+#else
+// HAL calls this after IDLE or buffer-full events. The burst is appended to the ring and reception is
+// re-armed straight away, so a second burst never overwrites one the parser has not read.
+static void wifi_uart_rx_event(UART_HandleTypeDef *huart, uint16_t size, void *context)
+{
+    (void)huart;
+    wifi_handle_t *wifi = (wifi_handle_t *)context;
+    wifi->stats.rx_irqs += (uint32_t)size + 1U; // One RXNE interrupt per byte, plus the IDLE/full event.
+    wifi_rx_store(wifi, wifi->rx_buffer, size);
+    wifi_rx_arm(wifi);
+}
+#endif
 
-void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
-// HAL calls this callback after IDLE or buffer-full events. The handler null-terminates data so
-// string functions remain safe.
+// ORE, FE and NE make HAL abort ReceiveToIdle (IT or circular DMA). Without a re-arm the module
+// would go deaf until reset, so count the error and restart reception. Errors HAL treats as
+// non-blocking leave reception running, and then there is nothing to restart.
+static void wifi_uart_error(UART_HandleTypeDef *huart, void *context)
 {
-    if (huart == wifi_uart)
+    wifi_handle_t *wifi = (wifi_handle_t *)context;
+    wifi->stats.uart_errors++;
+    if (huart->RxState == HAL_UART_STATE_READY)
     {
-        memcpy(wifi_rx_shadow_buffer, wifi_rx_buffer, size);
-        wifi_rx_shadow_buffer[size] = '\0';
-
-        wifi_rx_size = size;
-        wifi_rx_ready = 1; // Ready to process the response and resume reception.
-
-        memset(wifi_rx_buffer, 0, WIFI_RX_BUF_LEN); // Clear memory before re-arming reception.
-        HAL_UARTEx_ReceiveToIdle_IT(wifi_uart, wifi_rx_buffer, WIFI_RX_BUF_LEN);
+        wifi_rx_arm(wifi); // Also restarts the DMA read position.
     }
 }
 
-// Initialize the ESP-01 module with basic defaults.
-void WiFi_Init(UART_HandleTypeDef *huart)
+static const uart_dispatch_callbacks_t wifi_uart_callbacks = {
+    .tx_complete = wifi_uart_tx_complete,
+    .rx_complete = NULL,
+    .rx_event = wifi_uart_rx_event,
+    .error = wifi_uart_error,
+};
+
+// Initialize the ESP-01 module with basic defaults. Each module needs its own handle and UART.
+wifi_status_t WiFi_Init(wifi_handle_t *wifi, UART_HandleTypeDef *huart)
 {
-    wifi_uart = huart;
-    HAL_UARTEx_ReceiveToIdle_IT(wifi_uart, wifi_rx_buffer, WIFI_RX_BUF_LEN);
+    if (wifi == NULL || huart == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    memset(wifi, 0, sizeof(*wifi));
+    wifi->uart = huart;
+    wifi->parse_state = WIFI_PARSE_LINE;
+    wifi->ipd_link = WIFI_LINK_SINGLE;
+    wifi->event_link = WIFI_LINK_SINGLE;
+    wifi->station_state = WIFI_STATION_DISCONNECTED;
+    wifi->tx_done = 1;
+    wifi->dns_ttl_ms = WIFI_DNS_TTL_MS;
+    if (UART_Dispatch_Register(huart, &wifi_uart_callbacks, wifi) != HAL_OK)
+    {
+        WIFI_LOG(DLOG_WIFI_INIT_NO_SLOT);
+        return WIFI_ERROR;
+    }
+    wifi_rx_arm(wifi);
     // Start receiving bytes into the buffer so HAL can trigger HAL_UARTEx_RxEventCallback on IDLE.
     HAL_Delay(1000);
-    WiFi_Send_Command("AT\r\n", "OK", 1000);
-    WiFi_Send_Command("AT+CWMODE=1\r\n", "OK", 1000);
-    printf("Wi-Fi module ready in STA mode. \r\n");
+    WiFi_Send_Command(wifi, "AT\r\n", "OK", 1000);
+#if WIFI_INIT_BAUD != 0
+    if (WiFi_SetBaudRate(wifi, WIFI_INIT_BAUD) != WIFI_OK)
+    {
+        WIFI_LOG(DLOG_WIFI_INIT_BAUD_KEPT, wifi->uart->Init.BaudRate);
+    }
+#endif
+    wifi_status_t status = WiFi_Send_Command(wifi, "AT+CWMODE=1\r\n", "OK", 1000);
+    WIFI_LOG(DLOG_WIFI_READY);
+    return status;
 }
 
-// Send an AT command to the ESP8266 module.
-wifi_status_t WiFi_Send_Command(const char *Command, const char *expected, uint32_t timeout_ms)
+// The module answers OK at the old rate and switches right after, so the STM32 side follows only
+// once that OK is in. If AT gets no answer at the new rate, the module is asked (blind, at the new
+// rate) to go back, and both ends return to the previous rate.
+wifi_status_t WiFi_SetBaudRate(wifi_handle_t *wifi, uint32_t baud_rate)
 {
-    if (Command == NULL || expected == NULL)
+    if (wifi == NULL || wifi->uart == NULL || baud_rate == 0)
     {
         return WIFI_ERROR;
     }
-    if (!wifi_tx_done) // Check whether UART is available for a new command.
+    if (wifi->cmd_count > 0)
     {
-        return WIFI_BUSY;
+        return WIFI_BUSY; // Queued commands would straddle the switch.
+    }
+
+    uint32_t previous = wifi->uart->Init.BaudRate;
+    if (baud_rate == previous)
+    {
+        return WIFI_OK;
+    }
+
+    char cmd[48];
+    snprintf(cmd, sizeof(cmd), "AT+UART_CUR=%lu,8,1,0,0\r\n", (unsigned long)baud_rate);
+    wifi_status_t status = WiFi_Send_Command(wifi, cmd, "OK", 1000);
+    if (status != WIFI_OK)
+    {
+        return status; // Module refused the rate and is still on the old one.
+    }
+
+    HAL_Delay(5); // Let the module finish switching.
+    wifi_uart_reconfigure(wifi, baud_rate);
+    if (wifi_verify_link(wifi) == WIFI_OK)
+    {
+        WIFI_LOG(DLOG_WIFI_BAUD_OK, baud_rate);
+        return WIFI_OK;
+    }
+
+    WIFI_LOG(DLOG_WIFI_BAUD_FALLBACK, baud_rate);
+    snprintf(cmd, sizeof(cmd), "AT+UART_CUR=%lu,8,1,0,0\r\n", (unsigned long)previous);
+    WiFi_Send_Command(wifi, cmd, "OK", 200); // The module may hear this even if its reply is unreadable here.
+    HAL_Delay(5);
+    wifi_uart_reconfigure(wifi, previous);
+    wifi_verify_link(wifi);
+    return WIFI_ERROR;
+}
+
+// Number of received bytes the parser has not consumed yet.
+uint16_t WiFi_Available(wifi_handle_t *wifi)
+{
+    return (uint16_t)(wifi->rx_head - wifi->rx_tail);
+}
+
+// Drain up to max_len bytes from the receive ring.
+uint16_t WiFi_Read(wifi_handle_t *wifi, uint8_t *out, uint16_t max_len)
+{
+    if (out == NULL)
+    {
+        return 0;
+    }
+
+    uint32_t tail = wifi->rx_tail;
+    uint32_t available = wifi->rx_head - tail;
+    uint16_t count = (available < max_len) ? (uint16_t)available : max_len;
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        out[i] = wifi->rx_ring[(tail + i) & WIFI_RX_RING_MASK];
+    }
+    wifi->rx_tail = tail + count; // Hand the slots back to the RX callback.
+
+    return count;
+}
+
+uint32_t WiFi_GetRxOverruns(wifi_handle_t *wifi)
+{
+    return wifi->rx_overruns;
+}
+
+void WiFi_GetTransportStats(wifi_handle_t *wifi, wifi_transport_stats_t *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = wifi->stats;
+    }
+}
+
+void WiFi_ResetTransportStats(wifi_handle_t *wifi)
+{
+    memset(&wifi->stats, 0, sizeof(wifi->stats));
+}
+
+uint32_t WiFi_GetIrqsPerKB(wifi_handle_t *wifi)
+{
+    uint32_t bytes = wifi->stats.rx_bytes + wifi->stats.tx_bytes;
+    if (bytes == 0)
+    {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)(wifi->stats.rx_irqs + wifi->stats.tx_irqs) * 1024U) / bytes);
+}
+
+void WiFi_GetMetrics(wifi_handle_t *wifi, wifi_metrics_t *metrics)
+{
+    if (metrics == NULL)
+    {
+        return;
+    }
+
+    memcpy(metrics->commands, wifi->latency, sizeof(metrics->commands));
+    metrics->http = wifi->http;
+    metrics->tx_bytes = wifi->stats.tx_bytes;
+    metrics->rx_bytes = wifi->stats.rx_bytes;
+    metrics->rx_overruns = wifi->rx_overruns;
+}
+
+void WiFi_ResetMetrics(wifi_handle_t *wifi)
+{
+    memset(wifi->latency, 0, sizeof(wifi->latency));
+    memset(&wifi->http, 0, sizeof(wifi->http));
+    memset(&wifi->stats, 0, sizeof(wifi->stats));
+    wifi->rx_overruns = 0;
+}
+
+// One line for bytes, one for HTTP, then one per command type that ran:
+// "CIPSEND n=12 err=0 tmo=1 avg=38 max=2000 h=0,0,0,0,0,3,8,0,0,0,0,1" (histogram up to the last non-empty bucket).
+uint16_t WiFi_FormatMetrics(const wifi_metrics_t *metrics, char *out, uint16_t out_len)
+{
+    static const char *const names[WIFI_METRIC_COUNT] = {"CWJAP", "CIPSTART", "CIPSEND", "CIPCLOSE", "OTHER"};
+
+    if (metrics == NULL || out == NULL || out_len == 0)
+    {
+        return 0;
+    }
+
+    const wifi_http_counters_t *http = &metrics->http;
+    size_t used = (size_t)snprintf(out, out_len,
+                                   "bytes tx=%lu rx=%lu ovr=%lu\r\nhttp req=%lu retry=%lu tmo=%lu conn=%lu fast=%lu fail=%lu\r\n",
+                                   (unsigned long)metrics->tx_bytes, (unsigned long)metrics->rx_bytes, (unsigned long)metrics->rx_overruns,
+                                   (unsigned long)http->requests, (unsigned long)http->retries, (unsigned long)http->timeouts,
+                                   (unsigned long)http->connect_failures, (unsigned long)http->fast_fails, (unsigned long)http->failures);
+
+    for (uint8_t i = 0; i < WIFI_METRIC_COUNT && used < out_len; i++)
+    {
+        const wifi_latency_t *latency = &metrics->commands[i];
+        if (latency->count == 0)
+        {
+            continue;
+        }
+
+        used += (size_t)snprintf(out + used, out_len - used, "%s n=%lu err=%lu tmo=%lu avg=%lu max=%lu h=", names[i],
+                                 (unsigned long)latency->count, (unsigned long)latency->errors, (unsigned long)latency->timeouts,
+                                 (unsigned long)(latency->total_ms / latency->count), (unsigned long)latency->max_ms);
+
+        uint8_t last = WIFI_METRIC_BUCKETS - 1U;
+        while (last > 0 && latency->buckets[last] == 0)
+        {
+            last--;
+        }
+        for (uint8_t b = 0; b <= last && used < out_len; b++)
+        {
+            used += (size_t)snprintf(out + used, out_len - used, (b == 0) ? "%lu" : ",%lu", (unsigned long)latency->buckets[b]);
+        }
+        if (used < out_len)
+        {
+            used += (size_t)snprintf(out + used, out_len - used, "\r\n");
+        }
+    }
+
+    return (uint16_t)((used < out_len) ? used : (out_len - 1U));
+}
+
+// Called for unsolicited events (WIFI DISCONNECT, CLOSED, stray replies) while no command owns them.
+void WiFi_SetEventHandler(wifi_handle_t *wifi, wifi_event_handler_t handler, void *context)
+{
+    wifi->event_handler = handler;
+    wifi->event_context = context;
+}
+
+// Called with +IPD payload bytes; without a handler the payload is discarded.
+void WiFi_SetDataHandler(wifi_handle_t *wifi, wifi_data_handler_t handler, void *context)
+{
+    wifi->data_handler = handler;
+    wifi->data_context = context;
+}
+
+wifi_status_t WiFi_Command_Enqueue(wifi_handle_t *wifi, const char *command, const char *expected, uint32_t timeout_ms,
+                                   wifi_command_cb_t callback, void *context)
+{
+    if (command == NULL || expected == NULL)
+    {
+        return WIFI_ERROR;
+    }
+    return wifi_enqueue(wifi, command, NULL, 0, NULL, 0, expected, timeout_ms, NULL, 0, callback, context);
+}
+
+wifi_status_t WiFi_Command_EnqueueRaw(wifi_handle_t *wifi, const uint8_t *data, uint16_t length, const char *expected, uint32_t timeout_ms,
+                                      wifi_command_cb_t callback, void *context)
+{
+    if (data == NULL || length == 0)
+    {
+        return WIFI_ERROR;
     }
+    return wifi_enqueue(wifi, NULL, data, length, NULL, 0, expected, timeout_ms, NULL, 0, callback, context);
+}
 
-    wifi_tx_done = 0; // Mark UART as busy until HAL_UART_TxCpltCallback runs.
-    wifi_rx_ready = 0; // Clear the ready flag before waiting for a new response.
-    memset(wifi_rx_shadow_buffer, 0, sizeof(wifi_rx_shadow_buffer));
+wifi_status_t WiFi_Command_EnqueueSend(wifi_handle_t *wifi, const char *command, const uint8_t *payload, uint16_t length,
+                                       const char *expected, uint32_t timeout_ms, wifi_command_cb_t callback, void *context)
+{
+    if (command == NULL || payload == NULL || length == 0 || expected == NULL || WiFi_IsNetworkDown(wifi))
+    {
+        return WIFI_ERROR;
+    }
+    return wifi_enqueue(wifi, command, NULL, 0, payload, length, expected, timeout_ms, NULL, 0, callback, context);
+}
 
-    HAL_UART_Transmit_IT(wifi_uart, (uint8_t *)Command, (uint16_t)strlen(Command));
-    // Non-blocking transmit that triggers the TC interrupt on completion.
+// Non-blocking: call from the main loop (or a timer hook) as often as convenient.
+void WiFi_Poll(wifi_handle_t *wifi)
+{
+    if (!wifi->cmd_active && wifi->cmd_count > 0 && wifi->tx_done)
+    {
+        wifi_command_start(wifi);
+    }
 
-    uint32_t tickstart = HAL_GetTick();
-    while ((HAL_GetTick() - tickstart) < timeout_ms) // Wait until timeout expires.
+    while (1)
     {
-        if (wifi_rx_ready) // Check whether STM32 received a response.
+        if (wifi->cmd_active && wifi->cmd_queue[wifi->cmd_head].expected[0] == '\0' && wifi->tx_done)
         {
-            if (strstr((char *)wifi_rx_shadow_buffer, expected)) // Verify expected substring.
+            wifi_command_complete(wifi, WIFI_OK); // Raw write with no reply to wait for; later input is not its.
+            break;
+        }
+
+        wifi_event_t event = wifi_parse_next(wifi);
+        if (event == WIFI_EVENT_NONE)
+        {
+            break;
+        }
+
+        wifi_status_t status;
+        if (!wifi->cmd_active)
+        {
+            if (wifi->event_handler != NULL)
             {
-                wifi_rx_ready = 0;
-                return WIFI_OK;
+                wifi->event_handler(event, wifi->line, wifi->event_context);
             }
         }
-        if (strstr((char *)wifi_rx_shadow_buffer, "ERROR")) // Surface module error responses early.
+        else if (wifi_command_match(wifi, event, &status))
         {
-            return WIFI_ERROR;
+            wifi_command_complete(wifi, status);
+            break; // Whatever follows the reply stays queued for the next command (e.g. +IPD after SEND OK).
         }
     }
 
-    return WIFI_TIMEOUT;
+    if (wifi->cmd_active && (HAL_GetTick() - wifi->cmd_started) >= wifi->cmd_queue[wifi->cmd_head].timeout_ms)
+    {
+        wifi_command_complete(wifi, WIFI_TIMEOUT);
+    }
+}
+
+uint8_t WiFi_Command_Pending(wifi_handle_t *wifi)
+{
+    return wifi->cmd_count;
+}
+
+uint8_t WiFi_IsLinkOpen(wifi_handle_t *wifi)
+{
+    return (wifi->link_mask & 0x80U) ? 1U : 0U;
+}
+
+uint8_t WiFi_IsLinkIdOpen(wifi_handle_t *wifi, uint8_t link_id)
+{
+    if (link_id >= WIFI_MAX_LINKS)
+    {
+        return 0;
+    }
+    return (wifi->link_mask & (1U << link_id)) ? 1U : 0U;
+}
+
+// Send an AT command to the ESP8266 module and wait for the expected reply.
+wifi_status_t WiFi_Send_Command(wifi_handle_t *wifi, const char *Command, const char *expected, uint32_t timeout_ms)
+{
+    if (Command == NULL || expected == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    return wifi_run_command(wifi, (const uint8_t *)Command, (uint16_t)strlen(Command), NULL, 0, expected, timeout_ms, NULL, 0);
+}
+
+// Blocking CIPSEND-style exchange; the payload follows the prompt with nothing queued in between.
+wifi_status_t WiFi_Send_Payload(wifi_handle_t *wifi, const char *command, const uint8_t *payload, uint16_t length, const char *expected,
+                                uint32_t timeout_ms)
+{
+    if (command == NULL || payload == NULL || length == 0 || expected == NULL)
+    {
+        return WIFI_ERROR;
+    }
+    if (WiFi_IsNetworkDown(wifi))
+    {
+        return WIFI_ERROR; // No AP: fail now instead of waiting for the module to time out.
+    }
+
+    return wifi_run_command(wifi, (const uint8_t *)command, (uint16_t)strlen(command), payload, length, expected, timeout_ms, NULL, 0);
 }
 
 // Connect directly to the configured Wi-Fi network.
-wifi_status_t WiFi_Connect(const char *ssid, const char *password)
+wifi_status_t WiFi_Connect(wifi_handle_t *wifi, const char *ssid, const char *password)
 {
     char cmd[128];
     char ip[64];
 
     snprintf(cmd, sizeof(cmd), "AT+CWJAP=\"%s\",\"%s\"\r\n", ssid, password);
-    if (WiFi_Send_Command(cmd, "OK", 15000) != WIFI_OK)
+    if (WiFi_Send_Command(wifi, cmd, "OK", 15000) != WIFI_OK)
     {
         return WIFI_ERROR;
     }
 
     memset(ip, 0, sizeof(ip));
-    WiFi_GetIP(ip, sizeof(ip));
+    WiFi_GetIP(wifi, ip, sizeof(ip));
     if (ip[0] != '\0')
     {
-        WIFI_LOG("WiFi_Connect: connected, IP = %s\r\n", ip);
+        WIFI_LOG_TEXT(ip, DLOG_WIFI_CONNECTED);
         return WIFI_OK;
     }
 
-    WIFI_LOG("WiFi_Connect: no IP, connect failed\r\n");
+    WIFI_LOG(DLOG_WIFI_CONNECT_FAILED);
     return WIFI_ERROR;
 }
 
-wifi_status_t WiFi_GetIP(char *out_buf, uint16_t buf_len)
+// The join reply carries WIFI CONNECTED and WIFI GOT IP before OK; the tokenizer timestamps them,
+// so the join is timed and confirmed without polling AT+CIFSR afterwards.
+wifi_status_t WiFi_Connect_Fast(wifi_handle_t *wifi, const char *ssid, const char *password, const wifi_join_cache_t *cache,
+                                const wifi_static_ip_t *static_ip, uint32_t timeout_ms)
 {
-    if (out_buf == NULL || buf_len == 0)
+    if (ssid == NULL || password == NULL)
     {
         return WIFI_ERROR;
     }
 
-    wifi_status_t status = WiFi_Send_Command("AT+CIFSR\r\n", "OK", 2000); // Ask the module for its IP address.
-    if (status != WIFI_OK)
+    uint32_t start = HAL_GetTick();
+    memset(&wifi->join_stats, 0, sizeof(wifi->join_stats));
+
+    if (static_ip != NULL && WiFi_SetStaticIP(wifi, static_ip) != WIFI_OK)
     {
-        return status;
+        return WIFI_ERROR;
     }
 
-    strncpy(out_buf, (char *)wifi_rx_shadow_buffer, buf_len); // Copy the full text into out_buf.
-    while (strstr((char *)wifi_rx_shadow_buffer, "busy p")) // If the Wi-Fi module is busy, retry after 200 ms.
+    char cmd[WIFI_CMD_LEN];
+    int length = 0;
+    wifi_status_t status = WIFI_ERROR;
+    uint8_t use_cache = (cache != NULL && cache->valid && strcmp(cache->ssid, ssid) == 0) ? 1U : 0U;
+    for (uint8_t pass = 0; pass < 2 && status != WIFI_OK; pass++)
     {
-        HAL_Delay(200);
-        status = WiFi_Send_Command("AT+CIFSR\r\n", "OK", 2000);
-        if (status != WIFI_OK)
+        if (pass == 0 && use_cache)
         {
-            return status;
+            // The BSSID pins the AP, so the module does not have to pick one from a full scan.
+            length = snprintf(cmd, sizeof(cmd), "AT+CWJAP=\"%s\",\"%s\",\"%s\"\r\n", ssid, password, cache->bssid);
+        }
+        else if (pass == 0 || use_cache)
+        {
+            length = snprintf(cmd, sizeof(cmd), "AT+CWJAP=\"%s\",\"%s\"\r\n", ssid, password);
+            use_cache = 0;
+        }
+        else
+        {
+            break; // A plain join already failed; retrying it is the caller's decision.
+        }
+        if (length <= 0 || length >= (int)sizeof(cmd))
+        {
+            status = WIFI_ERROR; // Truncated: the command would lose its \r\n and the join would only time out.
+            break;
+        }
+
+        uint32_t elapsed = HAL_GetTick() - start;
+        if (elapsed >= timeout_ms)
+        {
+            status = WIFI_TIMEOUT;
+            break;
+        }
+
+        wifi->station_state = WIFI_STATION_DISCONNECTED;
+        status = WiFi_Send_Command(wifi, cmd, "OK", timeout_ms - elapsed);
+        if (status == WIFI_OK && wifi->station_state != WIFI_STATION_GOT_IP && static_ip == NULL)
+        {
+            status = WIFI_ERROR; // Joined but DHCP has not answered.
+        }
+        if (status == WIFI_OK)
+        {
+            wifi->join_stats.used_cache = use_cache;
+            wifi->join_stats.associated_ms = (wifi->station_state != WIFI_STATION_DISCONNECTED) ? (wifi->station_connected_ms - start) : 0U;
+            if (wifi->station_state == WIFI_STATION_GOT_IP)
+            {
+                wifi->join_stats.got_ip_ms = wifi->station_got_ip_ms - start;
+            }
+            else
+            {
+                wifi->station_state = WIFI_STATION_GOT_IP; // Static address: usable as soon as the join is done.
+                wifi->station_known = 1;
+                wifi->join_stats.got_ip_ms = HAL_GetTick() - start;
+            }
+        }
+        else if (pass == 0 && use_cache)
+        {
+            WIFI_LOG_TEXT(cache->bssid, DLOG_WIFI_FAST_CACHE_MISS);
         }
-        strncpy(out_buf, (char *)wifi_rx_shadow_buffer, buf_len);
     }
 
-    return WIFI_OK;
+    if (status == WIFI_OK)
+    {
+        WIFI_LOG(DLOG_WIFI_FAST_GOT_IP, wifi->join_stats.got_ip_ms);
+    }
+    return status;
 }
 
-wifi_status_t WiFi_SendTCP(const char *ip, uint16_t port, const char *message)
+wifi_status_t WiFi_GetJoinCache(wifi_handle_t *wifi, wifi_join_cache_t *cache)
 {
-    if (ip == NULL || message == NULL)
+    if (cache == NULL)
     {
         return WIFI_ERROR;
     }
 
-    char cmd[128];
-
-    // Open a TCP connection.
-    snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"TCP\",\"%s\",%u\r\n", ip, port); // AT+CIPSTART opens a TCP socket.
-    wifi_status_t result = WiFi_Send_Command(cmd, "OK", 5000);            // Try to open a TCP socket.
-    if (result != WIFI_OK && !strstr((char *)wifi_rx_shadow_buffer, "CONNECT")) // If no connection, return the error.
+    char reply[128];
+    memset(cache, 0, sizeof(*cache));
+    wifi_status_t status = wifi_run_command(wifi, (const uint8_t *)"AT+CWJAP?\r\n", 11, NULL, 0, "OK", 2000, reply, sizeof(reply));
+    if (status != WIFI_OK)
     {
-        return result;
+        return status;
     }
 
-    snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u\r\n", (unsigned int)strlen(message)); // Allocate space in the Wi-Fi module.
-    result = WiFi_Send_Command(cmd, ">", 2000);
-    if (result != WIFI_OK)
+    // +CWJAP:"<ssid>","<bssid>",<channel>,<rssi>
+    const char *p = strstr(reply, "+CWJAP:\"");
+    if (p == NULL)
     {
-        return result;
+        return WIFI_ERROR; // "No AP": not joined.
     }
-
-    result = WiFi_Send_Command(message, "SEND OK", 5000); // Send payload.
-    if (result != WIFI_OK)
+    p += 8;
+    const char *end = strchr(p, '"');
+    if (end == NULL || (size_t)(end - p) >= sizeof(cache->ssid) || strncmp(end, "\",\"", 3) != 0)
     {
-        return result;
+        return WIFI_ERROR;
     }
+    memcpy(cache->ssid, p, (size_t)(end - p));
 
-    WiFi_Send_Command("AT+CIPCLOSE\r\n", "OK", 2000); // Close the connection.
+    p = end + 3;
+    end = strchr(p, '"');
+    if (end == NULL || (size_t)(end - p) >= sizeof(cache->bssid) || end[1] != ',')
+    {
+        return WIFI_ERROR;
+    }
+    memcpy(cache->bssid, p, (size_t)(end - p));
+    cache->channel = (uint8_t)atoi(end + 2);
+    cache->valid = 1;
     return WIFI_OK;
 }
 
-wifi_status_t WiFi_SendRaw(const uint8_t *data, uint16_t length)
+wifi_status_t WiFi_SetStaticIP(wifi_handle_t *wifi, const wifi_static_ip_t *config)
 {
-    while (wifi_tx_done == 0)
+    if (config == NULL || config->ip == NULL)
     {
-        HAL_Delay(1); // Wait until TX line is available.
+        return WIFI_ERROR;
     }
 
-    if (wifi_tx_done == 1)
+    char cmd[128];
+    if (config->gateway != NULL && config->netmask != NULL)
     {
-        wifi_tx_done = 0;                                       // Lock TX line once it is available.
-        HAL_UART_Transmit_IT(wifi_uart, data, length);           // Transmit data to ESP-01 module.
-        while (wifi_tx_done == 0)
-        {
-            HAL_Delay(1); // Wait until data is sent.
-        }
+        snprintf(cmd, sizeof(cmd), "AT+CIPSTA=\"%s\",\"%s\",\"%s\"\r\n", config->ip, config->gateway, config->netmask);
     }
+    else
+    {
+        snprintf(cmd, sizeof(cmd), "AT+CIPSTA=\"%s\"\r\n", config->ip);
+    }
+    return WiFi_Send_Command(wifi, cmd, "OK", 2000); // Also turns the station's DHCP client off.
+}
 
-    return WIFI_OK;
+void WiFi_GetJoinStats(wifi_handle_t *wifi, wifi_join_stats_t *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = wifi->join_stats;
+    }
+}
+
+wifi_station_state_t WiFi_GetStationState(wifi_handle_t *wifi)
+{
+    return wifi->station_state;
 }
 
-wifi_status_t WiFi_Expect(const char *expected, uint32_t timeout_ms)
+// Only a disconnect the driver has actually seen counts; before any station line arrives the module
+// may well be joined on its own (auto-connect), so sends are let through.
+uint8_t WiFi_IsNetworkDown(wifi_handle_t *wifi)
 {
-    wifi_rx_ready = 0;
-    memset(wifi_rx_shadow_buffer, 0, sizeof(wifi_rx_shadow_buffer));
+    return (wifi->station_known && wifi->station_state != WIFI_STATION_GOT_IP) ? 1U : 0U;
+}
 
-    uint32_t start = HAL_GetTick();
-    while (HAL_GetTick() - start < timeout_ms)
+wifi_status_t WiFi_GetIP(wifi_handle_t *wifi, char *out_buf, uint16_t buf_len)
+{
+    if (out_buf == NULL || buf_len == 0)
+    {
+        return WIFI_ERROR;
+    }
+
+    wifi_status_t status;
+    do
     {
-        if (wifi_rx_ready == 1)
+        // Ask the module for its IP address and copy the reply text into out_buf.
+        status = wifi_run_command(wifi, (const uint8_t *)"AT+CIFSR\r\n", 10, NULL, 0, "OK", 2000, out_buf, buf_len);
+        if (status == WIFI_BUSY) // If the Wi-Fi module is busy, retry after 200 ms.
         {
-            WIFI_LOG("WiFi_Expect: received -> %s\r\n", wifi_rx_shadow_buffer);
-            if (strstr((char *)wifi_rx_shadow_buffer, expected))
-            {
-                memset(wifi_rx_shadow_buffer, 0, sizeof(wifi_rx_shadow_buffer));
-                wifi_rx_ready = 0;
-                return WIFI_OK;
-            }
-            if (strstr((char *)wifi_rx_shadow_buffer, "ERROR"))
-            {
-                memset(wifi_rx_shadow_buffer, 0, sizeof(wifi_rx_shadow_buffer));
-                wifi_rx_ready = 0;
-                return WIFI_ERROR;
-            }
-            wifi_rx_ready = 0;
-            memset(wifi_rx_shadow_buffer, 0, sizeof(wifi_rx_shadow_buffer));
+            HAL_Delay(200);
+            continue;
         }
-    }
+        if (status != WIFI_OK)
+        {
+            return status;
+        }
+        break;
+    } while (1);
 
-    WIFI_LOG("WiFi_Expect: TIMEOUT waiting for \"%s\"\r\n", expected);
-    return WIFI_TIMEOUT;
+    return WIFI_OK;
 }
 
-const char *WiFi_StatusToString(wifi_status_t status)
+wifi_status_t WiFi_Resolve(wifi_handle_t *wifi, const char *host, char *ip, uint16_t ip_len)
 {
-    switch (status)
+    if (wifi == NULL || host == NULL || ip == NULL || ip_len == 0)
     {
-    case WIFI_OK:
-        return "OK";
-    case WIFI_ERROR:
-        return "ERROR";
-    case WIFI_TIMEOUT:
-        return "TIMEOUT";
-    case WIFI_BUSY:
-        return "BUSY";
-    default:
-        return "UNKNOWN";
+        return WIFI_ERROR;
+    }
+    if (wifi_is_ipv4(host))
+    {
+        return wifi_copy_ip(host, ip, ip_len);
+    }
+
+    uint32_t now = HAL_GetTick();
+    wifi_dns_entry_t *entry = wifi_dns_find(wifi, host);
+    if (entry != NULL && (now - entry->resolved_ms) < wifi->dns_ttl_ms)
+    {
+        entry->used_ms = now;
+        wifi->dns_stats.hits++;
+        return wifi_copy_ip(entry->ip, ip, ip_len);
+    }
+    wifi->dns_stats.misses++;
+
+    char cmd[WIFI_CMD_LEN];
+    char reply[96];
+    int length = snprintf(cmd, sizeof(cmd), "AT+CIPDOMAIN=\"%s\"\r\n", host);
+    if (length <= 0 || length >= (int)sizeof(cmd))
+    {
+        return WIFI_ERROR;
+    }
+
+    // Reply: +CIPDOMAIN:93.184.216.34 (some firmware quotes the address), then OK.
+    wifi_status_t status = wifi_run_command(wifi, (const uint8_t *)cmd, (uint16_t)length, NULL, 0, "OK", WIFI_DNS_TIMEOUT_MS, reply,
+                                            sizeof(reply));
+    const char *answer = (status == WIFI_OK) ? strstr(reply, "+CIPDOMAIN:") : NULL; // reply is untouched if the queue refused.
+    char address[WIFI_IP_LEN];
+    uint8_t used = 0;
+    if (answer != NULL)
+    {
+        answer += strlen("+CIPDOMAIN:");
+        if (*answer == '"')
+        {
+            answer++;
+        }
+        while (used < sizeof(address) - 1U && ((answer[used] >= '0' && answer[used] <= '9') || answer[used] == '.'))
+        {
+            address[used] = answer[used];
+            used++;
+        }
+    }
+    address[used] = '\0';
+    if (!wifi_is_ipv4(address))
+    {
+        wifi->dns_stats.failures++;
+        return (status != WIFI_OK) ? status : WIFI_ERROR;
+    }
+
+    if (wifi->dns_ttl_ms > 0 && strlen(host) < WIFI_DNS_NAME_LEN)
+    {
+        if (entry == NULL)
+        {
+            entry = wifi_dns_slot(wifi);
+            strcpy(entry->name, host);
+        }
+        strcpy(entry->ip, address);
+        entry->resolved_ms = now;
+        entry->used_ms = now;
+        entry->valid = 1;
+    }
+    return wifi_copy_ip(address, ip, ip_len);
+}
+
+void WiFi_DNS_SetTTL(wifi_handle_t *wifi, uint32_t ttl_ms)
+{
+    if (wifi != NULL)
+    {
+        wifi->dns_ttl_ms = ttl_ms;
+    }
+}
+
+void WiFi_DNS_Flush(wifi_handle_t *wifi)
+{
+    if (wifi != NULL)
+    {
+        memset(wifi->dns, 0, sizeof(wifi->dns));
+    }
+}
+
+void WiFi_DNS_GetStats(wifi_handle_t *wifi, wifi_dns_stats_t *stats)
+{
+    if (wifi != NULL && stats != NULL)
+    {
+        *stats = wifi->dns_stats;
+    }
+}
+
+wifi_status_t WiFi_SendTCP(wifi_handle_t *wifi, const char *ip, uint16_t port, const char *message)
+{
+    if (ip == NULL || message == NULL)
+    {
+        return WIFI_ERROR;
+    }
+    size_t length = 0; // Bounded, so an unterminated buffer is not scanned past what one CIPSEND can carry.
+    while (length <= WIFI_SEND_MAX_LEN && message[length] != '\0')
+    {
+        length++;
+    }
+    if (length == 0 || length > WIFI_SEND_MAX_LEN)
+    {
+        return WIFI_ERROR; // Refused before a link is opened for it.
+    }
+
+    if (WiFi_IsNetworkDown(wifi)) // No AP.
+    {
+        return WIFI_ERROR;
+    }
+
+    // Resolve before asking the breaker, which must hear the outcome of every attempt it allows.
+    char cmd[128];
+    char reply[48];
+    char address[WIFI_IP_LEN];
+    wifi_status_t result = WiFi_Resolve(wifi, ip, address, sizeof(address)); // ip may also be a hostname.
+    if (result != WIFI_OK)
+    {
+        return result;
+    }
+    if (!WiFi_Breaker_Allow(ip, port)) // The host failed repeatedly.
+    {
+        return WIFI_ERROR;
+    }
+
+    // Open a TCP connection.
+    snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"TCP\",\"%s\",%u\r\n", address, port); // AT+CIPSTART opens a TCP socket.
+    reply[0] = '\0'; // Stays empty if the queue refuses the command.
+    result = wifi_run_command(wifi, (const uint8_t *)cmd, (uint16_t)strlen(cmd), NULL, 0, "OK", 5000, reply, sizeof(reply));
+    if (result != WIFI_OK && !strstr(reply, "CONNECT")) // If no connection, return the error.
+    {
+        WiFi_Breaker_Report(ip, port, 0);
+        return result;
+    }
+
+    // One queued exchange: the payload follows the ">" prompt without another trip through the queue.
+    snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u\r\n", (unsigned int)length);
+    result = WiFi_Send_Payload(wifi, cmd, (const uint8_t *)message, (uint16_t)length, "SEND OK", 5000);
+    WiFi_Breaker_Report(ip, port, (result == WIFI_OK) ? 1U : 0U);
+
+    if (WiFi_IsLinkOpen(wifi))
+    {
+        WiFi_Send_Command(wifi, "AT+CIPCLOSE\r\n", "OK", 2000); // Close the connection.
+    }
+    return result;
+}
+
+wifi_status_t WiFi_SendRaw(wifi_handle_t *wifi, const uint8_t *data, uint16_t length)
+{
+    if (data == NULL || length == 0)
+    {
+        return WIFI_ERROR;
+    }
+
+    return wifi_run_command(wifi, data, length, NULL, 0, NULL, WIFI_TX_TIMEOUT_MS, NULL, 0); // Returns once the bytes are on the wire.
+}
+
+// Wait for expected text without discarding what is already queued, so replies that arrived
+// before the call (for example +IPD right after SEND OK) are still seen.
+wifi_status_t WiFi_Expect(wifi_handle_t *wifi, const char *expected, uint32_t timeout_ms)
+{
+    if (expected == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    wifi_status_t status = wifi_run_command(wifi, NULL, 0, NULL, 0, expected, timeout_ms, NULL, 0);
+    if (status == WIFI_TIMEOUT)
+    {
+        WIFI_LOG_TEXT(expected, DLOG_WIFI_EXPECT_TIMEOUT);
+    }
+    return status;
+}
+
+const char *WiFi_StatusToString(wifi_status_t status)
+{
+    switch (status)
+    {
+    case WIFI_OK:
+        return "OK";
+    case WIFI_ERROR:
+        return "ERROR";
+    case WIFI_TIMEOUT:
+        return "TIMEOUT";
+    case WIFI_BUSY:
+        return "BUSY";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+// Start (IT) or restart (DMA) reception into rx_buffer.
+static void wifi_rx_arm(wifi_handle_t *wifi)
+{
+#if WIFI_TRANSPORT == WIFI_TRANSPORT_DMA
+    wifi->rx_dma_pos = 0;
+    HAL_UARTEx_ReceiveToIdle_DMA(wifi->uart, wifi->rx_buffer, WIFI_RX_BUF_LEN); // Runs until aborted; DMA stream must be circular.
+#else
+    HAL_UARTEx_ReceiveToIdle_IT(wifi->uart, wifi->rx_buffer, WIFI_RX_BUF_LEN);
+#endif
+}
+
+// Re-initialise the UART at a new rate. Reception is aborted and re-armed, and any partial input
+// received around the switch is dropped along with the tokenizer state.
+static void wifi_uart_reconfigure(wifi_handle_t *wifi, uint32_t baud_rate)
+{
+    HAL_UART_Abort(wifi->uart);
+    wifi->uart->Init.BaudRate = baud_rate;
+    HAL_UART_Init(wifi->uart);
+
+    wifi->rx_tail = wifi->rx_head;
+    wifi->parse_state = WIFI_PARSE_LINE;
+    wifi->line_len = 0;
+    wifi->tx_done = 1;
+    wifi_rx_arm(wifi);
+}
+
+// A few AT round trips; the first one may still carry noise from the switch.
+static wifi_status_t wifi_verify_link(wifi_handle_t *wifi)
+{
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (WiFi_Send_Command(wifi, "AT\r\n", "OK", 200) == WIFI_OK)
+        {
+            return WIFI_OK;
+        }
+    }
+    return WIFI_ERROR;
+}
+
+// Append received bytes to the ring. Runs in interrupt context.
+static void wifi_rx_store(wifi_handle_t *wifi, const uint8_t *data, uint16_t size)
+{
+    uint32_t head = wifi->rx_head;
+    for (uint16_t i = 0; i < size; i++)
+    {
+        if ((head - wifi->rx_tail) >= WIFI_RX_RING_LEN)
+        {
+            wifi->rx_overruns += (uint32_t)(size - i); // Parser fell behind; count what could not be stored.
+            break;
+        }
+        wifi->rx_ring[head & WIFI_RX_RING_MASK] = data[i];
+        head++;
+    }
+    wifi->stats.rx_bytes += head - wifi->rx_head; // Stored bytes only; the dropped ones are in rx_overruns.
+    wifi->rx_head = head; // Publish the new bytes only after they are written.
+}
+
+// Non-blocking transmit; tx_done is set again from the TX complete callback.
+static void wifi_transmit(wifi_handle_t *wifi, const uint8_t *data, uint16_t length)
+{
+    wifi->tx_done = 0;
+    wifi->stats.tx_bytes += length;
+#if WIFI_TRANSPORT == WIFI_TRANSPORT_DMA
+    wifi->stats.tx_irqs += 2U; // DMA transfer complete, then the UART TC interrupt.
+    HAL_UART_Transmit_DMA(wifi->uart, data, length);
+#else
+    wifi->stats.tx_irqs += (uint32_t)length + 1U; // One TXE interrupt per byte, plus TC.
+    HAL_UART_Transmit_IT(wifi->uart, data, length);
+#endif
+}
+
+// --- Receive path helpers ---
+static uint8_t wifi_rx_pop(wifi_handle_t *wifi, uint8_t *byte)
+{
+    uint32_t tail = wifi->rx_tail;
+    if (tail == wifi->rx_head)
+    {
+        return 0;
+    }
+
+    *byte = wifi->rx_ring[tail & WIFI_RX_RING_MASK];
+    wifi->rx_tail = tail + 1U;
+    return 1;
+}
+
+// Hand every event that is already queued to the event handler; none of it can answer a command
+// that has not been sent yet.
+static void wifi_retire_input(wifi_handle_t *wifi)
+{
+    wifi_event_t event;
+    while ((event = wifi_parse_next(wifi)) != WIFI_EVENT_NONE)
+    {
+        if (wifi->event_handler != NULL)
+        {
+            wifi->event_handler(event, wifi->line, wifi->event_context);
+        }
+    }
+}
+
+// Feed one byte to the line tokenizer; returns an event when a line, prompt, or +IPD header completes.
+static wifi_event_t wifi_parse_byte(wifi_handle_t *wifi, char c)
+{
+    if (wifi->parse_state == WIFI_PARSE_IPD_HEADER)
+    {
+        if (c != ':')
+        {
+            if (wifi->line_len + 1U >= WIFI_LINE_LEN)
+            {
+                wifi->parse_state = WIFI_PARSE_LINE; // Malformed header; resynchronise on the next line.
+                wifi->line_len = 0;
+                return WIFI_EVENT_NONE;
+            }
+            wifi->line[wifi->line_len++] = c;
+            wifi->line[wifi->line_len] = '\0';
+            return WIFI_EVENT_NONE;
+        }
+
+        // "+IPD,<len>" in single-link mode, "+IPD,<link>,<len>" in multi-link mode.
+        char *field = wifi->line + 5;
+        char *comma = strchr(field, ',');
+        char *digits = (comma != NULL) ? comma + 1 : field;
+        char *end;
+        uint32_t length = strtoul(digits, &end, 10);
+        wifi->ipd_link = (comma != NULL) ? (uint8_t)strtoul(field, NULL, 10) : WIFI_LINK_SINGLE;
+
+        wifi->line_len = 0;
+        if (end == digits || length > WIFI_IPD_MAX_LEN)
+        {
+            wifi->parse_state = WIFI_PARSE_LINE; // Garbled header: swallowing that many bytes would eat the replies behind it.
+            return WIFI_EVENT_NONE;
+        }
+        wifi->ipd_remaining = length;
+        wifi->parse_state = (length > 0U) ? WIFI_PARSE_IPD_DATA : WIFI_PARSE_LINE;
+        return WIFI_EVENT_IPD;
+    }
+
+    if (c == '\n')
+    {
+        if (wifi->line_len == 0)
+        {
+            return WIFI_EVENT_NONE; // Blank separator line.
+        }
+        wifi->line_len = 0; // The text stays in line until the next byte is appended.
+        return wifi_classify_line(wifi, wifi->line);
+    }
+    if (c == '\r' || (c == ' ' && wifi->line_len == 0))
+    {
+        return WIFI_EVENT_NONE;
+    }
+
+    if (wifi->line_len + 1U < WIFI_LINE_LEN)
+    {
+        wifi->line[wifi->line_len++] = c;
+        wifi->line[wifi->line_len] = '\0';
+    }
+
+    if (wifi->line_len == 1 && c == '>') // The CIPSEND prompt is not followed by a line ending.
+    {
+        wifi->line_len = 0;
+        return WIFI_EVENT_PROMPT;
+    }
+    if (wifi->line_len == 5 && memcmp(wifi->line, "+IPD,", 5) == 0) // Payload framing has no line ending either.
+    {
+        wifi->parse_state = WIFI_PARSE_IPD_HEADER;
+    }
+    return WIFI_EVENT_NONE;
+}
+
+// Run the tokenizer over queued bytes until it produces an event or the ring is empty.
+static wifi_event_t wifi_parse_next(wifi_handle_t *wifi)
+{
+    while (1)
+    {
+        if (wifi->parse_state == WIFI_PARSE_IPD_DATA)
+        {
+            uint8_t chunk[32];
+            uint16_t want = (wifi->ipd_remaining < sizeof(chunk)) ? (uint16_t)wifi->ipd_remaining : (uint16_t)sizeof(chunk);
+            uint16_t count = WiFi_Read(wifi, chunk, want);
+            if (count == 0)
+            {
+                return WIFI_EVENT_NONE;
+            }
+
+            wifi->ipd_remaining -= count;
+            if (wifi->ipd_remaining == 0)
+            {
+                wifi->parse_state = WIFI_PARSE_LINE;
+            }
+            if (wifi->data_handler != NULL)
+            {
+                wifi->data_handler(wifi->ipd_link, chunk, count, wifi->data_context);
+            }
+            continue;
+        }
+
+        uint8_t byte;
+        if (!wifi_rx_pop(wifi, &byte))
+        {
+            return WIFI_EVENT_NONE;
+        }
+
+        wifi_event_t event = wifi_parse_byte(wifi, (char)byte);
+        if (event == WIFI_EVENT_CONNECT || event == WIFI_EVENT_CLOSED)
+        {
+            uint8_t bit = (wifi->event_link < WIFI_MAX_LINKS) ? (uint8_t)(1U << wifi->event_link) : 0x80U;
+            if (event == WIFI_EVENT_CONNECT)
+            {
+                wifi->link_mask |= bit;
+            }
+            else
+            {
+                wifi->link_mask &= (uint8_t)~bit; // Server-side closes arrive here as well as replies to AT+CIPCLOSE.
+            }
+        }
+        else if (event == WIFI_EVENT_WIFI_DISCONNECT)
+        {
+            wifi->station_state = WIFI_STATION_DISCONNECTED;
+            wifi->station_known = 1;
+        }
+        else if (event == WIFI_EVENT_WIFI_CONNECTED)
+        {
+            wifi->station_state = WIFI_STATION_CONNECTED;
+            wifi->station_connected_ms = HAL_GetTick();
+            wifi->station_known = 1;
+        }
+        else if (event == WIFI_EVENT_WIFI_GOT_IP)
+        {
+            wifi->station_state = WIFI_STATION_GOT_IP;
+            wifi->station_got_ip_ms = HAL_GetTick();
+            wifi->station_known = 1;
+        }
+        if (event != WIFI_EVENT_NONE)
+        {
+            return event;
+        }
+    }
+}
+
+static wifi_event_t wifi_classify_line(wifi_handle_t *wifi, const char *line)
+{
+    if (strncmp(line, "busy ", 5) == 0)
+    {
+        return WIFI_EVENT_BUSY;
+    }
+
+    // Multi-link firmware prefixes the link ID ("0,CLOSED").
+    wifi->event_link = WIFI_LINK_SINGLE;
+    if (line[0] >= '0' && line[0] <= '9' && line[1] == ',')
+    {
+        wifi->event_link = (uint8_t)(line[0] - '0');
+        line += 2;
+    }
+
+    for (uint8_t i = 0; i < sizeof(wifi_tokens) / sizeof(wifi_tokens[0]); i++)
+    {
+        if (strcmp(line, wifi_tokens[i].text) == 0)
+        {
+            return wifi_tokens[i].event;
+        }
+    }
+    return WIFI_EVENT_LINE;
+}
+
+// Map an expected-response string onto a typed event; anything else is matched against text lines.
+static wifi_event_t wifi_token_to_event(const char *token)
+{
+    for (uint8_t i = 0; i < sizeof(wifi_tokens) / sizeof(wifi_tokens[0]); i++)
+    {
+        if (strcmp(token, wifi_tokens[i].text) == 0)
+        {
+            return wifi_tokens[i].event;
+        }
+    }
+    return WIFI_EVENT_LINE;
+}
+
+// --- Command queue helpers ---
+static wifi_status_t wifi_enqueue(wifi_handle_t *wifi, const char *text, const uint8_t *data, uint16_t length, const uint8_t *payload,
+                                  uint16_t payload_length, const char *expected, uint32_t timeout_ms, char *capture, uint16_t capture_len,
+                                  wifi_command_cb_t callback, void *context)
+{
+    if (wifi->cmd_count >= WIFI_CMD_QUEUE_LEN)
+    {
+        return WIFI_BUSY;
+    }
+    if (expected != NULL && strlen(expected) >= WIFI_EXPECT_LEN)
+    {
+        return WIFI_ERROR;
+    }
+
+    wifi_command_t *entry = &wifi->cmd_queue[(wifi->cmd_head + wifi->cmd_count) % WIFI_CMD_QUEUE_LEN];
+    if (text != NULL)
+    {
+        size_t text_len = strlen(text);
+        if (text_len >= WIFI_CMD_LEN)
+        {
+            return WIFI_ERROR;
+        }
+        memcpy(entry->text, text, text_len + 1U); // Asynchronous callers may reuse their buffer right away.
+        data = (const uint8_t *)entry->text;
+        length = (uint16_t)text_len;
+    }
+
+    entry->data = data;
+    entry->length = length;
+    entry->metric = wifi_metric_classify(data, length); // Classified once here, so completion only pays for the counters.
+    entry->payload = payload;
+    entry->payload_length = payload_length;
+    entry->payload_sent = 0;
+    if (expected != NULL)
+    {
+        strcpy(entry->expected, expected);
+        entry->want = wifi_token_to_event(expected);
+    }
+    else
+    {
+        entry->expected[0] = '\0';
+        entry->want = WIFI_EVENT_NONE;
+    }
+    entry->timeout_ms = timeout_ms;
+    entry->capture = capture;
+    entry->capture_len = capture_len;
+    entry->callback = callback;
+    entry->context = context;
+
+    wifi->cmd_count++;
+    return WIFI_OK;
+}
+
+static void wifi_command_start(wifi_handle_t *wifi)
+{
+    wifi_command_t *entry = &wifi->cmd_queue[wifi->cmd_head];
+
+    wifi->cmd_active = 1;
+    wifi->cmd_captured = 0;
+    if (entry->capture != NULL && entry->capture_len > 0)
+    {
+        entry->capture[0] = '\0';
+    }
+
+    if (entry->length > 0)
+    {
+        wifi_retire_input(wifi);
+        wifi_transmit(wifi, entry->data, entry->length);
+    }
+    wifi->cmd_started = HAL_GetTick();
+}
+
+// Retire the head entry, report its result, and immediately start the next one so queued
+// commands go out back to back.
+static void wifi_command_complete(wifi_handle_t *wifi, wifi_status_t status)
+{
+    wifi_command_t *entry = &wifi->cmd_queue[wifi->cmd_head];
+    wifi_command_cb_t callback = entry->callback;
+    void *context = entry->context;
+
+    wifi_metric_record(&wifi->latency[entry->metric], status, HAL_GetTick() - wifi->cmd_started);
+    wifi->cmd_head = (uint8_t)((wifi->cmd_head + 1U) % WIFI_CMD_QUEUE_LEN);
+    wifi->cmd_count--;
+    wifi->cmd_active = 0;
+
+    if (callback != NULL)
+    {
+        callback(status, context);
+    }
+
+    if (!wifi->cmd_active && wifi->cmd_count > 0 && wifi->tx_done)
+    {
+        wifi_command_start(wifi);
+    }
+}
+
+// Offer one event to the active command. Whole-line tokens are compared as typed events and only
+// untyped lines fall back to a short substring test. Returns 1 when the command is finished.
+static uint8_t wifi_command_match(wifi_handle_t *wifi, wifi_event_t event, wifi_status_t *status)
+{
+    wifi_command_t *entry = &wifi->cmd_queue[wifi->cmd_head];
+
+    if (entry->capture != NULL && wifi->cmd_captured < entry->capture_len)
+    {
+        wifi->cmd_captured += (uint16_t)snprintf(entry->capture + wifi->cmd_captured, entry->capture_len - wifi->cmd_captured, "%s\r\n",
+                                                wifi->line);
+    }
+
+    if (event == WIFI_EVENT_PROMPT && entry->payload != NULL && !entry->payload_sent)
+    {
+        entry->payload_sent = 1; // The module is waiting for exactly payload_length bytes.
+        wifi_transmit(wifi, entry->payload, entry->payload_length);
+        return 0;
+    }
+
+    if (entry->want != WIFI_EVENT_NONE && event == entry->want &&
+        (entry->want != WIFI_EVENT_LINE || strstr(wifi->line, entry->expected)))
+    {
+        *status = WIFI_OK;
+        return 1;
+    }
+
+    switch (event)
+    {
+    case WIFI_EVENT_ERROR: // Surface module error responses early.
+    case WIFI_EVENT_FAIL:
+    case WIFI_EVENT_SEND_FAIL:
+        *status = WIFI_ERROR;
+        return 1;
+    case WIFI_EVENT_BUSY:
+        *status = WIFI_BUSY;
+        return 1;
+    case WIFI_EVENT_LINE:
+    case WIFI_EVENT_OK:
+    case WIFI_EVENT_CONNECT:
+        return 0; // Echo and intermediate lines belong to this command.
+    default:
+        if (wifi->event_handler != NULL) // Unsolicited messages still reach the application.
+        {
+            wifi->event_handler(event, wifi->line, wifi->event_context);
+        }
+        return 0;
+    }
+}
+
+static void wifi_command_sync_done(wifi_status_t status, void *context)
+{
+    wifi_command_sync_t *sync = (wifi_command_sync_t *)context;
+    sync->status = status;
+    sync->done = 1;
+}
+
+// Blocking wrapper used by the classic API: queue the exchange behind anything already pending
+// and poll until it finishes. data is used in place, so it only has to live for this call.
+static wifi_status_t wifi_run_command(wifi_handle_t *wifi, const uint8_t *data, uint16_t length, const uint8_t *payload,
+                                      uint16_t payload_length, const char *expected, uint32_t timeout_ms, char *capture,
+                                      uint16_t capture_len)
+{
+    wifi_command_sync_t sync = {0, WIFI_TIMEOUT};
+
+    wifi_status_t status = wifi_enqueue(wifi, NULL, data, length, payload, payload_length, expected, timeout_ms, capture, capture_len,
+                                        wifi_command_sync_done, &sync);
+    if (status != WIFI_OK)
+    {
+        return status;
+    }
+
+    while (!sync.done)
+    {
+        WiFi_Poll(wifi);
+    }
+    return sync.status;
+}
+
+// --- Metrics helpers ---
+// Queries such as AT+CWJAP? are quick and would distort the join histogram, so they count as OTHER.
+static uint8_t wifi_metric_classify(const uint8_t *data, uint16_t length)
+{
+    static const char *const prefixes[WIFI_METRIC_OTHER] = {"AT+CWJAP", "AT+CIPSTART", "AT+CIPSEND", "AT+CIPCLOSE"};
+
+    for (uint8_t i = 0; i < WIFI_METRIC_OTHER; i++)
+    {
+        size_t prefix_len = strlen(prefixes[i]);
+        if (length > prefix_len && memcmp(data, prefixes[i], prefix_len) == 0 && data[prefix_len] != '?')
+        {
+            return i;
+        }
+    }
+    return WIFI_METRIC_OTHER;
+}
+
+static void wifi_metric_record(wifi_latency_t *latency, wifi_status_t status, uint32_t elapsed_ms)
+{
+    uint8_t bucket = 0;
+    for (uint32_t ms = elapsed_ms; ms > 0 && bucket < (WIFI_METRIC_BUCKETS - 1U); ms >>= 1)
+    {
+        bucket++;
+    }
+
+    latency->count++;
+    latency->total_ms += elapsed_ms;
+    latency->buckets[bucket]++;
+    if (elapsed_ms > latency->max_ms)
+    {
+        latency->max_ms = elapsed_ms;
+    }
+    if (status == WIFI_TIMEOUT)
+    {
+        latency->timeouts++;
+    }
+    else if (status != WIFI_OK)
+    {
+        latency->errors++;
+    }
+}
+
+// Four dot-separated decimal numbers of 0..255, nothing else.
+static uint8_t wifi_is_ipv4(const char *text)
+{
+    for (uint8_t part = 0; part < 4; part++)
+    {
+        uint16_t value = 0;
+        uint8_t digits = 0;
+        while (*text >= '0' && *text <= '9')
+        {
+            value = (uint16_t)(value * 10U + (uint16_t)(*text++ - '0'));
+            if (++digits > 3 || value > 255U)
+            {
+                return 0;
+            }
+        }
+        if (digits == 0 || *text != ((part < 3) ? '.' : '\0'))
+        {
+            return 0;
+        }
+        text++;
+    }
+    return 1;
+}
+
+static wifi_status_t wifi_copy_ip(const char *source, char *ip, uint16_t ip_len)
+{
+    size_t length = strlen(source);
+    if (length >= ip_len)
+    {
+        return WIFI_ERROR;
+    }
+    memcpy(ip, source, length + 1U);
+    return WIFI_OK;
+}
+
+static wifi_dns_entry_t *wifi_dns_find(wifi_handle_t *wifi, const char *host)
+{
+    for (uint8_t i = 0; i < WIFI_DNS_CACHE_LEN; i++)
+    {
+        if (wifi->dns[i].valid && strcmp(wifi->dns[i].name, host) == 0)
+        {
+            return &wifi->dns[i];
+        }
+    }
+    return NULL;
+}
+
+// A free entry, else the least recently used one.
+static wifi_dns_entry_t *wifi_dns_slot(wifi_handle_t *wifi)
+{
+    wifi_dns_entry_t *oldest = &wifi->dns[0];
+    for (uint8_t i = 0; i < WIFI_DNS_CACHE_LEN; i++)
+    {
+        if (!wifi->dns[i].valid)
+        {
+            return &wifi->dns[i];
+        }
+        if ((int32_t)(wifi->dns[i].used_ms - oldest->used_ms) < 0)
+        {
+            oldest = &wifi->dns[i];
+        }
     }
+    wifi->dns_stats.evictions++;
+    return oldest;
 }
@@ -6,15 +6,49 @@
 #include <stdio.h>
 #include <string.h>
 
-#define WIFI_DEBUG 1
+// Driver messages go through the Deferred Logger module (deferred_log.h): a call stores a message ID
+// and its raw arguments and returns, so no formatting or console output happens inside command waits.
+// Set to 0 to compile the messages out and drop the dependency.
+#ifndef WIFI_DEBUG
+    #define WIFI_DEBUG 1
+#endif
 
 #if WIFI_DEBUG
-    #define WIFI_LOG(...)   printf(__VA_ARGS__)
+    #include "deferred_log.h"
+    #define WIFI_LOG(...)             DLOG(__VA_ARGS__)
+    #define WIFI_LOG_TEXT(text, ...)  DLOG_TEXT(text, __VA_ARGS__)
 #else
     #define WIFI_LOG(...)
+    #define WIFI_LOG_TEXT(text, ...)
+#endif
+
+// UART transport: WIFI_TRANSPORT_IT takes one interrupt per byte; WIFI_TRANSPORT_DMA needs a DMA
+// stream on the UART (RX in circular mode, TX in normal mode) and only interrupts on half/full/IDLE.
+#define WIFI_TRANSPORT_IT  0
+#define WIFI_TRANSPORT_DMA 1
+#ifndef WIFI_TRANSPORT
+    #define WIFI_TRANSPORT WIFI_TRANSPORT_IT
 #endif
 
-#define WIFI_RX_BUF_LEN 128
+#define WIFI_RX_BUF_LEN 128      // Landing buffer for each IT burst, or the circular DMA buffer.
+#define WIFI_RX_RING_LEN 1024    // Byte ring drained by the parser; must be a power of two.
+#define WIFI_LINE_LEN 96         // Longest response line kept by the tokenizer; longer lines are truncated.
+#define WIFI_IPD_MAX_LEN 2048    // Largest +IPD frame the AT firmware sends; a bigger length is line noise.
+#define WIFI_SEND_MAX_LEN 2048   // Largest single AT+CIPSEND the module accepts.
+#define WIFI_CMD_QUEUE_LEN 4     // Commands that can wait behind the one in flight.
+#define WIFI_CMD_LEN 144         // Longest AT command text; fits CWJAP with a 32-byte SSID, 63-byte passphrase and BSSID.
+#define WIFI_EXPECT_LEN 24       // Longest expected-response token.
+#define WIFI_MAX_LINKS 5         // Link IDs 0..4 available with AT+CIPMUX=1.
+#define WIFI_LINK_SINGLE 0xFFU   // Link ID reported when the module runs with AT+CIPMUX=0.
+#define WIFI_METRIC_BUCKETS 16   // Latency buckets: 0 ms, then [2^(n-1), 2^n) ms; the last one takes everything above.
+#define WIFI_IP_LEN 16           // "255.255.255.255" plus the terminator.
+#define WIFI_DNS_CACHE_LEN 4     // Hostnames whose addresses are kept; the least recently used one is replaced.
+#define WIFI_DNS_NAME_LEN 48     // Longest cached hostname, including the terminator; longer names are resolved every time.
+#define WIFI_DNS_TTL_MS 300000U  // Default answer lifetime; AT+CIPDOMAIN does not report the record's own TTL.
+#define WIFI_DNS_TIMEOUT_MS 5000U
+#ifndef WIFI_INIT_BAUD
+    #define WIFI_INIT_BAUD 0     // Rate WiFi_Init negotiates with AT+UART_CUR (e.g. 921600); 0 keeps the CubeMX rate.
+#endif
 
 typedef enum
 {
@@ -24,13 +58,279 @@ typedef enum
     WIFI_BUSY
 } wifi_status_t;
 
-void WiFi_Init(UART_HandleTypeDef *huart);
-wifi_status_t WiFi_Send_Command(const char *cmd, const char *expected, uint32_t timeout_ms);
-wifi_status_t WiFi_Connect(const char *ssid, const char *password);
-wifi_status_t WiFi_GetIP(char *out_buf, uint16_t buf_len);
-wifi_status_t WiFi_SendTCP(const char *ip, uint16_t port, const char *message);
-wifi_status_t WiFi_SendRaw(const uint8_t *data, uint16_t length);
-wifi_status_t WiFi_Expect(const char *expected, uint32_t timeout_ms);
+// Typed tokens produced by the response tokenizer, one per line (or per prompt / +IPD header).
+typedef enum
+{
+    WIFI_EVENT_NONE,
+    WIFI_EVENT_OK,
+    WIFI_EVENT_ERROR,
+    WIFI_EVENT_FAIL,
+    WIFI_EVENT_SEND_OK,
+    WIFI_EVENT_SEND_FAIL,
+    WIFI_EVENT_PROMPT,          // "> " after AT+CIPSEND; the module is waiting for payload bytes.
+    WIFI_EVENT_IPD,             // "+IPD,n:" header; the n payload bytes go to the data handler.
+    WIFI_EVENT_BUSY,            // "busy p..." / "busy s...": the module ignored the command.
+    WIFI_EVENT_WIFI_DISCONNECT,
+    WIFI_EVENT_WIFI_CONNECTED,
+    WIFI_EVENT_WIFI_GOT_IP,
+    WIFI_EVENT_CONNECT,         // "CONNECT" after AT+CIPSTART: the link is open.
+    WIFI_EVENT_CLOSED,
+    WIFI_EVENT_LINE             // Any other text line (echo, +CIFSR:..., +CIPDOMAIN:..., ...).
+} wifi_event_t;
+
+// Receives events that arrive while no command is waiting for them. line holds the raw text.
+typedef void (*wifi_event_handler_t)(wifi_event_t event, const char *line, void *context);
+// Receives +IPD payload bytes as they are parsed, tagged with the link they arrived on.
+typedef void (*wifi_data_handler_t)(uint8_t link_id, const uint8_t *data, uint16_t length, void *context);
+// Completion callback for queued commands; runs from WiFi_Poll(), never from an interrupt.
+typedef void (*wifi_command_cb_t)(wifi_status_t status, void *context);
+
+// Interrupt and byte counters for the UART link, to compare the IT and DMA transports.
+typedef struct
+{
+    uint32_t rx_irqs;
+    uint32_t tx_irqs;
+    uint32_t rx_bytes;          // Bytes stored in the receive ring; bytes dropped when it was full are not included.
+    uint32_t tx_bytes;
+    uint32_t uart_errors;       // Overrun, framing or noise errors reported by HAL; reception is re-armed after each.
+} wifi_transport_stats_t;
+
+// AT commands with their own latency histogram. Everything else, raw writes included, counts as OTHER.
+typedef enum
+{
+    WIFI_METRIC_CWJAP,
+    WIFI_METRIC_CIPSTART,
+    WIFI_METRIC_CIPSEND,        // Covers the prompt, the payload and SEND OK.
+    WIFI_METRIC_CIPCLOSE,
+    WIFI_METRIC_OTHER,
+    WIFI_METRIC_COUNT
+} wifi_metric_cmd_t;
+
+// Time from a command going out to its final reply, for one command type.
+typedef struct
+{
+    uint32_t count;
+    uint32_t errors;            // ERROR, FAIL, SEND FAIL and busy replies.
+    uint32_t timeouts;
+    uint32_t total_ms;
+    uint32_t max_ms;
+    uint32_t buckets[WIFI_METRIC_BUCKETS];
+} wifi_latency_t;
+
+// Request-level counters, kept by the HTTP helpers.
+typedef struct
+{
+    uint32_t requests;
+    uint32_t retries;           // Attempts after the first one.
+    uint32_t timeouts;          // Attempts that gave up waiting for the response.
+    uint32_t connect_failures;  // AT+CIPSTART did not open the link.
+    uint32_t fast_fails;        // Rejected by an open circuit breaker without touching the radio.
+    uint32_t failures;          // Requests that returned an error in the end.
+} wifi_http_counters_t;
+
+// Snapshot returned by WiFi_GetMetrics.
+typedef struct
+{
+    wifi_latency_t commands[WIFI_METRIC_COUNT];
+    wifi_http_counters_t http;
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t rx_overruns;
+} wifi_metrics_t;
+
+// Station state, tracked from the WIFI DISCONNECT / WIFI CONNECTED / WIFI GOT IP lines.
+typedef enum
+{
+    WIFI_STATION_DISCONNECTED,
+    WIFI_STATION_CONNECTED,     // Associated with the AP, no IP yet.
+    WIFI_STATION_GOT_IP
+} wifi_station_state_t;
+
+// The AP the module last joined. Keep it (e.g. in flash) and pass it to WiFi_Connect_Fast after a reset.
+typedef struct
+{
+    char ssid[33];
+    char bssid[18];             // "aa:bb:cc:dd:ee:ff"
+    uint8_t channel;
+    uint8_t valid;
+} wifi_join_cache_t;
+
+// Fixed station address for AT+CIPSTA; skips DHCP.
+typedef struct
+{
+    const char *ip;
+    const char *gateway;
+    const char *netmask;
+} wifi_static_ip_t;
+
+// One cached AT+CIPDOMAIN answer.
+typedef struct
+{
+    char name[WIFI_DNS_NAME_LEN];
+    char ip[WIFI_IP_LEN];
+    uint32_t resolved_ms;       // Tick of the lookup; the entry expires dns_ttl_ms later.
+    uint32_t used_ms;           // Tick of the last hit, for LRU replacement.
+    uint8_t valid;
+} wifi_dns_entry_t;
+
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;            // Lookups that went to the module (first use or expired).
+    uint32_t failures;          // Lookups the module could not answer.
+    uint32_t evictions;         // Valid entries replaced to make room.
+} wifi_dns_stats_t;
+
+// Timing of the last WiFi_Connect_Fast, measured from the call (so AT+CIPSTA is included).
+typedef struct
+{
+    uint32_t associated_ms;     // Until WIFI CONNECTED; 0 if it never arrived.
+    uint32_t got_ip_ms;         // Until WIFI GOT IP (or OK with a static IP).
+    uint8_t used_cache;         // 1 when the cached BSSID was used.
+} wifi_join_stats_t;
+
+typedef enum
+{
+    WIFI_PARSE_LINE,            // Collecting a CR/LF terminated response line.
+    WIFI_PARSE_IPD_HEADER,      // Collecting "+IPD,<len>:" up to the colon.
+    WIFI_PARSE_IPD_DATA         // Forwarding payload bytes to the data handler.
+} wifi_parse_state_t;
+
+// One queued AT exchange: bytes to send and the reply that completes it.
+typedef struct
+{
+    char text[WIFI_CMD_LEN];        // Copied command text for asynchronous callers.
+    const uint8_t *data;            // Bytes to transmit (text, or caller memory for raw entries); NULL to only wait.
+    uint16_t length;
+    const uint8_t *payload;         // Written after the '>' prompt (CIPSEND); NULL for plain commands.
+    uint16_t payload_length;
+    uint8_t payload_sent;
+    char expected[WIFI_EXPECT_LEN]; // Empty when the entry completes once its bytes are transmitted.
+    wifi_event_t want;              // Typed form of expected.
+    uint32_t timeout_ms;
+    uint8_t metric;                 // wifi_metric_cmd_t the latency is recorded under.
+    char *capture;                  // Optional copy of the text lines seen while the entry is active.
+    uint16_t capture_len;
+    wifi_command_cb_t callback;
+    void *context;
+} wifi_command_t;
+
+// Everything one ESP-01 needs: UART, buffers, tokenizer and command queue. Allocate one per module
+// (statically, it holds a few KB of buffers) and pass it to every call. Fields are private.
+typedef struct
+{
+    UART_HandleTypeDef *uart;
+    uint8_t rx_buffer[WIFI_RX_BUF_LEN];     // Landing buffer for the current burst (IT) or DMA ring.
+#if WIFI_TRANSPORT == WIFI_TRANSPORT_DMA
+    uint16_t rx_dma_pos;                    // First byte of rx_buffer not yet copied to the ring.
+#endif
+    wifi_transport_stats_t stats;
+    uint8_t rx_ring[WIFI_RX_RING_LEN];      // Bytes waiting for the parser.
+    volatile uint32_t rx_head;              // Write index, only advanced by the RX callback.
+    volatile uint32_t rx_tail;              // Read index, only advanced by the parser.
+    volatile uint32_t rx_overruns;          // Bytes dropped because the ring was full.
+    volatile uint8_t tx_done;               // Tracks whether a transmission is finished.
+
+    wifi_parse_state_t parse_state;
+    char line[WIFI_LINE_LEN];               // Current (or last completed) response line.
+    uint16_t line_len;
+    uint32_t ipd_remaining;                 // Payload bytes still owed by the current +IPD frame.
+    uint8_t ipd_link;                       // Link the current +IPD payload belongs to.
+    uint8_t event_link;                     // Link prefix of the last classified line ("0,CLOSED").
+    uint8_t link_mask;                      // Open links seen in the stream; bit 7 is the single link.
+    wifi_station_state_t station_state;
+    uint8_t station_known;                  // Set once a station line has been seen since WiFi_Init.
+    uint32_t station_connected_ms;          // Tick of the last WIFI CONNECTED.
+    uint32_t station_got_ip_ms;             // Tick of the last WIFI GOT IP.
+    wifi_join_stats_t join_stats;
+    wifi_event_handler_t event_handler;
+    void *event_context;
+    wifi_data_handler_t data_handler;
+    void *data_context;
+    const void *link_owner;                 // Helper object (e.g. an HTTP session) the single link was opened for.
+    uint8_t passthrough;                    // Transparent transmission is on (wifi_stream.h): every byte is data.
+
+    wifi_command_t cmd_queue[WIFI_CMD_QUEUE_LEN];
+    uint8_t cmd_head;                       // Slot of the active (or next) command.
+    uint8_t cmd_count;                      // Entries in flight plus entries waiting.
+    uint8_t cmd_active;                     // 1 once the head entry has been started.
+    uint32_t cmd_started;                   // Tick when the head entry was started.
+    uint16_t cmd_captured;
+
+    wifi_latency_t latency[WIFI_METRIC_COUNT];
+    wifi_http_counters_t http;
+
+    wifi_dns_entry_t dns[WIFI_DNS_CACHE_LEN];
+    uint32_t dns_ttl_ms;
+    wifi_dns_stats_t dns_stats;
+} wifi_handle_t;
+
+wifi_status_t WiFi_Init(wifi_handle_t *wifi, UART_HandleTypeDef *huart);
+// Move both ends of the link to baud_rate (AT+UART_CUR, not saved in flash) and verify with AT.
+// Falls back to the previous rate and returns WIFI_ERROR if the new rate does not answer.
+wifi_status_t WiFi_SetBaudRate(wifi_handle_t *wifi, uint32_t baud_rate);
+wifi_status_t WiFi_Send_Command(wifi_handle_t *wifi, const char *cmd, const char *expected, uint32_t timeout_ms);
+wifi_status_t WiFi_Connect(wifi_handle_t *wifi, const char *ssid, const char *password);
+// Join using a cached BSSID (falls back to a normal join if that AP is gone) and optionally a
+// static IP. Returns once the module reports an address; no AT+CIFSR polling.
+wifi_status_t WiFi_Connect_Fast(wifi_handle_t *wifi, const char *ssid, const char *password, const wifi_join_cache_t *cache,
+                                const wifi_static_ip_t *static_ip, uint32_t timeout_ms);
+// Read the current AP's SSID, BSSID and channel (AT+CWJAP?) for the next fast join.
+wifi_status_t WiFi_GetJoinCache(wifi_handle_t *wifi, wifi_join_cache_t *cache);
+wifi_status_t WiFi_SetStaticIP(wifi_handle_t *wifi, const wifi_static_ip_t *config);
+void WiFi_GetJoinStats(wifi_handle_t *wifi, wifi_join_stats_t *stats);
+wifi_station_state_t WiFi_GetStationState(wifi_handle_t *wifi);
+// 1 once the module has reported losing the AP and not yet regained an IP. Sends fail fast meanwhile.
+uint8_t WiFi_IsNetworkDown(wifi_handle_t *wifi);
+wifi_status_t WiFi_GetIP(wifi_handle_t *wifi, char *out_buf, uint16_t buf_len);
+// Turn host into a dotted IPv4 address for AT+CIPSTART. Literal addresses are copied as they are;
+// names are answered from the cache, or looked up with AT+CIPDOMAIN once their TTL has run out.
+// Every helper that opens a link calls this, so they all accept hostnames.
+wifi_status_t WiFi_Resolve(wifi_handle_t *wifi, const char *host, char *ip, uint16_t ip_len);
+// Lifetime of cached answers; 0 turns the cache off.
+void WiFi_DNS_SetTTL(wifi_handle_t *wifi, uint32_t ttl_ms);
+// Forget every cached answer, e.g. after joining a different network.
+void WiFi_DNS_Flush(wifi_handle_t *wifi);
+void WiFi_DNS_GetStats(wifi_handle_t *wifi, wifi_dns_stats_t *stats);
+wifi_status_t WiFi_SendTCP(wifi_handle_t *wifi, const char *ip, uint16_t port, const char *message);
+wifi_status_t WiFi_SendRaw(wifi_handle_t *wifi, const uint8_t *data, uint16_t length);
+wifi_status_t WiFi_Send_Payload(wifi_handle_t *wifi, const char *command, const uint8_t *payload, uint16_t length, const char *expected,
+                                uint32_t timeout_ms);
+wifi_status_t WiFi_Expect(wifi_handle_t *wifi, const char *expected, uint32_t timeout_ms);
+uint16_t WiFi_Available(wifi_handle_t *wifi);
+uint16_t WiFi_Read(wifi_handle_t *wifi, uint8_t *out, uint16_t max_len);
+uint32_t WiFi_GetRxOverruns(wifi_handle_t *wifi);
+void WiFi_GetTransportStats(wifi_handle_t *wifi, wifi_transport_stats_t *stats);
+void WiFi_ResetTransportStats(wifi_handle_t *wifi);
+uint32_t WiFi_GetIrqsPerKB(wifi_handle_t *wifi); // (rx_irqs + tx_irqs) per 1024 bytes moved in either direction.
+// Copy the latency histograms, HTTP counters, byte counts and RX overruns.
+void WiFi_GetMetrics(wifi_handle_t *wifi, wifi_metrics_t *metrics);
+// Clear the metrics, including the transport stats and the overrun count they are read from.
+void WiFi_ResetMetrics(wifi_handle_t *wifi);
+// Render a snapshot as a few short text lines (see README). Returns the length written.
+uint16_t WiFi_FormatMetrics(const wifi_metrics_t *metrics, char *out, uint16_t out_len);
+void WiFi_SetEventHandler(wifi_handle_t *wifi, wifi_event_handler_t handler, void *context);
+void WiFi_SetDataHandler(wifi_handle_t *wifi, wifi_data_handler_t handler, void *context);
+
+// Queue an AT command and return immediately; callback reports OK/ERROR/TIMEOUT/BUSY.
+wifi_status_t WiFi_Command_Enqueue(wifi_handle_t *wifi, const char *command, const char *expected, uint32_t timeout_ms,
+                                   wifi_command_cb_t callback, void *context);
+// Queue raw bytes (for example a CIPSEND payload). data must stay valid until the callback runs.
+// A NULL expected completes the entry as soon as the bytes are on the wire.
+wifi_status_t WiFi_Command_EnqueueRaw(wifi_handle_t *wifi, const uint8_t *data, uint16_t length, const char *expected, uint32_t timeout_ms,
+                                      wifi_command_cb_t callback, void *context);
+// Queue AT+CIPSEND-style exchanges: send command, wait for the '>' prompt, write payload, then wait
+// for expected (normally "SEND OK"). payload must stay valid until the callback runs.
+wifi_status_t WiFi_Command_EnqueueSend(wifi_handle_t *wifi, const char *command, const uint8_t *payload, uint16_t length,
+                                       const char *expected, uint32_t timeout_ms, wifi_command_cb_t callback, void *context);
+// Drive the command queue: parse new input, complete or time out the active command, start the next.
+void WiFi_Poll(wifi_handle_t *wifi);
+// Number of commands in flight or waiting.
+uint8_t WiFi_Command_Pending(wifi_handle_t *wifi);
+// 1 while the single-connection link is open (tracked from CONNECT/CLOSED, no AT round trip).
+uint8_t WiFi_IsLinkOpen(wifi_handle_t *wifi);
+// Same for one link ID in multi-connection mode (AT+CIPMUX=1).
+uint8_t WiFi_IsLinkIdOpen(wifi_handle_t *wifi, uint8_t link_id);
 const char *WiFi_StatusToString(wifi_status_t status);
 
 #endif
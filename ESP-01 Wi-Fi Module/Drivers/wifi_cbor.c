@@ -0,0 +1,269 @@
+#include "wifi_cbor.h"
+
+// Major types, already shifted into the top three bits of the initial byte.
+#define WIFI_CBOR_UINT   0x00U
+#define WIFI_CBOR_NEGINT 0x20U
+#define WIFI_CBOR_BYTES  0x40U
+#define WIFI_CBOR_TEXT   0x60U
+#define WIFI_CBOR_ARRAY  0x80U
+#define WIFI_CBOR_MAP    0xA0U
+#define WIFI_CBOR_SIMPLE 0xE0U
+
+static const wifi_http_header_t wifi_cbor_headers[] = {
+    {"Content-Type", "application/cbor"},
+    {NULL, NULL}
+};
+
+static void wifi_cbor_put(wifi_cbor_t *cbor, const uint8_t *data, uint32_t length);
+static void wifi_cbor_head(wifi_cbor_t *cbor, uint8_t major, uint32_t value);
+static uint8_t wifi_cbor_half(float value, uint16_t *half);
+
+void WiFi_CBOR_Init(wifi_cbor_t *cbor, uint8_t *out, uint16_t out_len, uint32_t window_start)
+{
+    if (cbor == NULL)
+    {
+        return;
+    }
+    cbor->out = out;
+    cbor->out_len = (out != NULL) ? out_len : 0U;
+    cbor->window_start = window_start;
+    cbor->position = 0;
+}
+
+uint16_t WiFi_CBOR_Written(const wifi_cbor_t *cbor)
+{
+    if (cbor == NULL || cbor->position <= cbor->window_start)
+    {
+        return 0;
+    }
+    uint32_t written = cbor->position - cbor->window_start;
+    return (uint16_t)((written < cbor->out_len) ? written : cbor->out_len);
+}
+
+void WiFi_CBOR_Uint(wifi_cbor_t *cbor, uint32_t value)
+{
+    wifi_cbor_head(cbor, WIFI_CBOR_UINT, value);
+}
+
+void WiFi_CBOR_Int(wifi_cbor_t *cbor, int32_t value)
+{
+    if (value >= 0)
+    {
+        wifi_cbor_head(cbor, WIFI_CBOR_UINT, (uint32_t)value);
+    }
+    else
+    {
+        wifi_cbor_head(cbor, WIFI_CBOR_NEGINT, (uint32_t)(-(value + 1))); // -1 - n, without overflowing on INT32_MIN.
+    }
+}
+
+void WiFi_CBOR_Float(wifi_cbor_t *cbor, float value)
+{
+    uint8_t data[5];
+    uint16_t half;
+
+    if (wifi_cbor_half(value, &half))
+    {
+        data[0] = WIFI_CBOR_SIMPLE | 25U;
+        data[1] = (uint8_t)(half >> 8);
+        data[2] = (uint8_t)half;
+        wifi_cbor_put(cbor, data, 3);
+        return;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    data[0] = WIFI_CBOR_SIMPLE | 26U;
+    data[1] = (uint8_t)(bits >> 24);
+    data[2] = (uint8_t)(bits >> 16);
+    data[3] = (uint8_t)(bits >> 8);
+    data[4] = (uint8_t)bits;
+    wifi_cbor_put(cbor, data, 5);
+}
+
+void WiFi_CBOR_Bool(wifi_cbor_t *cbor, uint8_t value)
+{
+    uint8_t data = WIFI_CBOR_SIMPLE | (value ? 21U : 20U);
+    wifi_cbor_put(cbor, &data, 1);
+}
+
+void WiFi_CBOR_Null(wifi_cbor_t *cbor)
+{
+    uint8_t data = WIFI_CBOR_SIMPLE | 22U;
+    wifi_cbor_put(cbor, &data, 1);
+}
+
+void WiFi_CBOR_Text(wifi_cbor_t *cbor, const char *text)
+{
+    uint32_t length = (text != NULL) ? (uint32_t)strlen(text) : 0U;
+    wifi_cbor_head(cbor, WIFI_CBOR_TEXT, length);
+    wifi_cbor_put(cbor, (const uint8_t *)text, length);
+}
+
+void WiFi_CBOR_Bytes(wifi_cbor_t *cbor, const uint8_t *data, uint32_t length)
+{
+    if (data == NULL)
+    {
+        length = 0;
+    }
+    wifi_cbor_head(cbor, WIFI_CBOR_BYTES, length);
+    wifi_cbor_put(cbor, data, length);
+}
+
+void WiFi_CBOR_Array(wifi_cbor_t *cbor, uint32_t count)
+{
+    wifi_cbor_head(cbor, WIFI_CBOR_ARRAY, count);
+}
+
+void WiFi_CBOR_Map(wifi_cbor_t *cbor, uint32_t count)
+{
+    wifi_cbor_head(cbor, WIFI_CBOR_MAP, count);
+}
+
+uint32_t WiFi_CBOR_Measure(const wifi_cbor_body_t *body)
+{
+    wifi_cbor_t cbor;
+    if (body == NULL || body->encode == NULL)
+    {
+        return 0;
+    }
+    WiFi_CBOR_Init(&cbor, NULL, 0, 0);
+    body->encode(&cbor, body->context);
+    return cbor.position;
+}
+
+// Re-runs the encoder with the window set to the staging buffer being filled (WIFI_HTTP_CHUNK_LEN),
+// so a message costs one encoder pass per CIPSEND plus the measuring pass.
+uint16_t WiFi_CBOR_Produce(uint32_t offset, uint8_t *buf, uint16_t max_len, void *context)
+{
+    const wifi_cbor_body_t *body = (const wifi_cbor_body_t *)context;
+    wifi_cbor_t cbor;
+    if (body == NULL || body->encode == NULL)
+    {
+        return 0;
+    }
+    WiFi_CBOR_Init(&cbor, buf, max_len, offset);
+    body->encode(&cbor, body->context);
+    return WiFi_CBOR_Written(&cbor);
+}
+
+void WiFi_CBOR_Request(wifi_http_request_t *request, const char *path, const wifi_cbor_body_t *body)
+{
+    if (request == NULL)
+    {
+        return;
+    }
+    memset(request, 0, sizeof(*request));
+    request->method = "POST";
+    request->path = path;
+    request->headers = wifi_cbor_headers;
+    request->body_length = WiFi_CBOR_Measure(body);
+    request->body_producer = WiFi_CBOR_Produce;
+    request->body_context = (void *)body;
+}
+
+// Store the part of data that overlaps the window and advance the position either way.
+static void wifi_cbor_put(wifi_cbor_t *cbor, const uint8_t *data, uint32_t length)
+{
+    if (cbor == NULL)
+    {
+        return;
+    }
+
+    uint32_t start = cbor->position;
+    cbor->position += length;
+    if (cbor->out == NULL || cbor->position <= cbor->window_start || start >= cbor->window_start + cbor->out_len)
+    {
+        return;
+    }
+
+    uint32_t skip = (start < cbor->window_start) ? (cbor->window_start - start) : 0U;
+    uint32_t at = start + skip - cbor->window_start;
+    uint32_t count = length - skip;
+    if (count > cbor->out_len - at)
+    {
+        count = cbor->out_len - at;
+    }
+    memcpy(cbor->out + at, data + skip, count);
+}
+
+// Initial byte plus the shortest argument that holds value (RFC 8949 preferred serialization).
+static void wifi_cbor_head(wifi_cbor_t *cbor, uint8_t major, uint32_t value)
+{
+    uint8_t data[5];
+    uint8_t length;
+
+    if (value < 24U)
+    {
+        data[0] = (uint8_t)(major | value);
+        length = 1;
+    }
+    else if (value <= 0xFFU)
+    {
+        data[0] = major | 24U;
+        data[1] = (uint8_t)value;
+        length = 2;
+    }
+    else if (value <= 0xFFFFU)
+    {
+        data[0] = major | 25U;
+        data[1] = (uint8_t)(value >> 8);
+        data[2] = (uint8_t)value;
+        length = 3;
+    }
+    else
+    {
+        data[0] = major | 26U;
+        data[1] = (uint8_t)(value >> 24);
+        data[2] = (uint8_t)(value >> 16);
+        data[3] = (uint8_t)(value >> 8);
+        data[4] = (uint8_t)value;
+        length = 5;
+    }
+    wifi_cbor_put(cbor, data, length);
+}
+
+// Converts value to IEEE half precision if no bits are lost. Returns 0 if it needs single precision.
+static uint8_t wifi_cbor_half(float value, uint16_t *half)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000U);
+    uint32_t biased = (bits >> 23) & 0xFFU;
+    uint32_t mantissa = bits & 0x7FFFFFU;
+    int32_t exponent = (int32_t)biased - 127 + 15;
+
+    if ((bits & 0x7FFFFFFFU) == 0)
+    {
+        *half = sign; // +0 / -0
+        return 1;
+    }
+    if (biased == 0xFFU)
+    {
+        *half = (uint16_t)(sign | 0x7C00U | (mantissa != 0 ? 0x0200U : 0U)); // Infinity, or the canonical NaN.
+        return 1;
+    }
+    if (biased == 0 || exponent >= 31)
+    {
+        return 0; // Single-precision subnormals and large values.
+    }
+    if (exponent <= 0)
+    {
+        // Half-precision subnormal: the full significand shifted down, with nothing shifted out.
+        uint32_t significand = mantissa | 0x800000U;
+        uint32_t shift = (uint32_t)(14 - exponent);
+        if (shift > 24U || (significand & ((1UL << shift) - 1U)) != 0)
+        {
+            return 0;
+        }
+        *half = (uint16_t)(sign | (significand >> shift));
+        return 1;
+    }
+    if ((mantissa & 0x1FFFU) != 0)
+    {
+        return 0;
+    }
+    *half = (uint16_t)(sign | ((uint32_t)exponent << 10) | (mantissa >> 13));
+    return 1;
+}
@@ -0,0 +1,53 @@
+#ifndef WIFI_CBOR_H
+#define WIFI_CBOR_H
+
+#include "wifi_http_support.h"
+
+// Streaming CBOR (RFC 8949) encoder. The encoder counts every byte of the message but only stores
+// the ones that fall inside its output window, so one encode function can fill consecutive HTTP
+// transmit segments in place, or measure the message when there is no buffer.
+typedef struct
+{
+    uint8_t *out;                // Window buffer; NULL only measures.
+    uint16_t out_len;
+    uint32_t window_start;       // Message offset of out[0].
+    uint32_t position;           // Bytes encoded so far, inside the window or not.
+} wifi_cbor_t;
+
+// Writes one complete message through the WiFi_CBOR_* calls. It runs once to measure and again
+// for every transmit segment, so it must produce the same bytes each time.
+typedef void (*wifi_cbor_encode_t)(wifi_cbor_t *cbor, void *context);
+
+// A message to send as an HTTP body.
+typedef struct
+{
+    wifi_cbor_encode_t encode;
+    void *context;
+} wifi_cbor_body_t;
+
+void WiFi_CBOR_Init(wifi_cbor_t *cbor, uint8_t *out, uint16_t out_len, uint32_t window_start);
+// Bytes stored in the window so far.
+uint16_t WiFi_CBOR_Written(const wifi_cbor_t *cbor);
+
+void WiFi_CBOR_Uint(wifi_cbor_t *cbor, uint32_t value);
+void WiFi_CBOR_Int(wifi_cbor_t *cbor, int32_t value);
+// Written as a half-precision float when that keeps the exact value (0, 0.5, 21.0, NaN...),
+// otherwise as single precision: 3 or 5 bytes.
+void WiFi_CBOR_Float(wifi_cbor_t *cbor, float value);
+void WiFi_CBOR_Bool(wifi_cbor_t *cbor, uint8_t value);
+void WiFi_CBOR_Null(wifi_cbor_t *cbor);
+void WiFi_CBOR_Text(wifi_cbor_t *cbor, const char *text);
+void WiFi_CBOR_Bytes(wifi_cbor_t *cbor, const uint8_t *data, uint32_t length);
+// Containers have a fixed item count; a map's count is its number of key/value pairs.
+void WiFi_CBOR_Array(wifi_cbor_t *cbor, uint32_t count);
+void WiFi_CBOR_Map(wifi_cbor_t *cbor, uint32_t count);
+
+// Encoded size of a message.
+uint32_t WiFi_CBOR_Measure(const wifi_cbor_body_t *body);
+// HTTP body producer (wifi_http_body_producer_t) for a wifi_cbor_body_t context.
+uint16_t WiFi_CBOR_Produce(uint32_t offset, uint8_t *buf, uint16_t max_len, void *context);
+// Fill request as a POST of body with Content-Type application/cbor. body must stay valid until
+// the request has been sent.
+void WiFi_CBOR_Request(wifi_http_request_t *request, const char *path, const wifi_cbor_body_t *body);
+
+#endif
@@ -0,0 +1,48 @@
+#include "wifi_cbor_sensors.h"
+#include <math.h>
+
+void WiFi_CBOR_BME280(wifi_cbor_t *cbor, const bme280_reading_t *reading)
+{
+    WiFi_CBOR_Map(cbor, 3);
+    WiFi_CBOR_Text(cbor, "t");
+    WiFi_CBOR_Float(cbor, reading->temperature_c);
+    WiFi_CBOR_Text(cbor, "h");
+    WiFi_CBOR_Float(cbor, reading->humidity_rh);
+    WiFi_CBOR_Text(cbor, "p");
+    WiFi_CBOR_Float(cbor, reading->pressure_pa);
+}
+
+void WiFi_CBOR_GasSensor(wifi_cbor_t *cbor, const gas_sensor_reading_t *reading)
+{
+    WiFi_CBOR_Map(cbor, 4);
+    WiFi_CBOR_Text(cbor, "n");
+    WiFi_CBOR_Uint(cbor, reading->raw_counts);
+    WiFi_CBOR_Text(cbor, "v");
+    WiFi_CBOR_Float(cbor, reading->voltage_volts);
+    WiFi_CBOR_Text(cbor, "r");
+    WiFi_CBOR_Float(cbor, reading->resistance_ohms);
+    WiFi_CBOR_Text(cbor, "q");
+    if (isnan(reading->ratio_vs_r0))
+    {
+        WiFi_CBOR_Null(cbor);
+    }
+    else
+    {
+        WiFi_CBOR_Float(cbor, reading->ratio_vs_r0);
+    }
+}
+
+void WiFi_CBOR_Distance(wifi_cbor_t *cbor, float distance_cm)
+{
+    WiFi_CBOR_Map(cbor, 1);
+    WiFi_CBOR_Text(cbor, "d");
+    WiFi_CBOR_Float(cbor, distance_cm);
+}
+
+void WiFi_CBOR_Record(wifi_cbor_t *cbor, uint32_t timestamp)
+{
+    WiFi_CBOR_Map(cbor, 2);
+    WiFi_CBOR_Text(cbor, "t");
+    WiFi_CBOR_Uint(cbor, timestamp);
+    WiFi_CBOR_Text(cbor, "d");
+}
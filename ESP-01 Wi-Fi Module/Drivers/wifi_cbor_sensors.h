@@ -0,0 +1,21 @@
+#ifndef WIFI_CBOR_SENSORS_H
+#define WIFI_CBOR_SENSORS_H
+
+#include "wifi_cbor.h"
+#include "bme280_sensor_driver.h"
+#include "gas_sensor_driver.h"
+
+// CBOR maps for the sensor drivers in this library. Keys are one-letter text strings, so any CBOR
+// decoder shows readable field names at a cost of two bytes per key.
+
+// {"t": degC, "h": %RH, "p": Pa}
+void WiFi_CBOR_BME280(wifi_cbor_t *cbor, const bme280_reading_t *reading);
+// {"n": ADC counts, "v": volts, "r": ohms, "q": Rs/R0}. "q" is null until the sensor is calibrated.
+void WiFi_CBOR_GasSensor(wifi_cbor_t *cbor, const gas_sensor_reading_t *reading);
+// {"d": cm} from Ultrasonic_GetDistance().
+void WiFi_CBOR_Distance(wifi_cbor_t *cbor, float distance_cm);
+// {"t": timestamp, "d": <value>}: the record envelope used by the telemetry uploads. Encode the
+// value right after this call.
+void WiFi_CBOR_Record(wifi_cbor_t *cbor, uint32_t timestamp);
+
+#endif
@@ -1,165 +1,696 @@
 #include "wifi_http_support.h"
+#include <ctype.h>
+#include <stdlib.h>
 
-wifi_status_t WiFi_HTTP_Send(const char *method, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
-                             const char *body, uint32_t timeout_ms, uint8_t max_retries)
+// Streams request segments through AT+CIPSEND. Small pieces are coalesced in buf; large contiguous
+// runs (a body pointer) are sent straight from the caller's memory.
+typedef struct
+{
+    wifi_handle_t *wifi;
+    uint8_t buf[WIFI_HTTP_CHUNK_LEN];
+    uint16_t used;
+    wifi_status_t status; // First failure; later writes become no-ops.
+} wifi_http_emitter_t;
+
+static const wifi_retry_policy_t *wifi_http_retry_policy = &WiFi_Retry_DefaultPolicy;
+
+static uint8_t wifi_http_request_valid(const wifi_http_request_t *request);
+static wifi_status_t wifi_http_open(wifi_handle_t *wifi, const char *host_ip, uint16_t port);
+static wifi_status_t wifi_http_exchange(wifi_handle_t *wifi, const char *host_ip, const wifi_http_request_t *request,
+                                        wifi_http_response_t *response, uint8_t keep_alive, uint32_t timeout_ms);
+static void wifi_http_on_data(uint8_t link_id, const uint8_t *data, uint16_t length, void *context);
+static void wifi_http_response_reset(wifi_http_response_t *response);
+static void wifi_http_parse_line(wifi_http_response_t *response);
+static void wifi_http_deliver(wifi_http_response_t *response, const uint8_t *data, uint16_t length);
+static uint8_t wifi_http_header_is(const char *line, const char *name, const char **value);
+static wifi_status_t wifi_http_stream_request(wifi_handle_t *wifi, const char *host_ip, const wifi_http_request_t *request,
+                                              uint8_t keep_alive);
+static void wifi_http_emit(wifi_http_emitter_t *emitter, const uint8_t *data, uint32_t length);
+static void wifi_http_emit_str(wifi_http_emitter_t *emitter, const char *text);
+static void wifi_http_flush(wifi_http_emitter_t *emitter);
+static wifi_status_t wifi_http_cipsend(wifi_handle_t *wifi, const uint8_t *data, uint16_t length);
+
+wifi_status_t WiFi_HTTP_Send(wifi_handle_t *wifi, const char *method, const char *host_ip, uint16_t port, const char *path,
+                             const wifi_http_header_t *headers, const char *body, uint32_t timeout_ms, uint8_t max_retries)
+{
+    wifi_http_request_t request = {0};
+    request.method = method;
+    request.path = path;
+    request.headers = headers;
+    request.body = (const uint8_t *)body;
+    request.body_length = (body ? strlen(body) : 0);
+
+    return WiFi_HTTP_SendRequest(wifi, host_ip, port, &request, NULL, timeout_ms, max_retries);
+}
+
+wifi_status_t WiFi_HTTP_SendRequest(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const wifi_http_request_t *request,
+                                    wifi_http_response_t *response, uint32_t timeout_ms, uint8_t max_retries)
 {
-    if (method == NULL || method[0] == '\0' || path == NULL || path[0] != '/' || host_ip == NULL || host_ip[0] == '\0')
+    if (wifi == NULL || host_ip == NULL || host_ip[0] == '\0' || !wifi_http_request_valid(request))
     {
         return WIFI_ERROR;
     }
 
-    char request[512];
-    memset(request, 0, sizeof(request));
+    wifi_http_response_t discard;
+    if (response == NULL)
+    {
+        WiFi_HTTP_Response_Init(&discard, NULL, NULL); // Still parsed, so the status code is checked.
+        response = &discard;
+    }
+
+    wifi_retry_t retry;
+    WiFi_Retry_Begin(&retry, wifi_http_retry_policy, max_retries);
+    wifi->http.requests++;
+    while (WiFi_Retry_Next(&retry))
+    {
+        if (retry.attempt > 1)
+        {
+            wifi->http.retries++;
+        }
+        if (WiFi_IsNetworkDown(wifi))
+        {
+            wifi->http.failures++; // The AP is gone, not the host: leave the breaker and the backoff alone.
+            return WIFI_ERROR;
+        }
+        if (!WiFi_Breaker_Allow(host_ip, port))
+        {
+            WIFI_LOG_TEXT(host_ip, DLOG_WIFI_HTTP_FAST_FAIL, port);
+            wifi->http.fast_fails++;
+            wifi->http.failures++;
+            return WIFI_ERROR;
+        }
+
+        if (wifi_http_open(wifi, host_ip, port) != WIFI_OK)
+        {
+            WIFI_LOG(DLOG_WIFI_HTTP_CONNECT_FAILED, retry.attempt);
+            wifi->http.connect_failures++;
+            WiFi_Breaker_Report(host_ip, port, 0); // No link was opened, so there is nothing to close.
+            continue;
+        }
+        wifi->link_owner = NULL; // A one-shot request never leaves the link for a session to reuse.
+
+        wifi_status_t status = wifi_http_exchange(wifi, host_ip, request, response, 0, timeout_ms);
+        if (WiFi_IsLinkOpen(wifi))
+        {
+            WiFi_Send_Command(wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+        }
+        if (status != WIFI_OK)
+        {
+            WIFI_LOG(DLOG_WIFI_HTTP_NO_RESPONSE, retry.attempt);
+            wifi->http.timeouts += (status == WIFI_TIMEOUT) ? 1U : 0U;
+            WiFi_Breaker_Report(host_ip, port, 0);
+            continue;
+        }
+
+        WIFI_LOG(DLOG_WIFI_HTTP_STATUS, retry.attempt, response->status_code);
+        WiFi_Breaker_Report(host_ip, port, (response->status_code < 500) ? 1U : 0U);
+        if (response->status_code >= 500)
+        {
+            continue; // Server-side failure; worth another attempt.
+        }
+        if (response->status_code >= 400)
+        {
+            wifi->http.failures++;
+            return WIFI_ERROR;
+        }
+        return WIFI_OK;
+    }
+
+    wifi->http.failures++;
+    return WIFI_ERROR;
+}
+
+wifi_status_t WiFi_HTTP_POST(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+                             const char *body, uint32_t timeout_ms, uint8_t max_retries)
+{
+    return WiFi_HTTP_Send(wifi, "POST", host_ip, port, path, headers, body, timeout_ms, max_retries);
+}
+
+wifi_status_t WiFi_HTTP_GET(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+                            uint32_t timeout_ms, uint8_t max_retries)
+{
+    return WiFi_HTTP_Send(wifi, "GET", host_ip, port, path, headers, NULL, timeout_ms, max_retries);
+}
+
+wifi_status_t WiFi_HTTP_PUT(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+                            const char *body, uint32_t timeout_ms, uint8_t max_retries)
+{
+    return WiFi_HTTP_Send(wifi, "PUT", host_ip, port, path, headers, body, timeout_ms, max_retries);
+}
+
+wifi_status_t WiFi_HTTP_DELETE(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+                               uint32_t timeout_ms, uint8_t max_retries)
+{
+    return WiFi_HTTP_Send(wifi, "DELETE", host_ip, port, path, headers, NULL, timeout_ms, max_retries);
+}
+
+// Backoff used between attempts by every request helper; NULL restores the default.
+void WiFi_HTTP_SetRetryPolicy(const wifi_retry_policy_t *policy)
+{
+    wifi_http_retry_policy = (policy != NULL) ? policy : &WiFi_Retry_DefaultPolicy;
+}
+
+// --- Persistent sessions ---
+void WiFi_HTTP_Session_Init(wifi_http_session_t *session, wifi_handle_t *wifi, const char *host_ip, uint16_t port)
+{
+    if (session == NULL)
+    {
+        return;
+    }
+
+    session->wifi = wifi;
+    session->host_ip = host_ip;
+    session->port = port;
+    session->connects = 0;
+}
 
-    uint16_t body_length = (body ? strlen(body) : 0);
-    uint16_t offset = 0;
+wifi_status_t WiFi_HTTP_Session_Request(wifi_http_session_t *session, const char *method, const char *path,
+                                        const wifi_http_header_t *headers, const char *body, uint32_t timeout_ms, uint8_t max_retries)
+{
+    wifi_http_request_t request = {0};
+    request.method = method;
+    request.path = path;
+    request.headers = headers;
+    request.body = (const uint8_t *)body;
+    request.body_length = (body ? strlen(body) : 0);
+
+    return WiFi_HTTP_Session_Send(session, &request, NULL, timeout_ms, max_retries);
+}
 
-    uint16_t written = snprintf(request, sizeof(request), "%s %s HTTP/1.1\r\n", method, path);
-    if (written == 0 || written >= sizeof(request) - offset)
+// Send one request over the session's link, opening it only if the module reports it closed (or
+// another host took it). A failed exchange drops the link so the next attempt starts clean.
+wifi_status_t WiFi_HTTP_Session_Send(wifi_http_session_t *session, const wifi_http_request_t *request, wifi_http_response_t *response,
+                                     uint32_t timeout_ms, uint8_t max_retries)
+{
+    if (session == NULL || session->wifi == NULL || session->host_ip == NULL || session->host_ip[0] == '\0' ||
+        !wifi_http_request_valid(request))
     {
         return WIFI_ERROR;
     }
-    offset += written;
 
-    written = snprintf(request + offset, sizeof(request) - offset, "Host: %s\r\n", host_ip);
-    if (written == 0 || written >= sizeof(request) - offset)
+    wifi_http_response_t discard;
+    if (response == NULL)
+    {
+        WiFi_HTTP_Response_Init(&discard, NULL, NULL);
+        response = &discard;
+    }
+
+    wifi_http_counters_t *counters = &session->wifi->http;
+    wifi_retry_t retry;
+    WiFi_Retry_Begin(&retry, wifi_http_retry_policy, max_retries);
+    counters->requests++;
+    while (WiFi_Retry_Next(&retry))
+    {
+        if (retry.attempt > 1)
+        {
+            counters->retries++;
+        }
+        if (WiFi_IsNetworkDown(session->wifi))
+        {
+            counters->failures++; // The AP is gone, not the host: leave the breaker and the backoff alone.
+            return WIFI_ERROR;
+        }
+        if (!WiFi_Breaker_Allow(session->host_ip, session->port))
+        {
+            WIFI_LOG_TEXT(session->host_ip, DLOG_WIFI_SESSION_FAST_FAIL, session->port);
+            counters->fast_fails++;
+            counters->failures++;
+            return WIFI_ERROR;
+        }
+
+        if (!WiFi_HTTP_Session_IsOpen(session))
+        {
+            if (WiFi_IsLinkOpen(session->wifi))
+            {
+                WiFi_Send_Command(session->wifi, "AT+CIPCLOSE\r\n", "OK", 2000); // The link points at another host.
+            }
+            if (wifi_http_open(session->wifi, session->host_ip, session->port) != WIFI_OK)
+            {
+                WIFI_LOG(DLOG_WIFI_SESSION_CONNECT_FAILED, retry.attempt);
+                session->wifi->link_owner = NULL;
+                counters->connect_failures++;
+                WiFi_Breaker_Report(session->host_ip, session->port, 0);
+                continue;
+            }
+            session->wifi->link_owner = session;
+            session->connects++;
+        }
+
+        wifi_status_t status = wifi_http_exchange(session->wifi, session->host_ip, request, response, 1, timeout_ms);
+        if (status != WIFI_OK)
+        {
+            WIFI_LOG(DLOG_WIFI_SESSION_NO_RESPONSE, retry.attempt);
+            counters->timeouts += (status == WIFI_TIMEOUT) ? 1U : 0U;
+            WiFi_HTTP_Session_Close(session);
+            WiFi_Breaker_Report(session->host_ip, session->port, 0);
+            continue;
+        }
+
+        WiFi_Breaker_Report(session->host_ip, session->port, (response->status_code < 500) ? 1U : 0U);
+        if (response->status_code >= 500)
+        {
+            continue;
+        }
+        if (response->status_code >= 400)
+        {
+            counters->failures++;
+            return WIFI_ERROR;
+        }
+        return WIFI_OK;
+    }
+
+    counters->failures++;
+    return WIFI_ERROR;
+}
+
+uint8_t WiFi_HTTP_Session_IsOpen(const wifi_http_session_t *session)
+{
+    return (session != NULL && session->wifi != NULL && session->wifi->link_owner == session && WiFi_IsLinkOpen(session->wifi)) ? 1U : 0U;
+}
+
+void WiFi_HTTP_Session_Close(wifi_http_session_t *session)
+{
+    if (session == NULL || session->wifi == NULL || session->wifi->link_owner != session)
+    {
+        return;
+    }
+
+    if (WiFi_IsLinkOpen(session->wifi))
+    {
+        WiFi_Send_Command(session->wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+    }
+    session->wifi->link_owner = NULL;
+}
+
+// --- Request helpers ---
+static uint8_t wifi_http_request_valid(const wifi_http_request_t *request)
+{
+    if (request == NULL || request->method == NULL || request->method[0] == '\0' || request->path == NULL || request->path[0] != '/')
+    {
+        return 0;
+    }
+    if (request->body_length > 0 && request->body == NULL && request->body_producer == NULL)
+    {
+        return 0;
+    }
+    return 1;
+}
+
+// Callers check WiFi_IsNetworkDown first, so a failure here is the host's.
+static wifi_status_t wifi_http_open(wifi_handle_t *wifi, const char *host_ip, uint16_t port)
+{
+    char cmd[128];
+    char address[WIFI_IP_LEN];
+    if (WiFi_Resolve(wifi, host_ip, address, sizeof(address)) != WIFI_OK)
     {
         return WIFI_ERROR;
     }
-    offset += written;
 
-    written = snprintf(request + offset, sizeof(request) - offset, "Connection: close\r\n");
-    if (written == 0 || written >= sizeof(request) - offset)
+    snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"TCP\",\"%s\",%u\r\n", address, port);
+    if (WiFi_Send_Command(wifi, cmd, "OK", 5000) != WIFI_OK && !WiFi_IsLinkOpen(wifi))
     {
         return WIFI_ERROR;
     }
-    offset += written;
+    return WIFI_OK;
+}
+
+// Stream one request, then feed +IPD payloads into the response parser until the response is
+// complete, the server closes the link, or timeout_ms passes.
+static wifi_status_t wifi_http_exchange(wifi_handle_t *wifi, const char *host_ip, const wifi_http_request_t *request,
+                                        wifi_http_response_t *response, uint8_t keep_alive, uint32_t timeout_ms)
+{
+    wifi_http_response_reset(response);
+    WiFi_SetDataHandler(wifi, wifi_http_on_data, response); // Data that arrives while the request is still going out is kept.
+
+    wifi_status_t status = wifi_http_stream_request(wifi, host_ip, request, keep_alive);
+    if (status != WIFI_OK)
+    {
+        WIFI_LOG(DLOG_WIFI_HTTP_CIPSEND_FAILED);
+    }
 
-    if (body_length > 0)
+    uint32_t start = HAL_GetTick();
+    while (status == WIFI_OK && !WiFi_HTTP_Response_IsComplete(response))
     {
-        written = snprintf(request + offset, sizeof(request) - offset, "Content-Length: %u\r\n", body_length);
-        if (written == 0 || written >= sizeof(request) - offset)
+        WiFi_Poll(wifi);
+        if (!WiFi_IsLinkOpen(wifi)) // Everything sent before CLOSED has been parsed by now.
         {
-            return WIFI_ERROR;
+            WiFi_HTTP_Response_Closed(response);
+            status = WiFi_HTTP_Response_IsComplete(response) ? WIFI_OK : WIFI_ERROR;
+        }
+        else if ((HAL_GetTick() - start) >= timeout_ms)
+        {
+            status = WIFI_TIMEOUT;
         }
-        offset += written;
     }
 
-    if (headers != NULL)
+    WiFi_SetDataHandler(wifi, NULL, NULL);
+    return status;
+}
+
+// Emit request line, headers and body as segments. Content-Length comes from the request
+// description, so the body never has to be measured or copied up front.
+static wifi_status_t wifi_http_stream_request(wifi_handle_t *wifi, const char *host_ip, const wifi_http_request_t *request,
+                                              uint8_t keep_alive)
+{
+    wifi_http_emitter_t emitter;
+    emitter.wifi = wifi;
+    emitter.used = 0;
+    emitter.status = WIFI_OK;
+
+    wifi_http_emit_str(&emitter, request->method);
+    wifi_http_emit_str(&emitter, " ");
+    wifi_http_emit_str(&emitter, request->path);
+    wifi_http_emit_str(&emitter, " HTTP/1.1\r\nHost: ");
+    wifi_http_emit_str(&emitter, host_ip);
+    wifi_http_emit_str(&emitter, keep_alive ? "\r\nConnection: keep-alive\r\n" : "\r\nConnection: close\r\n");
+
+    if (request->body_length > 0)
+    {
+        char length_text[16];
+        snprintf(length_text, sizeof(length_text), "%lu", (unsigned long)request->body_length);
+        wifi_http_emit_str(&emitter, "Content-Length: ");
+        wifi_http_emit_str(&emitter, length_text);
+        wifi_http_emit_str(&emitter, "\r\n");
+    }
+
+    if (request->headers != NULL)
     {
         uint8_t has_content_type = 0;
-        for (int i = 0; headers[i].key != NULL; i++)
+        for (int i = 0; request->headers[i].key != NULL; i++)
         {
-            if (strcmp(headers[i].key, "Content-Type") == 0)
+            if (strcmp(request->headers[i].key, "Content-Type") == 0)
             {
                 has_content_type = 1;
             }
 
-            written = snprintf(request + offset, sizeof(request) - offset, "%s: %s\r\n", headers[i].key, headers[i].value);
-            if (written == 0 || written >= sizeof(request) - offset)
-            {
-                return WIFI_ERROR;
-            }
-            offset += written;
+            wifi_http_emit_str(&emitter, request->headers[i].key);
+            wifi_http_emit_str(&emitter, ": ");
+            wifi_http_emit_str(&emitter, request->headers[i].value);
+            wifi_http_emit_str(&emitter, "\r\n");
         }
 
         if (has_content_type == 0)
         {
-            written = snprintf(request + offset, sizeof(request) - offset, "Content-Type: text/plain\r\n");
-            if (written == 0 || written >= sizeof(request) - offset)
-            {
-                return WIFI_ERROR;
-            }
-            offset += written;
+            wifi_http_emit_str(&emitter, "Content-Type: text/plain\r\n");
         }
     }
 
-    written = snprintf(request + offset, sizeof(request) - offset, "\r\n");
-    if (written == 0 || written >= sizeof(request) - offset)
+    wifi_http_emit_str(&emitter, "\r\n");
+
+    if (request->body != NULL)
     {
-        return WIFI_ERROR;
+        wifi_http_emit(&emitter, request->body, request->body_length);
     }
-    offset += written;
-
-    if (body_length > 0)
+    else
     {
-        if (body_length >= sizeof(request) - offset)
+        uint32_t offset = 0;
+        while (emitter.status == WIFI_OK && offset < request->body_length)
         {
-            return WIFI_ERROR; // NOT ENOUGH SPACE LEFT IN THE BUFFER.
+            if (emitter.used == sizeof(emitter.buf))
+            {
+                wifi_http_flush(&emitter);
+                continue;
+            }
+
+            uint32_t space = sizeof(emitter.buf) - emitter.used;
+            uint32_t remaining = request->body_length - offset;
+            uint16_t produced = request->body_producer(offset, emitter.buf + emitter.used, (uint16_t)((remaining < space) ? remaining : space),
+                                                       request->body_context);
+            if (produced == 0)
+            {
+                return WIFI_ERROR; // Producer ran dry before Content-Length was reached.
+            }
+            emitter.used += produced;
+            offset += produced;
         }
-        memcpy(request + offset, body, body_length);
-        offset += body_length;
     }
 
-    for (int i = 1; i <= max_retries; i++)
-    {
-        HAL_Delay(250);
-        uint16_t total_length = offset;
-        char cmd[128];
+    wifi_http_flush(&emitter);
+    return emitter.status;
+}
 
-        snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"TCP\",\"%s\",%u\r\n", host_ip, port);
-        if (WiFi_Send_Command(cmd, "OK", 5000) != WIFI_OK)
+static void wifi_http_emit(wifi_http_emitter_t *emitter, const uint8_t *data, uint32_t length)
+{
+    while (emitter->status == WIFI_OK && length > 0)
+    {
+        if (emitter->used == 0 && length >= sizeof(emitter->buf))
         {
-            WIFI_LOG("Attempt %u --- WiFi_HTTP_Send: CIPSTART failed!\r\n", i);
-            WiFi_Send_Command("AT+CIPCLOSE\r\n", "OK", 2000);
+            uint16_t direct = (uint16_t)((length < WIFI_HTTP_MAX_SEND) ? length : WIFI_HTTP_MAX_SEND);
+            emitter->status = wifi_http_cipsend(emitter->wifi, data, direct); // Zero-copy: send from the caller's buffer.
+            data += direct;
+            length -= direct;
             continue;
         }
 
-        snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u\r\n", (unsigned int)total_length);
-        if (WiFi_Send_Command(cmd, ">", 5000) != WIFI_OK)
+        uint32_t space = sizeof(emitter->buf) - emitter->used;
+        uint32_t count = (length < space) ? length : space;
+        memcpy(emitter->buf + emitter->used, data, count);
+        emitter->used += (uint16_t)count;
+        data += count;
+        length -= count;
+
+        if (emitter->used == sizeof(emitter->buf))
         {
-            WIFI_LOG("Attempt %u --- WiFi_HTTP_Send: CIPSEND failed!\r\n", i);
-            WiFi_Send_Command("AT+CIPCLOSE\r\n", "OK", 2000);
-            continue;
+            wifi_http_flush(emitter);
         }
+    }
+}
+
+static void wifi_http_emit_str(wifi_http_emitter_t *emitter, const char *text)
+{
+    wifi_http_emit(emitter, (const uint8_t *)text, strlen(text));
+}
+
+static void wifi_http_flush(wifi_http_emitter_t *emitter)
+{
+    if (emitter->status == WIFI_OK && emitter->used > 0)
+    {
+        emitter->status = wifi_http_cipsend(emitter->wifi, emitter->buf, emitter->used);
+    }
+    emitter->used = 0;
+}
+
+static wifi_status_t wifi_http_cipsend(wifi_handle_t *wifi, const uint8_t *data, uint16_t length)
+{
+    char cmd[32];
+
+    snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u\r\n", (unsigned int)length);
+    return WiFi_Send_Payload(wifi, cmd, data, length, "SEND OK", 5000);
+}
+
+// --- Response parsing ---
+void WiFi_HTTP_Response_Init(wifi_http_response_t *response, wifi_http_body_cb_t on_body, void *context)
+{
+    if (response == NULL)
+    {
+        return;
+    }
+
+    response->on_body = on_body;
+    response->context = context;
+    wifi_http_response_reset(response);
+}
+
+void WiFi_HTTP_Response_Feed(wifi_http_response_t *response, const uint8_t *data, uint16_t length)
+{
+    if (response == NULL || data == NULL)
+    {
+        return;
+    }
 
-        if (WiFi_SendRaw((uint8_t *)request, total_length) != WIFI_OK)
+    uint16_t i = 0;
+    while (i < length && response->state != WIFI_HTTP_PARSE_DONE)
+    {
+        switch (response->state)
         {
-            WIFI_LOG("Attempt %u --- WiFi_HTTP_Send: SendRaw failed!\r\n", i);
-            WiFi_Send_Command("AT+CIPCLOSE\r\n", "OK", 2000);
-            continue;
+        case WIFI_HTTP_PARSE_BODY_LENGTH:
+        case WIFI_HTTP_PARSE_CHUNK_DATA:
+        {
+            // Body bytes are passed through in place, as many as the frame and the framing allow.
+            uint16_t count = length - i;
+            if (count > response->remaining)
+            {
+                count = (uint16_t)response->remaining;
+            }
+            wifi_http_deliver(response, data + i, count);
+            response->remaining -= count;
+            i += count;
+
+            if (response->remaining == 0)
+            {
+                response->state = (response->state == WIFI_HTTP_PARSE_CHUNK_DATA) ? WIFI_HTTP_PARSE_CHUNK_END : WIFI_HTTP_PARSE_DONE;
+            }
+            break;
         }
 
-        wifi_status_t status = WiFi_Expect("+IPD", timeout_ms);
-        if (status != WIFI_OK)
+        case WIFI_HTTP_PARSE_BODY_UNTIL_CLOSE:
+            wifi_http_deliver(response, data + i, length - i);
+            i = length;
+            break;
+
+        default:
         {
-            status = WiFi_Expect("CLOSED", timeout_ms);
+            // Line-oriented states: status line, headers, chunk sizes, chunk terminators, trailers.
+            char c = (char)data[i++];
+            if (c == '\n')
+            {
+                wifi_http_parse_line(response);
+                response->line_len = 0;
+            }
+            else if (c != '\r' && response->line_len + 1U < WIFI_HTTP_LINE_LEN)
+            {
+                response->line[response->line_len++] = c;
+            }
+            response->line[response->line_len] = '\0';
+            break;
         }
-        if (status != WIFI_OK)
-        {
-            WIFI_LOG("Attempt %u --- WiFi_HTTP_Send: No HTTP response detected\r\n", i);
-            WiFi_Send_Command("AT+CIPCLOSE\r\n", "OK", 2000);
-            continue;
         }
+    }
+}
 
-        WIFI_LOG("Attempt %u --- WiFi_HTTP_Send: HTTP response received\r\n", i);
-        WiFi_Send_Command("AT+CIPCLOSE\r\n", "OK", timeout_ms);
-        return WIFI_OK;
+void WiFi_HTTP_Response_Closed(wifi_http_response_t *response)
+{
+    if (response != NULL && response->state == WIFI_HTTP_PARSE_BODY_UNTIL_CLOSE)
+    {
+        response->state = WIFI_HTTP_PARSE_DONE;
     }
+}
 
-    return WIFI_ERROR;
+uint8_t WiFi_HTTP_Response_IsComplete(const wifi_http_response_t *response)
+{
+    return (response != NULL && response->state == WIFI_HTTP_PARSE_DONE) ? 1U : 0U;
 }
 
-wifi_status_t WiFi_HTTP_POST(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers, const char *body,
-                             uint32_t timeout_ms, uint8_t max_retries)
+static void wifi_http_on_data(uint8_t link_id, const uint8_t *data, uint16_t length, void *context)
 {
-    return WiFi_HTTP_Send("POST", host_ip, port, path, headers, body, timeout_ms, max_retries);
+    if (link_id == WIFI_LINK_SINGLE)
+    {
+        WiFi_HTTP_Response_Feed((wifi_http_response_t *)context, data, length);
+    }
 }
 
-wifi_status_t WiFi_HTTP_GET(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers, uint32_t timeout_ms,
-                            uint8_t max_retries)
+static void wifi_http_response_reset(wifi_http_response_t *response)
 {
-    return WiFi_HTTP_Send("GET", host_ip, port, path, headers, NULL, timeout_ms, max_retries);
+    response->status_code = 0;
+    response->content_length = -1;
+    response->chunked = 0;
+    response->body_received = 0;
+    response->state = WIFI_HTTP_PARSE_STATUS;
+    response->line_len = 0;
+    response->line[0] = '\0';
+    response->remaining = 0;
 }
 
-wifi_status_t WiFi_HTTP_PUT(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers, const char *body,
-                            uint32_t timeout_ms, uint8_t max_retries)
+// Act on one complete line in the current line-oriented state.
+static void wifi_http_parse_line(wifi_http_response_t *response)
 {
-    return WiFi_HTTP_Send("PUT", host_ip, port, path, headers, body, timeout_ms, max_retries);
+    const char *value;
+
+    switch (response->state)
+    {
+    case WIFI_HTTP_PARSE_STATUS:
+        if (strncmp(response->line, "HTTP/", 5) == 0)
+        {
+            const char *code = strchr(response->line, ' ');
+            response->status_code = (code != NULL) ? (uint16_t)atoi(code + 1) : 0U;
+            response->state = WIFI_HTTP_PARSE_HEADERS;
+        }
+        break;
+
+    case WIFI_HTTP_PARSE_HEADERS:
+        if (response->line_len > 0)
+        {
+            if (wifi_http_header_is(response->line, "Content-Length", &value))
+            {
+                response->content_length = atol(value);
+            }
+            else if (wifi_http_header_is(response->line, "Transfer-Encoding", &value))
+            {
+                response->chunked = (strstr(value, "chunked") != NULL) ? 1U : 0U;
+            }
+            break;
+        }
+
+        // Blank line: headers are done, pick the body framing.
+        if (response->status_code >= 100 && response->status_code < 200)
+        {
+            // Interim response (100 Continue); the real one follows with its own status and framing.
+            wifi_http_response_reset(response);
+        }
+        else if (response->status_code == 204 || response->status_code == 304)
+        {
+            response->state = WIFI_HTTP_PARSE_DONE;
+        }
+        else if (response->chunked)
+        {
+            response->state = WIFI_HTTP_PARSE_CHUNK_SIZE;
+        }
+        else if (response->content_length >= 0)
+        {
+            response->remaining = (uint32_t)response->content_length;
+            response->state = (response->remaining > 0) ? WIFI_HTTP_PARSE_BODY_LENGTH : WIFI_HTTP_PARSE_DONE;
+        }
+        else
+        {
+            response->state = WIFI_HTTP_PARSE_BODY_UNTIL_CLOSE;
+        }
+        break;
+
+    case WIFI_HTTP_PARSE_CHUNK_SIZE:
+        if (response->line_len > 0)
+        {
+            response->remaining = strtoul(response->line, NULL, 16); // Chunk extensions after ';' are ignored.
+            response->state = (response->remaining > 0) ? WIFI_HTTP_PARSE_CHUNK_DATA : WIFI_HTTP_PARSE_TRAILER;
+        }
+        break;
+
+    case WIFI_HTTP_PARSE_CHUNK_END:
+        response->state = WIFI_HTTP_PARSE_CHUNK_SIZE;
+        break;
+
+    case WIFI_HTTP_PARSE_TRAILER:
+        if (response->line_len == 0)
+        {
+            response->state = WIFI_HTTP_PARSE_DONE;
+        }
+        break;
+
+    default:
+        break;
+    }
 }
 
-wifi_status_t WiFi_HTTP_DELETE(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
-                               uint32_t timeout_ms, uint8_t max_retries)
+static void wifi_http_deliver(wifi_http_response_t *response, const uint8_t *data, uint16_t length)
+{
+    response->body_received += length;
+    if (response->on_body != NULL && length > 0)
+    {
+        response->on_body(data, length, response->context);
+    }
+}
+
+// Case-insensitive "Name: value" match; value points past the colon and leading spaces.
+static uint8_t wifi_http_header_is(const char *line, const char *name, const char **value)
 {
-    return WiFi_HTTP_Send("DELETE", host_ip, port, path, headers, NULL, timeout_ms, max_retries);
+    while (*name != '\0')
+    {
+        if (tolower((unsigned char)*line) != tolower((unsigned char)*name))
+        {
+            return 0;
+        }
+        line++;
+        name++;
+    }
+    if (*line != ':')
+    {
+        return 0;
+    }
+
+    line++;
+    while (*line == ' ' || *line == '\t')
+    {
+        line++;
+    }
+    *value = line;
+    return 1;
 }
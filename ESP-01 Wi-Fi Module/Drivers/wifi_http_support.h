@@ -2,6 +2,11 @@
 #define WIFI_HTTP_SUPPORT_H
 
 #include "wifi_basic_driver.h"
+#include "wifi_retry.h"
+
+#define WIFI_HTTP_CHUNK_LEN 512     // Staging buffer that coalesces small segments into one CIPSEND.
+#define WIFI_HTTP_MAX_SEND 2048     // Largest single AT+CIPSEND the module accepts.
+#define WIFI_HTTP_LINE_LEN 128      // Longest status/header line kept while parsing a response.
 
 typedef struct
 {
@@ -9,15 +14,93 @@ typedef struct
     const char *value;
 } wifi_http_header_t;
 
-wifi_status_t WiFi_HTTP_Send(const char *method, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+// Fills buf with body bytes starting at offset and returns how many were written. A retry starts
+// again from offset 0, so the producer must be able to regenerate its output.
+typedef uint16_t (*wifi_http_body_producer_t)(uint32_t offset, uint8_t *buf, uint16_t max_len, void *context);
+
+// A request described as segments; nothing is assembled into one buffer before sending.
+typedef struct
+{
+    const char *method;
+    const char *path;
+    const wifi_http_header_t *headers;       // Optional, terminated with {NULL, NULL}.
+    const uint8_t *body;                     // Contiguous body sent in place, or NULL.
+    uint32_t body_length;                    // Content-Length; required with a producer as well.
+    wifi_http_body_producer_t body_producer; // Used when body is NULL.
+    void *body_context;
+} wifi_http_request_t;
+
+// Receives decoded response body bytes (chunked framing already removed).
+typedef void (*wifi_http_body_cb_t)(const uint8_t *data, uint16_t length, void *context);
+
+typedef enum
+{
+    WIFI_HTTP_PARSE_STATUS,
+    WIFI_HTTP_PARSE_HEADERS,
+    WIFI_HTTP_PARSE_BODY_LENGTH,     // Content-Length framing.
+    WIFI_HTTP_PARSE_CHUNK_SIZE,      // Transfer-Encoding: chunked, size line.
+    WIFI_HTTP_PARSE_CHUNK_DATA,
+    WIFI_HTTP_PARSE_CHUNK_END,       // CRLF after a chunk.
+    WIFI_HTTP_PARSE_TRAILER,
+    WIFI_HTTP_PARSE_BODY_UNTIL_CLOSE,
+    WIFI_HTTP_PARSE_DONE
+} wifi_http_parse_state_t;
+
+// Streaming response parser. Only the current header line is buffered; the body goes to on_body.
+typedef struct
+{
+    uint16_t status_code;      // 0 until the status line has been parsed.
+    int32_t content_length;    // -1 when the server did not send Content-Length.
+    uint8_t chunked;
+    uint32_t body_received;    // Decoded body bytes delivered so far.
+    wifi_http_body_cb_t on_body;
+    void *context;
+
+    // Parser state.
+    wifi_http_parse_state_t state;
+    char line[WIFI_HTTP_LINE_LEN];
+    uint16_t line_len;
+    uint32_t remaining;        // Bytes left in the body or the current chunk.
+} wifi_http_response_t;
+
+// Keep-alive session: requests to the same host:port reuse one TCP link until the server closes it.
+typedef struct
+{
+    wifi_handle_t *wifi;
+    const char *host_ip;
+    uint16_t port;
+    uint32_t connects; // Number of CIPSTART handshakes the session has needed so far.
+} wifi_http_session_t;
+
+wifi_status_t WiFi_HTTP_Send(wifi_handle_t *wifi, const char *method, const char *host_ip, uint16_t port, const char *path,
+                             const wifi_http_header_t *headers, const char *body, uint32_t timeout_ms, uint8_t max_retries);
+wifi_status_t WiFi_HTTP_POST(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
                              const char *body, uint32_t timeout_ms, uint8_t max_retries);
-wifi_status_t WiFi_HTTP_POST(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers, const char *body,
-                              uint32_t timeout_ms, uint8_t max_retries);
-wifi_status_t WiFi_HTTP_GET(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers, uint32_t timeout_ms,
-                             uint8_t max_retries);
-wifi_status_t WiFi_HTTP_PUT(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers, const char *body,
-                             uint32_t timeout_ms, uint8_t max_retries);
-wifi_status_t WiFi_HTTP_DELETE(const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
-                                uint32_t timeout_ms, uint8_t max_retries);
+wifi_status_t WiFi_HTTP_GET(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+                            uint32_t timeout_ms, uint8_t max_retries);
+wifi_status_t WiFi_HTTP_PUT(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+                            const char *body, uint32_t timeout_ms, uint8_t max_retries);
+wifi_status_t WiFi_HTTP_DELETE(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *path, const wifi_http_header_t *headers,
+                               uint32_t timeout_ms, uint8_t max_retries);
+// response is optional; pass one to read the status code and receive the body.
+wifi_status_t WiFi_HTTP_SendRequest(wifi_handle_t *wifi, const char *host_ip, uint16_t port, const wifi_http_request_t *request,
+                                    wifi_http_response_t *response, uint32_t timeout_ms, uint8_t max_retries);
+// max_retries caps the attempts; the policy decides the backoff between them (default WiFi_Retry_DefaultPolicy).
+void WiFi_HTTP_SetRetryPolicy(const wifi_retry_policy_t *policy);
+
+void WiFi_HTTP_Response_Init(wifi_http_response_t *response, wifi_http_body_cb_t on_body, void *context);
+// Feed raw response bytes (as carried by +IPD frames) into the parser.
+void WiFi_HTTP_Response_Feed(wifi_http_response_t *response, const uint8_t *data, uint16_t length);
+// Tell the parser the connection closed; completes bodies that are framed by connection close.
+void WiFi_HTTP_Response_Closed(wifi_http_response_t *response);
+uint8_t WiFi_HTTP_Response_IsComplete(const wifi_http_response_t *response);
+
+void WiFi_HTTP_Session_Init(wifi_http_session_t *session, wifi_handle_t *wifi, const char *host_ip, uint16_t port);
+wifi_status_t WiFi_HTTP_Session_Request(wifi_http_session_t *session, const char *method, const char *path,
+                                        const wifi_http_header_t *headers, const char *body, uint32_t timeout_ms, uint8_t max_retries);
+wifi_status_t WiFi_HTTP_Session_Send(wifi_http_session_t *session, const wifi_http_request_t *request, wifi_http_response_t *response,
+                                     uint32_t timeout_ms, uint8_t max_retries);
+uint8_t WiFi_HTTP_Session_IsOpen(const wifi_http_session_t *session);
+void WiFi_HTTP_Session_Close(wifi_http_session_t *session);
 
 #endif
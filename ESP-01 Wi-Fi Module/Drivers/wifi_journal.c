@@ -0,0 +1,540 @@
+#include "wifi_journal.h"
+
+// Body layout matches the telemetry uploads: [{"t":<timestamp>,"d":<payload>},{"t":...}]
+#define WIFI_JOURNAL_PIECE_LEN (WIFI_JOURNAL_PAYLOAD_LEN + 32)
+#define WIFI_JOURNAL_ERASED 0xFFFFFFFFU
+#define WIFI_JOURNAL_FIRST_RECORD ((uint32_t)sizeof(wifi_journal_segment_t))
+
+typedef enum
+{
+    WIFI_JOURNAL_END,      // Erased header or no room left: the segment's records stop here.
+    WIFI_JOURNAL_VALID,
+    WIFI_JOURNAL_CORRUPT   // Torn write or damaged data.
+} wifi_journal_load_t;
+
+static const wifi_http_header_t wifi_journal_headers[] = {
+    {"Content-Type", "application/json"},
+    {NULL, NULL}
+};
+
+static uint32_t wifi_journal_address(const wifi_journal_t *journal, wifi_journal_pos_t pos);
+static uint32_t wifi_journal_record_size(uint16_t length);
+static uint16_t wifi_journal_next_segment(const wifi_journal_t *journal, uint16_t segment);
+static uint8_t wifi_journal_read_segment(wifi_journal_t *journal, uint16_t segment, uint32_t *sequence);
+static wifi_status_t wifi_journal_format_segment(wifi_journal_t *journal, uint16_t segment);
+static wifi_journal_load_t wifi_journal_load(wifi_journal_t *journal, wifi_journal_pos_t pos, wifi_journal_record_t *record, char *payload);
+static uint8_t wifi_journal_is_blank(wifi_journal_t *journal, wifi_journal_pos_t pos);
+static void wifi_journal_settle(wifi_journal_t *journal, wifi_journal_pos_t *pos);
+static wifi_status_t wifi_journal_start_segment(wifi_journal_t *journal);
+static uint16_t wifi_journal_render(const wifi_journal_record_t *record, const char *payload, uint8_t first, char *out, uint16_t out_len);
+static uint16_t wifi_journal_piece(wifi_journal_t *journal, uint16_t index, char *out);
+static uint16_t wifi_journal_produce(uint32_t offset, uint8_t *buf, uint16_t max_len, void *context);
+
+wifi_status_t WiFi_Journal_Open(wifi_journal_t *journal, const wifi_journal_flash_t *flash, const wifi_journal_config_t *config)
+{
+    if (journal == NULL || flash == NULL || config == NULL || config->wifi == NULL || flash->read == NULL || flash->program == NULL ||
+        flash->erase == NULL || flash->segment_count < 2 || (flash->segment_size % 4U) != 0 ||
+        flash->segment_size < WIFI_JOURNAL_FIRST_RECORD + wifi_journal_record_size(WIFI_JOURNAL_PAYLOAD_LEN))
+    {
+        return WIFI_ERROR;
+    }
+
+    memset(journal, 0, sizeof(*journal));
+    journal->flash = *flash;
+    journal->config = *config;
+    if (journal->config.batch_bytes == 0)
+    {
+        journal->config.batch_bytes = WIFI_JOURNAL_BATCH_BYTES;
+    }
+    WiFi_HTTP_Session_Init(&journal->session, config->wifi, config->host_ip, config->port);
+
+    // The newest formatted segment is the one being filled; walk back over consecutive sequence
+    // numbers to find the oldest. Segments outside that run are stale and get reused first.
+    uint16_t newest = 0;
+    uint32_t newest_sequence = 0;
+    uint8_t found = 0;
+    for (uint16_t segment = 0; segment < flash->segment_count; segment++)
+    {
+        uint32_t sequence;
+        if (wifi_journal_read_segment(journal, segment, &sequence) && (!found || sequence > newest_sequence))
+        {
+            newest = segment;
+            newest_sequence = sequence;
+            found = 1;
+        }
+    }
+
+    if (!found)
+    {
+        journal->next_sequence = 1; // Blank or foreign store: format the first segment.
+        wifi_status_t status = wifi_journal_format_segment(journal, 0);
+        journal->write.segment = 0;
+        journal->write.offset = WIFI_JOURNAL_FIRST_RECORD;
+        journal->read = journal->write;
+        journal->open = (status == WIFI_OK);
+        return status;
+    }
+
+    uint16_t oldest = newest;
+    uint32_t oldest_sequence = newest_sequence;
+    for (uint16_t i = 1; i < flash->segment_count; i++)
+    {
+        uint16_t previous = (uint16_t)((oldest + flash->segment_count - 1U) % flash->segment_count);
+        uint32_t sequence;
+        if (!wifi_journal_read_segment(journal, previous, &sequence) || sequence != oldest_sequence - 1U)
+        {
+            break;
+        }
+        oldest = previous;
+        oldest_sequence = sequence;
+    }
+    journal->oldest_segment = oldest;
+    journal->next_sequence = newest_sequence + 1U;
+
+    // Replay from just after the last acknowledged record; everything after it is pending.
+    wifi_journal_pos_t resume = {oldest, WIFI_JOURNAL_FIRST_RECORD};
+    uint32_t unsent = 0;
+    uint16_t segment = oldest;
+    while (1)
+    {
+        wifi_journal_pos_t pos = {segment, WIFI_JOURNAL_FIRST_RECORD};
+        wifi_journal_record_t record;
+        wifi_journal_load_t load;
+        while ((load = wifi_journal_load(journal, pos, &record, NULL)) == WIFI_JOURNAL_VALID)
+        {
+            pos.offset += wifi_journal_record_size(record.length);
+            unsent++;
+            if (record.ack != WIFI_JOURNAL_ERASED)
+            {
+                resume = pos;
+                unsent = 0;
+            }
+        }
+        if (load == WIFI_JOURNAL_CORRUPT)
+        {
+            journal->stats.corrupt++; // The segment is closed here; later records were never written after it.
+        }
+
+        if (segment == newest)
+        {
+            journal->write = pos;
+            if (load == WIFI_JOURNAL_CORRUPT || !wifi_journal_is_blank(journal, pos))
+            {
+                journal->write.offset = flash->segment_size; // Never program over a torn write; start a fresh segment.
+            }
+            break;
+        }
+        segment = wifi_journal_next_segment(journal, segment);
+    }
+
+    journal->read = resume;
+    journal->pending = unsent;
+    wifi_journal_settle(journal, &journal->read);
+    journal->open = 1;
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Journal_Append(wifi_journal_t *journal, uint32_t timestamp, const char *payload)
+{
+    if (journal == NULL || !journal->open || payload == NULL)
+    {
+        return WIFI_ERROR;
+    }
+    size_t length = strlen(payload);
+    if (length > WIFI_JOURNAL_PAYLOAD_LEN)
+    {
+        return WIFI_ERROR;
+    }
+
+    uint32_t size = wifi_journal_record_size((uint16_t)length);
+    if (journal->write.offset + size > journal->flash.segment_size)
+    {
+        wifi_status_t status = wifi_journal_start_segment(journal);
+        if (status != WIFI_OK)
+        {
+            return status;
+        }
+    }
+
+    wifi_journal_record_t record;
+    record.ack = WIFI_JOURNAL_ERASED;
+    record.length = (uint16_t)length;
+    record.reserved = 0;
+    record.timestamp = timestamp;
+    record.crc = WiFi_Journal_CRC32(0, &record.length, 8);
+    record.crc = WiFi_Journal_CRC32(record.crc, payload, (uint32_t)length);
+
+    // Payload first, then the header that makes the record visible. A reset in between leaves an
+    // erased header over dirty bytes, which WiFi_Journal_Open detects.
+    uint8_t data[WIFI_JOURNAL_PAYLOAD_LEN + 4];
+    memset(data, 0xFF, sizeof(data));
+    memcpy(data, payload, length);
+    uint32_t address = wifi_journal_address(journal, journal->write);
+    uint32_t padded = size - (uint32_t)sizeof(record);
+    if ((padded > 0 && journal->flash.program(address + sizeof(record), data, padded, journal->flash.context) != WIFI_OK) ||
+        journal->flash.program(address + 4U, &record.length, sizeof(record) - 4U, journal->flash.context) != WIFI_OK)
+    {
+        journal->write.offset = journal->flash.segment_size; // Skip the damaged area.
+        return WIFI_ERROR;
+    }
+
+    journal->write.offset += size;
+    journal->pending++;
+    journal->stats.appended++;
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Journal_Replay(wifi_journal_t *journal)
+{
+    if (journal == NULL || !journal->open)
+    {
+        return WIFI_ERROR;
+    }
+    if (journal->pending == 0)
+    {
+        return WIFI_OK;
+    }
+    if (WiFi_IsNetworkDown(journal->config.wifi))
+    {
+        return WIFI_BUSY;
+    }
+
+    // Pick as many records as fit the batch size (always at least one). Body lengths are counted
+    // as if every record had a leading comma, plus the two brackets, minus one comma.
+    wifi_journal_pos_t pos = journal->read;
+    uint32_t body_length = 0;
+    uint16_t count = 0;
+    while (count < journal->pending && count < UINT16_MAX)
+    {
+        wifi_journal_record_t record;
+        char payload[WIFI_JOURNAL_PAYLOAD_LEN];
+        char piece[WIFI_JOURNAL_PIECE_LEN];
+
+        wifi_journal_settle(journal, &pos);
+        if (wifi_journal_load(journal, pos, &record, payload) != WIFI_JOURNAL_VALID)
+        {
+            break;
+        }
+        uint16_t length = wifi_journal_render(&record, payload, 0, piece, sizeof(piece));
+        if (count > 0 && body_length + length + 1U > journal->config.batch_bytes)
+        {
+            break;
+        }
+        body_length += length;
+        journal->batch_last = pos;
+        pos.offset += wifi_journal_record_size(record.length);
+        count++;
+    }
+    if (count == 0)
+    {
+        journal->pending = 0; // Nothing readable left (store damaged since WiFi_Journal_Open).
+        return WIFI_ERROR;
+    }
+
+    journal->batch_count = count;
+    journal->batch_body_length = body_length + 1U;
+    journal->batch_end = pos;
+    journal->render_index = 0;
+    journal->render_offset = 0;
+    journal->render_pos = journal->read;
+
+    wifi_http_request_t request = {0};
+    request.method = "POST";
+    request.path = journal->config.path;
+    request.headers = wifi_journal_headers;
+    request.body_length = journal->batch_body_length;
+    request.body_producer = wifi_journal_produce;
+    request.body_context = journal;
+
+    wifi_status_t status = WiFi_HTTP_Session_Send(&journal->session, &request, NULL, journal->config.timeout_ms,
+                                                  journal->config.max_retries);
+    if (status != WIFI_OK)
+    {
+        journal->stats.failed_batches++;
+        WIFI_LOG(DLOG_WIFI_JOURNAL_FAILED, count, journal->pending);
+        return status;
+    }
+
+    // One ack word per batch: on reopen, everything up to the last acknowledged record counts as sent.
+    // A failed ack write only means the batch is sent again after a reset.
+    uint32_t ack = 0;
+    (void)journal->flash.program(wifi_journal_address(journal, journal->batch_last), &ack, sizeof(ack), journal->flash.context);
+    journal->read = journal->batch_end;
+    wifi_journal_settle(journal, &journal->read);
+    journal->pending -= count;
+    journal->stats.replayed += count;
+    journal->stats.batches++;
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Journal_Poll(wifi_journal_t *journal)
+{
+    wifi_status_t status = WIFI_OK;
+    while (journal != NULL && journal->pending > 0 && status == WIFI_OK)
+    {
+        status = WiFi_Journal_Replay(journal);
+    }
+    return status;
+}
+
+uint32_t WiFi_Journal_Pending(const wifi_journal_t *journal)
+{
+    return (journal != NULL) ? journal->pending : 0U;
+}
+
+void WiFi_Journal_GetStats(const wifi_journal_t *journal, wifi_journal_stats_t *stats)
+{
+    if (journal != NULL && stats != NULL)
+    {
+        *stats = journal->stats;
+    }
+}
+
+// CRC-32 (IEEE, reflected), four bits per step. Pass 0 to start and the previous result to continue.
+uint32_t WiFi_Journal_CRC32(uint32_t crc, const void *data, uint32_t length)
+{
+    static const uint32_t table[16] = {
+        0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU, 0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+        0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU, 0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU
+    };
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        crc = (crc >> 4) ^ table[(crc ^ bytes[i]) & 0x0FU];
+        crc = (crc >> 4) ^ table[(crc ^ (bytes[i] >> 4)) & 0x0FU];
+    }
+    return ~crc;
+}
+
+static uint32_t wifi_journal_address(const wifi_journal_t *journal, wifi_journal_pos_t pos)
+{
+    return (uint32_t)pos.segment * journal->flash.segment_size + pos.offset;
+}
+
+static uint32_t wifi_journal_record_size(uint16_t length)
+{
+    return (uint32_t)sizeof(wifi_journal_record_t) + (((uint32_t)length + 3U) & ~3U);
+}
+
+static uint16_t wifi_journal_next_segment(const wifi_journal_t *journal, uint16_t segment)
+{
+    return (uint16_t)((segment + 1U) % journal->flash.segment_count);
+}
+
+static uint8_t wifi_journal_read_segment(wifi_journal_t *journal, uint16_t segment, uint32_t *sequence)
+{
+    wifi_journal_segment_t header;
+    if (journal->flash.read((uint32_t)segment * journal->flash.segment_size, &header, sizeof(header), journal->flash.context) != WIFI_OK ||
+        header.magic != WIFI_JOURNAL_MAGIC || header.crc != WiFi_Journal_CRC32(0, &header, 8))
+    {
+        return 0;
+    }
+    *sequence = header.sequence;
+    return 1;
+}
+
+static wifi_status_t wifi_journal_format_segment(wifi_journal_t *journal, uint16_t segment)
+{
+    if (journal->flash.erase(segment, journal->flash.context) != WIFI_OK)
+    {
+        return WIFI_ERROR;
+    }
+    journal->stats.erases++;
+
+    wifi_journal_segment_t header;
+    header.magic = WIFI_JOURNAL_MAGIC;
+    header.sequence = journal->next_sequence++;
+    header.crc = WiFi_Journal_CRC32(0, &header, 8);
+    header.reserved = WIFI_JOURNAL_ERASED;
+    return journal->flash.program((uint32_t)segment * journal->flash.segment_size, &header, sizeof(header), journal->flash.context);
+}
+
+// Reads the record at pos and checks its CRC. payload may be NULL when only the header is needed.
+static wifi_journal_load_t wifi_journal_load(wifi_journal_t *journal, wifi_journal_pos_t pos, wifi_journal_record_t *record, char *payload)
+{
+    char scratch[WIFI_JOURNAL_PAYLOAD_LEN];
+    uint32_t address = wifi_journal_address(journal, pos);
+
+    if (pos.offset + sizeof(*record) > journal->flash.segment_size ||
+        journal->flash.read(address, record, sizeof(*record), journal->flash.context) != WIFI_OK || record->length == 0xFFFFU)
+    {
+        return WIFI_JOURNAL_END;
+    }
+    if (record->length > WIFI_JOURNAL_PAYLOAD_LEN || pos.offset + wifi_journal_record_size(record->length) > journal->flash.segment_size)
+    {
+        return WIFI_JOURNAL_CORRUPT;
+    }
+
+    if (payload == NULL)
+    {
+        payload = scratch;
+    }
+    if (journal->flash.read(address + sizeof(*record), payload, record->length, journal->flash.context) != WIFI_OK)
+    {
+        return WIFI_JOURNAL_CORRUPT;
+    }
+    uint32_t crc = WiFi_Journal_CRC32(0, &record->length, 8);
+    crc = WiFi_Journal_CRC32(crc, payload, record->length);
+    return (crc == record->crc) ? WIFI_JOURNAL_VALID : WIFI_JOURNAL_CORRUPT;
+}
+
+static uint8_t wifi_journal_is_blank(wifi_journal_t *journal, wifi_journal_pos_t pos)
+{
+    uint8_t chunk[64];
+    uint32_t address = wifi_journal_address(journal, pos);
+    uint32_t remaining = journal->flash.segment_size - pos.offset;
+
+    while (remaining > 0)
+    {
+        uint32_t count = (remaining < sizeof(chunk)) ? remaining : (uint32_t)sizeof(chunk);
+        if (journal->flash.read(address, chunk, count, journal->flash.context) != WIFI_OK)
+        {
+            return 0;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (chunk[i] != 0xFFU)
+            {
+                return 0;
+            }
+        }
+        address += count;
+        remaining -= count;
+    }
+    return 1;
+}
+
+// Move pos past the end of finished segments until it points at a record or into the segment being
+// filled.
+static void wifi_journal_settle(wifi_journal_t *journal, wifi_journal_pos_t *pos)
+{
+    while (pos->segment != journal->write.segment)
+    {
+        wifi_journal_record_t record;
+        if (wifi_journal_load(journal, *pos, &record, NULL) == WIFI_JOURNAL_VALID)
+        {
+            return;
+        }
+        pos->segment = wifi_journal_next_segment(journal, pos->segment);
+        pos->offset = WIFI_JOURNAL_FIRST_RECORD;
+    }
+}
+
+// Erase the next segment in the ring and continue writing there. If that is the oldest segment,
+// its undelivered records are lost and counted.
+static wifi_status_t wifi_journal_start_segment(wifi_journal_t *journal)
+{
+    uint16_t next = wifi_journal_next_segment(journal, journal->write.segment);
+
+    if (next == journal->oldest_segment && next != journal->write.segment)
+    {
+        if (journal->pending > 0 && journal->read.segment == next)
+        {
+            wifi_journal_pos_t pos = journal->read;
+            wifi_journal_record_t record;
+            uint32_t lost = 0;
+            while (lost < journal->pending && wifi_journal_load(journal, pos, &record, NULL) == WIFI_JOURNAL_VALID)
+            {
+                pos.offset += wifi_journal_record_size(record.length);
+                lost++;
+            }
+            journal->pending -= lost;
+            journal->stats.dropped += lost;
+            journal->read.segment = wifi_journal_next_segment(journal, next);
+            journal->read.offset = WIFI_JOURNAL_FIRST_RECORD;
+        }
+        journal->oldest_segment = wifi_journal_next_segment(journal, next);
+    }
+
+    wifi_status_t status = wifi_journal_format_segment(journal, next);
+    journal->write.segment = next;
+    journal->write.offset = (status == WIFI_OK) ? WIFI_JOURNAL_FIRST_RECORD : journal->flash.segment_size;
+    if (journal->pending == 0)
+    {
+        journal->read = journal->write;
+    }
+    return status;
+}
+
+static uint16_t wifi_journal_render(const wifi_journal_record_t *record, const char *payload, uint8_t first, char *out, uint16_t out_len)
+{
+    int length = snprintf(out, out_len, "%s{\"t\":%lu,\"d\":%.*s}", first ? "" : ",", (unsigned long)record->timestamp, (int)record->length,
+                          payload);
+    return (length > 0) ? (uint16_t)length : 0U;
+}
+
+// Piece index 0 is '[', 1..batch_count are the records starting at render_pos, batch_count + 1 is ']'.
+static uint16_t wifi_journal_piece(wifi_journal_t *journal, uint16_t index, char *out)
+{
+    if (index == 0)
+    {
+        out[0] = '[';
+        return 1;
+    }
+    if (index > journal->batch_count)
+    {
+        out[0] = ']';
+        return 1;
+    }
+
+    wifi_journal_record_t record;
+    char payload[WIFI_JOURNAL_PAYLOAD_LEN];
+    wifi_journal_settle(journal, &journal->render_pos);
+    if (wifi_journal_load(journal, journal->render_pos, &record, payload) != WIFI_JOURNAL_VALID)
+    {
+        return 0;
+    }
+    return wifi_journal_render(&record, payload, (index == 1), out, WIFI_JOURNAL_PIECE_LEN);
+}
+
+// Body producer, same scheme as the telemetry one, with the records read back from the store as
+// they are sent. A retry restarts at offset 0.
+static uint16_t wifi_journal_produce(uint32_t offset, uint8_t *buf, uint16_t max_len, void *context)
+{
+    wifi_journal_t *journal = (wifi_journal_t *)context;
+    char piece[WIFI_JOURNAL_PIECE_LEN];
+
+    if (offset < journal->render_offset)
+    {
+        journal->render_index = 0;
+        journal->render_offset = 0;
+        journal->render_pos = journal->read;
+    }
+
+    uint16_t written = 0;
+    while (written < max_len && journal->render_index <= (uint16_t)(journal->batch_count + 1U))
+    {
+        uint16_t length = wifi_journal_piece(journal, journal->render_index, piece);
+        uint32_t piece_end = journal->render_offset + length;
+        uint32_t position = offset + written;
+
+        if (length == 0)
+        {
+            break; // Store changed under the batch; the request comes up short and fails.
+        }
+        if (position >= piece_end)
+        {
+            journal->render_offset = piece_end; // Piece already sent; move on.
+            if (journal->render_index >= 1 && journal->render_index <= journal->batch_count)
+            {
+                wifi_journal_record_t record;
+                wifi_journal_load(journal, journal->render_pos, &record, NULL);
+                journal->render_pos.offset += wifi_journal_record_size(record.length);
+            }
+            journal->render_index++;
+            continue;
+        }
+
+        uint16_t from = (uint16_t)(position - journal->render_offset);
+        uint16_t count = (uint16_t)(length - from);
+        if (count > (uint16_t)(max_len - written))
+        {
+            count = (uint16_t)(max_len - written);
+        }
+        memcpy(buf + written, piece + from, count);
+        written += count;
+    }
+    return written;
+}
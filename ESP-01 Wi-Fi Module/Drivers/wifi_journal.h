@@ -0,0 +1,135 @@
+#ifndef WIFI_JOURNAL_H
+#define WIFI_JOURNAL_H
+
+#include "wifi_http_support.h"
+
+#define WIFI_JOURNAL_PAYLOAD_LEN 64      // Longest payload of one record.
+#define WIFI_JOURNAL_BATCH_BYTES 4096    // Default replay body size; larger batches amortise the request overhead.
+#define WIFI_JOURNAL_MAGIC 0x4C4E4A57U   // "WJNL", starts every segment header.
+
+// Flash-like backing store split into equal erase units (segments). Programming may only clear
+// bits, erased bytes read 0xFF, and addresses and lengths passed to program are multiples of 4.
+typedef struct
+{
+    uint32_t segment_size;               // Bytes per erase unit; a multiple of 4.
+    uint16_t segment_count;              // At least 2: one is always being filled.
+    wifi_status_t (*read)(uint32_t address, void *data, uint32_t length, void *context);
+    wifi_status_t (*program)(uint32_t address, const void *data, uint32_t length, void *context);
+    wifi_status_t (*erase)(uint16_t segment, void *context);
+    void *context;
+} wifi_journal_flash_t;
+
+// On-flash layouts. A segment starts with a header and is filled with records front to back.
+typedef struct
+{
+    uint32_t magic;
+    uint32_t sequence;                   // Grows by one per segment opened, so the ring order survives a reset.
+    uint32_t crc;                        // CRC-32 of magic and sequence.
+    uint32_t reserved;
+} wifi_journal_segment_t;
+
+typedef struct
+{
+    uint32_t ack;                        // Erased until the batch ending with this record has been delivered.
+    uint16_t length;                     // Payload bytes; 0xFFFF means no record here yet.
+    uint16_t reserved;
+    uint32_t timestamp;                  // Caller's timestamp, sent as "t".
+    uint32_t crc;                        // CRC-32 of length, reserved, timestamp and the payload.
+} wifi_journal_record_t;                 // Followed by the payload, padded to 4 bytes.
+
+typedef struct
+{
+    wifi_handle_t *wifi;                 // Module the replay goes out on.
+    const char *host_ip;
+    uint16_t port;
+    const char *path;
+    uint32_t batch_bytes;                // Body size per replay request; 0 uses WIFI_JOURNAL_BATCH_BYTES.
+    uint32_t timeout_ms;                 // Passed to the HTTP request.
+    uint8_t max_retries;
+} wifi_journal_config_t;
+
+// Position of a record: segment index and byte offset inside it.
+typedef struct
+{
+    uint16_t segment;
+    uint32_t offset;
+} wifi_journal_pos_t;
+
+typedef struct
+{
+    uint32_t appended;
+    uint32_t replayed;                   // Records delivered by WiFi_Journal_Replay.
+    uint32_t batches;                    // Successful replay requests.
+    uint32_t failed_batches;
+    uint32_t dropped;                    // Unsent records erased because the ring was full.
+    uint32_t corrupt;                    // Torn or damaged records found by WiFi_Journal_Open.
+    uint32_t erases;
+} wifi_journal_stats_t;
+
+// Append-only record journal on a segment ring. Unsent records survive a reset and are replayed
+// in order as JSON array POSTs ([{"t":..,"d":..},...]) over a keep-alive session.
+typedef struct
+{
+    wifi_journal_flash_t flash;
+    wifi_journal_config_t config;
+    wifi_http_session_t session;
+    uint8_t open;
+
+    uint32_t next_sequence;
+    uint16_t oldest_segment;             // First segment still holding records.
+    wifi_journal_pos_t write;            // Next free byte in the segment being filled.
+    wifi_journal_pos_t read;             // First record not yet delivered.
+    uint32_t pending;                    // Records from read to write.
+    wifi_journal_stats_t stats;
+
+    // Replay state while a batch is being sent.
+    uint16_t batch_count;
+    uint32_t batch_body_length;
+    wifi_journal_pos_t batch_end;        // Record after the batch.
+    wifi_journal_pos_t batch_last;       // Last record of the batch; its ack word is written on success.
+    wifi_journal_pos_t render_pos;
+    uint16_t render_index;
+    uint32_t render_offset;
+} wifi_journal_t;
+
+// Scan the store and rebuild the ring after a reset: records are CRC-checked, the read position
+// follows the last acknowledged record, and an unformatted store starts empty.
+wifi_status_t WiFi_Journal_Open(wifi_journal_t *journal, const wifi_journal_flash_t *flash, const wifi_journal_config_t *config);
+// Store one record. payload is inserted into the replay body as-is, so it must be a JSON value.
+// When the ring is full the oldest segment is erased, dropping any unsent records in it.
+wifi_status_t WiFi_Journal_Append(wifi_journal_t *journal, uint32_t timestamp, const char *payload);
+// Send one batch of pending records. Returns WIFI_OK with nothing to do, WIFI_BUSY while the
+// network is down.
+wifi_status_t WiFi_Journal_Replay(wifi_journal_t *journal);
+// Replay until the journal is empty or a batch fails; call it from the main loop.
+wifi_status_t WiFi_Journal_Poll(wifi_journal_t *journal);
+uint32_t WiFi_Journal_Pending(const wifi_journal_t *journal);
+void WiFi_Journal_GetStats(const wifi_journal_t *journal, wifi_journal_stats_t *stats);
+uint32_t WiFi_Journal_CRC32(uint32_t crc, const void *data, uint32_t length);
+
+// STM32F4 internal flash backend (wifi_journal_flash.c): segment_count equal-sized sectors
+// starting at first_sector/base_address, e.g. sectors 12-15 (16 KB each) at 0x08100000 on an
+// STM32F439ZI.
+typedef struct
+{
+    uint32_t base_address;
+    uint32_t first_sector;
+} wifi_journal_stm32_t;
+
+void WiFi_Journal_Flash_STM32(wifi_journal_flash_t *flash, wifi_journal_stm32_t *stm32, uint32_t base_address, uint32_t first_sector,
+                              uint32_t segment_size, uint16_t segment_count);
+
+// Host backend (wifi_journal_file.c): a memory-mapped file behaving like NOR flash, for PC builds.
+typedef struct
+{
+    int fd;
+    uint8_t *data;
+    uint32_t size;
+    uint16_t segment_count;
+} wifi_journal_file_t;
+
+wifi_status_t WiFi_Journal_File_Open(wifi_journal_flash_t *flash, wifi_journal_file_t *file, const char *path, uint32_t segment_size,
+                                     uint16_t segment_count);
+void WiFi_Journal_File_Close(wifi_journal_file_t *file);
+
+#endif
@@ -0,0 +1,107 @@
+// Host backend: a memory-mapped file that behaves like NOR flash. Only built on POSIX systems.
+#if defined(__unix__) || defined(__APPLE__)
+
+#define _POSIX_C_SOURCE 200809L
+#include "wifi_journal.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static wifi_status_t wifi_journal_file_read(uint32_t address, void *data, uint32_t length, void *context)
+{
+    const wifi_journal_file_t *file = (const wifi_journal_file_t *)context;
+    if ((uint64_t)address + length > file->size)
+    {
+        return WIFI_ERROR;
+    }
+    memcpy(data, file->data + address, length);
+    return WIFI_OK;
+}
+
+// Programming can only clear bits, as on real flash, so writing over unerased data shows up as
+// corruption instead of silently working.
+static wifi_status_t wifi_journal_file_program(uint32_t address, const void *data, uint32_t length, void *context)
+{
+    wifi_journal_file_t *file = (wifi_journal_file_t *)context;
+    const uint8_t *bytes = (const uint8_t *)data;
+    if ((uint64_t)address + length > file->size || (address % 4U) != 0 || (length % 4U) != 0)
+    {
+        return WIFI_ERROR;
+    }
+    for (uint32_t i = 0; i < length; i++)
+    {
+        file->data[address + i] &= bytes[i];
+    }
+    return WIFI_OK;
+}
+
+static wifi_status_t wifi_journal_file_erase(uint16_t segment, void *context)
+{
+    wifi_journal_file_t *file = (wifi_journal_file_t *)context;
+    uint32_t segment_size = file->size / file->segment_count;
+    if (segment >= file->segment_count)
+    {
+        return WIFI_ERROR;
+    }
+    memset(file->data + (uint32_t)segment * segment_size, 0xFF, segment_size);
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Journal_File_Open(wifi_journal_flash_t *flash, wifi_journal_file_t *file, const char *path, uint32_t segment_size,
+                                     uint16_t segment_count)
+{
+    if (flash == NULL || file == NULL || path == NULL || segment_size == 0 || segment_count == 0)
+    {
+        return WIFI_ERROR;
+    }
+
+    struct stat info;
+    uint32_t size = segment_size * segment_count;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &info) != 0 || ((uint64_t)info.st_size < size && ftruncate(fd, size) != 0))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return WIFI_ERROR;
+    }
+
+    uint8_t *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(fd);
+        return WIFI_ERROR;
+    }
+    if ((uint64_t)info.st_size < size)
+    {
+        memset(data + info.st_size, 0xFF, size - (uint32_t)info.st_size); // New space reads as erased flash.
+    }
+
+    file->fd = fd;
+    file->data = data;
+    file->size = size;
+    file->segment_count = segment_count;
+    flash->segment_size = segment_size;
+    flash->segment_count = segment_count;
+    flash->read = wifi_journal_file_read;
+    flash->program = wifi_journal_file_program;
+    flash->erase = wifi_journal_file_erase;
+    flash->context = file;
+    return WIFI_OK;
+}
+
+void WiFi_Journal_File_Close(wifi_journal_file_t *file)
+{
+    if (file == NULL || file->data == NULL)
+    {
+        return;
+    }
+    msync(file->data, file->size, MS_SYNC);
+    munmap(file->data, file->size);
+    close(file->fd);
+    file->data = NULL;
+}
+
+#endif
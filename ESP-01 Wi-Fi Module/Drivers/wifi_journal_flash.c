@@ -0,0 +1,72 @@
+#include "wifi_journal.h"
+
+// STM32F4 internal flash backend. Only built where the HAL flash driver is available.
+#if defined(FLASH_TYPEERASE_SECTORS)
+
+static wifi_status_t wifi_journal_stm32_read(uint32_t address, void *data, uint32_t length, void *context)
+{
+    const wifi_journal_stm32_t *stm32 = (const wifi_journal_stm32_t *)context;
+    memcpy(data, (const void *)(uintptr_t)(stm32->base_address + address), length);
+    return WIFI_OK;
+}
+
+static wifi_status_t wifi_journal_stm32_program(uint32_t address, const void *data, uint32_t length, void *context)
+{
+    const wifi_journal_stm32_t *stm32 = (const wifi_journal_stm32_t *)context;
+    const uint8_t *bytes = (const uint8_t *)data;
+    wifi_status_t status = WIFI_OK;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < length && status == WIFI_OK; i += 4U)
+    {
+        uint32_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        if (word == 0xFFFFFFFFU)
+        {
+            continue; // Already erased; skipping keeps the word programmable later (the ack word).
+        }
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, stm32->base_address + address + i, word) != HAL_OK)
+        {
+            status = WIFI_ERROR;
+        }
+    }
+    HAL_FLASH_Lock();
+    return status;
+}
+
+static wifi_status_t wifi_journal_stm32_erase(uint16_t segment, void *context)
+{
+    const wifi_journal_stm32_t *stm32 = (const wifi_journal_stm32_t *)context;
+    FLASH_EraseInitTypeDef erase = {0};
+    uint32_t sector_error = 0;
+
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Sector = stm32->first_sector + segment;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef result = HAL_FLASHEx_Erase(&erase, &sector_error);
+    HAL_FLASH_Lock();
+    return (result == HAL_OK) ? WIFI_OK : WIFI_ERROR;
+}
+
+void WiFi_Journal_Flash_STM32(wifi_journal_flash_t *flash, wifi_journal_stm32_t *stm32, uint32_t base_address, uint32_t first_sector,
+                              uint32_t segment_size, uint16_t segment_count)
+{
+    if (flash == NULL || stm32 == NULL)
+    {
+        return;
+    }
+
+    stm32->base_address = base_address;
+    stm32->first_sector = first_sector;
+    flash->segment_size = segment_size;
+    flash->segment_count = segment_count;
+    flash->read = wifi_journal_stm32_read;
+    flash->program = wifi_journal_stm32_program;
+    flash->erase = wifi_journal_stm32_erase;
+    flash->context = stm32;
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "wifi_link.h"
+
+// Joins are slow and the module retries on its own for a while after a drop, so start gentler
+// than the per-request policy and settle at one attempt a minute.
+const wifi_retry_policy_t WiFi_Link_DefaultPolicy = {
+    .base_delay_ms = 2000,
+    .max_delay_ms = 60000,
+    .multiplier = 2,
+    .jitter_percent = 25,
+    .max_elapsed_ms = 0,
+};
+
+static void wifi_link_set_state(wifi_link_t *link, wifi_link_state_t state);
+static void wifi_link_start_join(wifi_link_t *link);
+static void wifi_link_joined(wifi_status_t status, void *context);
+
+wifi_status_t WiFi_Link_Init(wifi_link_t *link, wifi_handle_t *wifi, const wifi_link_config_t *config)
+{
+    if (link == NULL)
+    {
+        return WIFI_ERROR;
+    }
+    memset(link, 0, sizeof(*link)); // A rejected link stays stopped: WiFi_Link_Poll ignores it.
+    if (wifi == NULL || config == NULL || config->ssid == NULL || config->password == NULL || config->ssid[0] == '\0' ||
+        strlen(config->ssid) > WIFI_LINK_SSID_MAX || strlen(config->password) > WIFI_LINK_PASSWORD_MAX)
+    {
+        return WIFI_ERROR;
+    }
+
+    link->wifi = wifi;
+    link->config = *config;
+    if (link->config.policy == NULL)
+    {
+        link->config.policy = &WiFi_Link_DefaultPolicy;
+    }
+    if (link->config.join_timeout_ms == 0)
+    {
+        link->config.join_timeout_ms = WIFI_LINK_JOIN_TIMEOUT_MS;
+    }
+
+    WiFi_Retry_Begin(&link->retry, link->config.policy, 0);
+    link->state = WIFI_LINK_DOWN;
+    link->down_since_ms = HAL_GetTick();
+    link->next_join_ms = link->down_since_ms; // First join right away.
+    link->use_cache = (config->cache != NULL && config->cache->valid) ? 1U : 0U;
+    link->join_done = 0;
+    return WIFI_OK;
+}
+
+void WiFi_Link_Poll(wifi_link_t *link)
+{
+    if (link == NULL || link->wifi == NULL)
+    {
+        return;
+    }
+
+    WiFi_Poll(link->wifi);
+    uint32_t now = HAL_GetTick();
+
+    if (link->state == WIFI_LINK_JOINING)
+    {
+        if (!link->join_done)
+        {
+            return;
+        }
+        link->join_done = 0;
+
+        // A static IP never produces WIFI GOT IP, so the join's OK is the signal there.
+        if (link->join_status == WIFI_OK &&
+            (WiFi_GetStationState(link->wifi) == WIFI_STATION_GOT_IP || link->config.static_ip != NULL))
+        {
+            WiFi_Retry_Begin(&link->retry, link->config.policy, 0);
+            link->stats.last_down_ms = now - link->down_since_ms;
+            wifi_link_set_state(link, WIFI_LINK_UP);
+            return;
+        }
+
+        link->stats.join_failures++;
+        link->next_join_ms = now + WiFi_Retry_Backoff(&link->retry);
+        wifi_link_set_state(link, WIFI_LINK_DOWN);
+        return;
+    }
+
+    // The module rejoins on its own after short drops; follow it without queueing anything.
+    if (WiFi_GetStationState(link->wifi) == WIFI_STATION_GOT_IP)
+    {
+        if (link->state != WIFI_LINK_UP)
+        {
+            WiFi_Retry_Begin(&link->retry, link->config.policy, 0);
+            link->stats.last_down_ms = now - link->down_since_ms;
+            wifi_link_set_state(link, WIFI_LINK_UP);
+        }
+        return;
+    }
+
+    if (link->state == WIFI_LINK_UP)
+    {
+        if (!WiFi_IsNetworkDown(link->wifi))
+        {
+            return; // No station line seen yet (e.g. joined before WiFi_Init); trust the module.
+        }
+        link->stats.drops++;
+        link->down_since_ms = now;
+        link->use_cache = (link->config.cache != NULL && link->config.cache->valid) ? 1U : 0U;
+        // Give the module's own reconnect a head start before competing with it.
+        link->next_join_ms = now + WiFi_Retry_Backoff(&link->retry);
+        wifi_link_set_state(link, WIFI_LINK_DOWN);
+        return;
+    }
+
+    if ((int32_t)(now - link->next_join_ms) >= 0)
+    {
+        wifi_link_start_join(link);
+    }
+}
+
+wifi_link_state_t WiFi_Link_GetState(const wifi_link_t *link)
+{
+    return (link != NULL) ? link->state : WIFI_LINK_DOWN;
+}
+
+uint8_t WiFi_Link_IsUp(const wifi_link_t *link)
+{
+    return (link != NULL && link->state == WIFI_LINK_UP) ? 1U : 0U;
+}
+
+void WiFi_Link_GetStats(const wifi_link_t *link, wifi_link_stats_t *stats)
+{
+    if (link != NULL && stats != NULL)
+    {
+        *stats = link->stats;
+    }
+}
+
+static void wifi_link_set_state(wifi_link_t *link, wifi_link_state_t state)
+{
+    if (state == link->state)
+    {
+        return;
+    }
+
+    link->state = state;
+    if (state == WIFI_LINK_UP)
+    {
+        WIFI_LOG(DLOG_WIFI_LINK_UP, link->stats.last_down_ms);
+    }
+    else if (state == WIFI_LINK_DOWN)
+    {
+        WIFI_LOG(DLOG_WIFI_LINK_DOWN, link->next_join_ms - HAL_GetTick());
+    }
+    if (link->config.on_change != NULL)
+    {
+        link->config.on_change(state, link->config.context);
+    }
+}
+
+// Queue AT+CIPSTA (if configured) and AT+CWJAP; the queue runs them in order from WiFi_Poll, so
+// the main loop never blocks for the length of a join. Both go in together or not at all, so a
+// retry never queues a second CIPSTA.
+static void wifi_link_start_join(wifi_link_t *link)
+{
+    char ip_cmd[WIFI_CMD_LEN];
+    char join_cmd[WIFI_CMD_LEN];
+    uint8_t needed = 1;
+
+    ip_cmd[0] = '\0';
+    if (link->config.static_ip != NULL && link->config.static_ip->ip != NULL)
+    {
+        const wifi_static_ip_t *ip = link->config.static_ip;
+        if (ip->gateway != NULL && ip->netmask != NULL)
+        {
+            snprintf(ip_cmd, sizeof(ip_cmd), "AT+CIPSTA=\"%s\",\"%s\",\"%s\"\r\n", ip->ip, ip->gateway, ip->netmask);
+        }
+        else
+        {
+            snprintf(ip_cmd, sizeof(ip_cmd), "AT+CIPSTA=\"%s\"\r\n", ip->ip);
+        }
+        needed++;
+    }
+
+    uint8_t pinned = (link->use_cache && strcmp(link->config.cache->ssid, link->config.ssid) == 0) ? 1U : 0U;
+    int length;
+    if (pinned)
+    {
+        length = snprintf(join_cmd, sizeof(join_cmd), "AT+CWJAP=\"%s\",\"%s\",\"%s\"\r\n", link->config.ssid, link->config.password,
+                 link->config.cache->bssid);
+    }
+    else
+    {
+        length = snprintf(join_cmd, sizeof(join_cmd), "AT+CWJAP=\"%s\",\"%s\"\r\n", link->config.ssid, link->config.password);
+    }
+    if (length <= 0 || length >= (int)sizeof(join_cmd))
+    {
+        return; // Not reached: WiFi_Link_Init rejects an SSID or password that would not fit.
+    }
+
+    if ((uint8_t)(WIFI_CMD_QUEUE_LEN - WiFi_Command_Pending(link->wifi)) < needed)
+    {
+        return; // Queue full; try again on the next poll.
+    }
+    if (ip_cmd[0] != '\0' && WiFi_Command_Enqueue(link->wifi, ip_cmd, "OK", 2000, NULL, NULL) != WIFI_OK)
+    {
+        return;
+    }
+
+    link->join_done = 0;
+    if (WiFi_Command_Enqueue(link->wifi, join_cmd, "OK", link->config.join_timeout_ms, wifi_link_joined, link) != WIFI_OK)
+    {
+        return;
+    }
+    link->use_cache = 0; // Only the first attempt after a drop pins the BSSID; the AP may have moved.
+    link->stats.join_attempts++;
+    wifi_link_set_state(link, WIFI_LINK_JOINING);
+}
+
+static void wifi_link_joined(wifi_status_t status, void *context)
+{
+    wifi_link_t *link = (wifi_link_t *)context;
+    link->join_status = status;
+    link->join_done = 1;
+}
@@ -0,0 +1,69 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include "wifi_basic_driver.h"
+#include "wifi_retry.h"
+
+#define WIFI_LINK_JOIN_TIMEOUT_MS 15000U   // Used when the config leaves join_timeout_ms at 0.
+#define WIFI_LINK_SSID_MAX 32U             // 802.11 limit; WIFI_CMD_LEN fits it with the passphrase and a BSSID.
+#define WIFI_LINK_PASSWORD_MAX 63U         // Longest WPA2 passphrase.
+
+typedef enum
+{
+    WIFI_LINK_DOWN,                        // No IP; a reconnect is scheduled.
+    WIFI_LINK_JOINING,                     // AT+CWJAP queued or running.
+    WIFI_LINK_UP                           // Station has an IP.
+} wifi_link_state_t;
+
+// Called from WiFi_Link_Poll whenever the state changes.
+typedef void (*wifi_link_state_cb_t)(wifi_link_state_t state, void *context);
+
+typedef struct
+{
+    const char *ssid;                      // Must stay valid while the link manager runs.
+    const char *password;
+    const wifi_join_cache_t *cache;        // Optional: first reconnect after a drop pins this BSSID.
+    const wifi_static_ip_t *static_ip;     // Optional: re-applied before every join.
+    const wifi_retry_policy_t *policy;     // Delay between joins; NULL uses WiFi_Link_DefaultPolicy.
+    uint32_t join_timeout_ms;
+    wifi_link_state_cb_t on_change;
+    void *context;
+} wifi_link_config_t;
+
+typedef struct
+{
+    uint32_t drops;                        // UP -> DOWN transitions.
+    uint32_t join_attempts;                // AT+CWJAP commands queued by the manager.
+    uint32_t join_failures;
+    uint32_t last_down_ms;                 // How long the last outage lasted, once it is over.
+} wifi_link_stats_t;
+
+// One managed station; allocate one per module.
+typedef struct
+{
+    wifi_handle_t *wifi;
+    wifi_link_config_t config;
+    wifi_link_state_t state;
+    wifi_link_stats_t stats;
+    wifi_retry_t retry;
+    uint32_t next_join_ms;
+    uint32_t down_since_ms;
+    uint8_t use_cache;                     // Next join pins the cached BSSID.
+    volatile uint8_t join_done;
+    volatile wifi_status_t join_status;
+} wifi_link_t;
+
+extern const wifi_retry_policy_t WiFi_Link_DefaultPolicy;
+
+// Start managing the station. The config is copied; the strings it points to are not.
+// Returns WIFI_ERROR, and leaves the link stopped, for a missing SSID or password or one longer
+// than WIFI_LINK_SSID_MAX / WIFI_LINK_PASSWORD_MAX: no join could ever be sent for it.
+wifi_status_t WiFi_Link_Init(wifi_link_t *link, wifi_handle_t *wifi, const wifi_link_config_t *config);
+// Call from the main loop instead of WiFi_Poll: drives the command queue, follows the WIFI
+// DISCONNECT / CONNECTED / GOT IP lines and queues a join when the backoff delay has passed.
+void WiFi_Link_Poll(wifi_link_t *link);
+wifi_link_state_t WiFi_Link_GetState(const wifi_link_t *link);
+uint8_t WiFi_Link_IsUp(const wifi_link_t *link);
+void WiFi_Link_GetStats(const wifi_link_t *link, wifi_link_stats_t *stats);
+
+#endif
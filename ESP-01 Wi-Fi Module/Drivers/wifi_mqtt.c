@@ -0,0 +1,569 @@
+#include "wifi_mqtt.h"
+
+#define WIFI_MQTT_CONNECT     0x10U
+#define WIFI_MQTT_CONNACK     0x20U
+#define WIFI_MQTT_PUBLISH     0x30U
+#define WIFI_MQTT_PUBACK      0x40U
+#define WIFI_MQTT_SUBSCRIBE   0x82U // Reserved flags 0010.
+#define WIFI_MQTT_SUBACK      0x90U
+#define WIFI_MQTT_PINGREQ     0xC0U
+#define WIFI_MQTT_PINGRESP    0xD0U
+#define WIFI_MQTT_DISCONNECT  0xE0U
+
+#define WIFI_MQTT_MAX_SEND 2048U    // Largest single AT+CIPSEND the module accepts.
+
+static void wifi_mqtt_on_data(uint8_t link_id, const uint8_t *data, uint16_t length, void *context);
+static void wifi_mqtt_handle_packet(wifi_mqtt_client_t *client);
+static uint16_t wifi_mqtt_put_length(uint8_t *out, uint32_t length);
+static uint16_t wifi_mqtt_put_string(uint8_t *out, const char *text);
+static wifi_status_t wifi_mqtt_send(wifi_mqtt_client_t *client, const uint8_t *data, uint32_t length);
+static wifi_status_t wifi_mqtt_wait(wifi_mqtt_client_t *client, uint32_t timeout_ms);
+static void wifi_mqtt_expect(wifi_mqtt_client_t *client, uint8_t type, uint16_t packet_id);
+static uint16_t wifi_mqtt_packet_id(wifi_mqtt_client_t *client);
+static void wifi_mqtt_drop(wifi_mqtt_client_t *client);
+static uint8_t wifi_mqtt_ack(wifi_mqtt_client_t *client, uint16_t packet_id);
+static void wifi_mqtt_ack_flush(wifi_mqtt_client_t *client);
+static void wifi_mqtt_ack_done(wifi_status_t status, void *context);
+
+void WiFi_MQTT_Init(wifi_mqtt_client_t *client, wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *client_id,
+                    wifi_mqtt_message_cb_t on_message, void *context)
+{
+    if (client == NULL)
+    {
+        return;
+    }
+
+    memset(client, 0, sizeof(*client));
+    client->wifi = wifi;
+    client->host_ip = host_ip;
+    client->port = port;
+    client->client_id = client_id;
+    client->on_message = on_message;
+    client->context = context;
+    client->state = WIFI_MQTT_DISCONNECTED;
+    client->next_packet_id = 1;
+}
+
+wifi_status_t WiFi_MQTT_Connect(wifi_mqtt_client_t *client, const char *username, const char *password, uint16_t keep_alive_s,
+                                uint32_t timeout_ms)
+{
+    if (client == NULL || client->wifi == NULL || client->host_ip == NULL || client->client_id == NULL ||
+        WiFi_IsNetworkDown(client->wifi))
+    {
+        return WIFI_ERROR;
+    }
+    if (password != NULL && username == NULL)
+    {
+        return WIFI_ERROR; // MQTT 3.1.1 section 3.1.2.9: the password flag needs the user name flag.
+    }
+
+    // Variable header: protocol name, level 4 (3.1.1), flags, keep-alive; then the payload strings.
+    uint32_t body = 10U + 2U + strlen(client->client_id);
+    uint8_t flags = 0x02; // Clean session.
+    if (username != NULL)
+    {
+        flags |= 0x80;
+        body += 2U + strlen(username);
+    }
+    if (password != NULL)
+    {
+        flags |= 0x40;
+        body += 2U + strlen(password);
+    }
+    if (body + 5U > WIFI_MQTT_TX_LEN)
+    {
+        return WIFI_ERROR; // Checked before CIPSTART, so an oversize CONNECT never leaves a link open.
+    }
+
+    char cmd[128];
+    char address[WIFI_IP_LEN];
+    if (WiFi_Resolve(client->wifi, client->host_ip, address, sizeof(address)) != WIFI_OK)
+    {
+        WIFI_LOG(DLOG_WIFI_MQTT_CONNECT_FAILED);
+        return WIFI_ERROR;
+    }
+    snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"TCP\",\"%s\",%u\r\n", address, client->port);
+    if (WiFi_Send_Command(client->wifi, cmd, "OK", 5000) != WIFI_OK && !WiFi_IsLinkOpen(client->wifi))
+    {
+        WIFI_LOG(DLOG_WIFI_MQTT_CONNECT_FAILED);
+        return WIFI_ERROR;
+    }
+
+    client->keep_alive_s = keep_alive_s;
+    client->rx_len = 0;
+    client->rx_header_len = 0;
+    client->ping_outstanding = 0;
+    client->state = WIFI_MQTT_CONNECTING;
+    client->wifi->link_owner = client;
+    WiFi_SetDataHandler(client->wifi, wifi_mqtt_on_data, client);
+
+    uint8_t *p = client->tx;
+    *p++ = WIFI_MQTT_CONNECT;
+    p += wifi_mqtt_put_length(p, body);
+    p += wifi_mqtt_put_string(p, "MQTT");
+    *p++ = 4;
+    *p++ = flags;
+    *p++ = (uint8_t)(keep_alive_s >> 8);
+    *p++ = (uint8_t)keep_alive_s;
+    p += wifi_mqtt_put_string(p, client->client_id);
+    if (username != NULL)
+    {
+        p += wifi_mqtt_put_string(p, username);
+    }
+    if (password != NULL)
+    {
+        p += wifi_mqtt_put_string(p, password);
+    }
+
+    wifi_mqtt_expect(client, WIFI_MQTT_CONNACK, 0);
+    wifi_status_t status = wifi_mqtt_send(client, client->tx, (uint32_t)(p - client->tx));
+    if (status == WIFI_OK)
+    {
+        status = wifi_mqtt_wait(client, timeout_ms);
+    }
+    if (status == WIFI_OK && client->wait_code != 0)
+    {
+        WIFI_LOG(DLOG_WIFI_MQTT_REFUSED, client->wait_code);
+        status = WIFI_ERROR;
+    }
+    if (status != WIFI_OK)
+    {
+        wifi_mqtt_drop(client);
+        WiFi_Send_Command(client->wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+        return status;
+    }
+
+    client->state = WIFI_MQTT_CONNECTED;
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_MQTT_Publish(wifi_mqtt_client_t *client, const char *topic, const uint8_t *payload, uint16_t length, uint8_t qos,
+                                uint8_t retain, uint32_t timeout_ms)
+{
+    if (!WiFi_MQTT_IsConnected(client) || topic == NULL || qos > 1 || (payload == NULL && length > 0))
+    {
+        return WIFI_ERROR;
+    }
+
+    uint32_t topic_length = strlen(topic);
+    uint32_t header = 2U + topic_length + ((qos > 0) ? 2U : 0U);
+    if (header + 5U > WIFI_MQTT_TX_LEN)
+    {
+        return WIFI_ERROR;
+    }
+
+    uint16_t packet_id = 0;
+    uint8_t *p = client->tx;
+    *p++ = (uint8_t)(WIFI_MQTT_PUBLISH | (qos << 1) | (retain ? 1U : 0U));
+    p += wifi_mqtt_put_length(p, header + length);
+    p += wifi_mqtt_put_string(p, topic);
+    if (qos > 0)
+    {
+        packet_id = wifi_mqtt_packet_id(client);
+        *p++ = (uint8_t)(packet_id >> 8);
+        *p++ = (uint8_t)packet_id;
+        wifi_mqtt_expect(client, WIFI_MQTT_PUBACK, packet_id);
+    }
+
+    // Header from the staging buffer, payload straight from the caller; TCP joins them.
+    wifi_status_t status = wifi_mqtt_send(client, client->tx, (uint32_t)(p - client->tx));
+    if (status == WIFI_OK && length > 0)
+    {
+        status = wifi_mqtt_send(client, payload, length);
+    }
+    if (status == WIFI_OK && qos > 0)
+    {
+        status = wifi_mqtt_wait(client, timeout_ms);
+    }
+    client->wait_type = 0;
+    return status;
+}
+
+wifi_status_t WiFi_MQTT_Subscribe(wifi_mqtt_client_t *client, const char *topic_filter, uint8_t qos, uint32_t timeout_ms)
+{
+    if (!WiFi_MQTT_IsConnected(client) || topic_filter == NULL || qos > 1)
+    {
+        return WIFI_ERROR;
+    }
+
+    uint32_t body = 2U + 2U + strlen(topic_filter) + 1U;
+    if (body + 5U > WIFI_MQTT_TX_LEN)
+    {
+        return WIFI_ERROR;
+    }
+
+    uint16_t packet_id = wifi_mqtt_packet_id(client);
+    uint8_t *p = client->tx;
+    *p++ = WIFI_MQTT_SUBSCRIBE;
+    p += wifi_mqtt_put_length(p, body);
+    *p++ = (uint8_t)(packet_id >> 8);
+    *p++ = (uint8_t)packet_id;
+    p += wifi_mqtt_put_string(p, topic_filter);
+    *p++ = qos;
+
+    wifi_mqtt_expect(client, WIFI_MQTT_SUBACK, packet_id);
+    wifi_status_t status = wifi_mqtt_send(client, client->tx, (uint32_t)(p - client->tx));
+    if (status == WIFI_OK)
+    {
+        status = wifi_mqtt_wait(client, timeout_ms);
+    }
+    if (status == WIFI_OK && client->wait_code == 0x80)
+    {
+        status = WIFI_ERROR; // Broker rejected the filter.
+    }
+    client->wait_type = 0;
+    return status;
+}
+
+void WiFi_MQTT_Poll(wifi_mqtt_client_t *client)
+{
+    if (client == NULL)
+    {
+        return;
+    }
+
+    WiFi_Poll(client->wifi);
+    if (client->state != WIFI_MQTT_CONNECTED)
+    {
+        return;
+    }
+    if (!WiFi_IsLinkOpen(client->wifi))
+    {
+        WIFI_LOG(DLOG_WIFI_MQTT_CLOSED);
+        wifi_mqtt_drop(client);
+        return;
+    }
+
+    wifi_mqtt_ack_flush(client); // PUBACKs that found the command queue full.
+
+    if (client->keep_alive_s == 0)
+    {
+        return;
+    }
+
+    uint32_t now = HAL_GetTick();
+    uint32_t keep_alive_ms = (uint32_t)client->keep_alive_s * 1000U;
+    if (client->ping_outstanding && (now - client->ping_sent_ms) >= keep_alive_ms)
+    {
+        WIFI_LOG(DLOG_WIFI_MQTT_NO_PINGRESP);
+        wifi_mqtt_drop(client);
+        WiFi_Send_Command(client->wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+        return;
+    }
+    if (!client->ping_outstanding && (now - client->last_tx_ms) >= keep_alive_ms / 2U)
+    {
+        // Ping at half the keep-alive so the broker never sees the full interval pass in silence.
+        static const uint8_t pingreq[2] = {WIFI_MQTT_PINGREQ, 0};
+        if (wifi_mqtt_send(client, pingreq, sizeof(pingreq)) == WIFI_OK)
+        {
+            client->ping_outstanding = 1;
+            client->ping_sent_ms = now;
+        }
+    }
+}
+
+wifi_status_t WiFi_MQTT_Disconnect(wifi_mqtt_client_t *client)
+{
+    if (client == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    if (client->state == WIFI_MQTT_CONNECTED && WiFi_IsLinkOpen(client->wifi))
+    {
+        static const uint8_t disconnect[2] = {WIFI_MQTT_DISCONNECT, 0};
+        wifi_mqtt_send(client, disconnect, sizeof(disconnect));
+    }
+    wifi_mqtt_drop(client);
+
+    if (!WiFi_IsLinkOpen(client->wifi))
+    {
+        return WIFI_OK;
+    }
+    return WiFi_Send_Command(client->wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+}
+
+uint8_t WiFi_MQTT_IsConnected(const wifi_mqtt_client_t *client)
+{
+    return (client != NULL && client->state == WIFI_MQTT_CONNECTED && WiFi_IsLinkOpen(client->wifi)) ? 1U : 0U;
+}
+
+// Reassemble MQTT packets from +IPD payloads. A packet can span several frames and a frame can
+// hold several packets, so the fixed header is decoded byte by byte.
+static void wifi_mqtt_on_data(uint8_t link_id, const uint8_t *data, uint16_t length, void *context)
+{
+    wifi_mqtt_client_t *client = (wifi_mqtt_client_t *)context;
+    if (link_id != WIFI_LINK_SINGLE)
+    {
+        return;
+    }
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+        uint8_t byte = data[i];
+
+        if (client->rx_header_len == 0)
+        {
+            client->rx[0] = byte;
+            client->rx_header_len = 1;
+            client->rx_remaining = 0;
+            client->rx_multiplier = 1;
+            continue;
+        }
+
+        if (client->rx_len == 0 && (client->rx_header_len == 1 || (client->rx[client->rx_header_len - 1U] & 0x80U)))
+        {
+            // Remaining length: up to four 7-bit groups, least significant first.
+            client->rx_remaining += (uint32_t)(byte & 0x7FU) * client->rx_multiplier;
+            client->rx_multiplier *= 128U;
+            client->rx[client->rx_header_len++] = byte;
+            if ((byte & 0x80U) == 0)
+            {
+                client->rx_skip = (client->rx_remaining > (uint32_t)(WIFI_MQTT_RX_LEN - client->rx_header_len)) ? 1U : 0U;
+                client->rx_len = client->rx_header_len;
+                if (client->rx_remaining == 0)
+                {
+                    wifi_mqtt_handle_packet(client);
+                    client->rx_header_len = 0;
+                    client->rx_len = 0;
+                }
+            }
+            else if (client->rx_header_len >= 5)
+            {
+                client->rx_header_len = 0; // Malformed length; resynchronise on the next byte.
+            }
+            continue;
+        }
+
+        if (client->rx_len < WIFI_MQTT_RX_LEN)
+        {
+            client->rx[client->rx_len++] = byte; // A skipped packet keeps its start, which holds a PUBLISH's packet ID.
+        }
+        if (--client->rx_remaining == 0)
+        {
+            wifi_mqtt_handle_packet(client);
+            client->rx_header_len = 0;
+            client->rx_len = 0;
+        }
+    }
+}
+
+// rx holds one whole packet: fixed header (rx_header_len bytes) then the body. For a skipped packet
+// it only holds the first WIFI_MQTT_RX_LEN bytes.
+static void wifi_mqtt_handle_packet(wifi_mqtt_client_t *client)
+{
+    uint8_t type = client->rx[0] & 0xF0U;
+    const uint8_t *body = &client->rx[client->rx_header_len];
+    uint16_t body_length = (uint16_t)(client->rx_len - client->rx_header_len);
+
+    if (client->rx_skip)
+    {
+        // Too large to deliver, but a QoS 1 PUBLISH is still acknowledged or the broker would keep it in flight.
+        uint8_t qos = (client->rx[0] >> 1) & 0x03U;
+        if (type == WIFI_MQTT_PUBLISH && qos > 0 && body_length >= 2)
+        {
+            uint16_t topic_length = (uint16_t)((body[0] << 8) | body[1]);
+            if (4U + topic_length <= body_length)
+            {
+                wifi_mqtt_ack(client, (uint16_t)((body[2U + topic_length] << 8) | body[3U + topic_length]));
+            }
+        }
+        client->dropped++;
+        return;
+    }
+
+    switch (type)
+    {
+    case WIFI_MQTT_CONNACK:
+        if (client->wait_type == WIFI_MQTT_CONNACK && body_length >= 2)
+        {
+            client->wait_code = body[1];
+            client->wait_done = 1;
+        }
+        break;
+
+    case WIFI_MQTT_PUBACK:
+    case WIFI_MQTT_SUBACK:
+        if (client->wait_type == type && body_length >= 2 && client->wait_packet_id == (uint16_t)((body[0] << 8) | body[1]))
+        {
+            client->wait_code = (type == WIFI_MQTT_SUBACK && body_length >= 3) ? body[2] : 0U;
+            client->wait_done = 1;
+        }
+        break;
+
+    case WIFI_MQTT_PINGRESP:
+        client->ping_outstanding = 0;
+        break;
+
+    case WIFI_MQTT_PUBLISH:
+    {
+        uint8_t qos = (client->rx[0] >> 1) & 0x03U;
+        if (body_length < 2)
+        {
+            break;
+        }
+        uint16_t topic_length = (uint16_t)((body[0] << 8) | body[1]);
+        uint16_t offset = (uint16_t)(2U + topic_length + ((qos > 0) ? 2U : 0U));
+        if (offset > body_length)
+        {
+            break;
+        }
+
+        if (qos > 0 && !wifi_mqtt_ack(client, (uint16_t)((body[2U + topic_length] << 8) | body[3U + topic_length])))
+        {
+            client->dropped++; // Unacknowledged, so the broker still owns it; delivering now could lose the PUBACK.
+            break;
+        }
+        if (client->on_message != NULL)
+        {
+            client->on_message((const char *)&body[2], topic_length, &body[offset], (uint16_t)(body_length - offset), client->context);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+static uint16_t wifi_mqtt_put_length(uint8_t *out, uint32_t length)
+{
+    uint16_t count = 0;
+    do
+    {
+        uint8_t byte = (uint8_t)(length % 128U);
+        length /= 128U;
+        if (length > 0)
+        {
+            byte |= 0x80U;
+        }
+        out[count++] = byte;
+    } while (length > 0);
+    return count;
+}
+
+static uint16_t wifi_mqtt_put_string(uint8_t *out, const char *text)
+{
+    uint16_t length = (uint16_t)strlen(text);
+    out[0] = (uint8_t)(length >> 8);
+    out[1] = (uint8_t)length;
+    memcpy(&out[2], text, length);
+    return (uint16_t)(length + 2U);
+}
+
+static wifi_status_t wifi_mqtt_send(wifi_mqtt_client_t *client, const uint8_t *data, uint32_t length)
+{
+    char cmd[32];
+    while (length > 0)
+    {
+        uint16_t slice = (length > WIFI_MQTT_MAX_SEND) ? (uint16_t)WIFI_MQTT_MAX_SEND : (uint16_t)length;
+        snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u\r\n", slice);
+        wifi_status_t status = WiFi_Send_Payload(client->wifi, cmd, data, slice, "SEND OK", 5000);
+        if (status != WIFI_OK)
+        {
+            return status;
+        }
+        data += slice;
+        length -= slice;
+    }
+
+    client->last_tx_ms = HAL_GetTick();
+    return WIFI_OK;
+}
+
+static void wifi_mqtt_expect(wifi_mqtt_client_t *client, uint8_t type, uint16_t packet_id)
+{
+    client->wait_type = type;
+    client->wait_packet_id = packet_id;
+    client->wait_code = 0;
+    client->wait_done = 0; // Armed before sending, in case the reply shares a frame with SEND OK.
+}
+
+static wifi_status_t wifi_mqtt_wait(wifi_mqtt_client_t *client, uint32_t timeout_ms)
+{
+    uint32_t start = HAL_GetTick();
+    while (!client->wait_done)
+    {
+        WiFi_Poll(client->wifi);
+        wifi_mqtt_ack_flush(client);
+        if (!WiFi_IsLinkOpen(client->wifi))
+        {
+            return WIFI_ERROR;
+        }
+        if ((HAL_GetTick() - start) >= timeout_ms)
+        {
+            return WIFI_TIMEOUT;
+        }
+    }
+    client->wait_type = 0;
+    return WIFI_OK;
+}
+
+static uint16_t wifi_mqtt_packet_id(wifi_mqtt_client_t *client)
+{
+    uint16_t packet_id = client->next_packet_id++;
+    if (client->next_packet_id == 0)
+    {
+        client->next_packet_id = 1; // 0 is not a valid packet identifier.
+    }
+    return packet_id;
+}
+
+static void wifi_mqtt_drop(wifi_mqtt_client_t *client)
+{
+    client->state = WIFI_MQTT_DISCONNECTED;
+    client->wait_type = 0;
+    client->ping_outstanding = 0;
+    client->ack_count = client->ack_queued; // Queued PUBACKs still complete, and free their slots, from the driver.
+    if (client->wifi->link_owner == client)
+    {
+        client->wifi->link_owner = NULL;
+        WiFi_SetDataHandler(client->wifi, NULL, NULL);
+    }
+}
+
+// Reserve a PUBACK slot and hand it to the command queue straight away, so it goes out even while a
+// blocking call is polling. Returns 0 when every slot is taken.
+static uint8_t wifi_mqtt_ack(wifi_mqtt_client_t *client, uint16_t packet_id)
+{
+    if (client->ack_count >= WIFI_MQTT_ACK_QUEUE_LEN)
+    {
+        return 0;
+    }
+
+    uint8_t *puback = client->acks[(client->ack_head + client->ack_count) % WIFI_MQTT_ACK_QUEUE_LEN];
+    puback[0] = WIFI_MQTT_PUBACK;
+    puback[1] = 2;
+    puback[2] = (uint8_t)(packet_id >> 8);
+    puback[3] = (uint8_t)packet_id;
+    client->ack_count++;
+    wifi_mqtt_ack_flush(client);
+    return 1;
+}
+
+// One command queue entry is left free so blocking calls never see WIFI_BUSY because of PUBACKs.
+static void wifi_mqtt_ack_flush(wifi_mqtt_client_t *client)
+{
+    while (client->ack_queued < client->ack_count && WiFi_Command_Pending(client->wifi) < WIFI_CMD_QUEUE_LEN - 1U)
+    {
+        const uint8_t *puback = client->acks[(client->ack_head + client->ack_queued) % WIFI_MQTT_ACK_QUEUE_LEN];
+        if (WiFi_Command_EnqueueSend(client->wifi, "AT+CIPSEND=4\r\n", puback, 4, "SEND OK", 5000, wifi_mqtt_ack_done, client) != WIFI_OK)
+        {
+            return;
+        }
+        client->ack_queued++;
+    }
+}
+
+// The driver completes commands in order, so this is always the oldest queued PUBACK.
+static void wifi_mqtt_ack_done(wifi_status_t status, void *context)
+{
+    wifi_mqtt_client_t *client = (wifi_mqtt_client_t *)context;
+    client->ack_head = (uint8_t)((client->ack_head + 1U) % WIFI_MQTT_ACK_QUEUE_LEN);
+    client->ack_count--;
+    client->ack_queued--;
+    if (status == WIFI_OK)
+    {
+        client->last_tx_ms = HAL_GetTick();
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef WIFI_MQTT_H
+#define WIFI_MQTT_H
+
+#include "wifi_basic_driver.h"
+
+#define WIFI_MQTT_TX_LEN 128         // Fixed header, variable header and topic of an outgoing packet.
+#define WIFI_MQTT_RX_LEN 256         // Largest incoming packet kept; bigger ones are skipped.
+#define WIFI_MQTT_ACK_QUEUE_LEN 4    // PUBACKs that can wait for the module at once.
+
+// Called for every incoming PUBLISH. topic is not NUL-terminated; both pointers are only valid
+// during the call. Do not call other WiFi_MQTT_* functions from here.
+typedef void (*wifi_mqtt_message_cb_t)(const char *topic, uint16_t topic_length, const uint8_t *payload, uint16_t length,
+                                       void *context);
+
+typedef enum
+{
+    WIFI_MQTT_DISCONNECTED,
+    WIFI_MQTT_CONNECTING,
+    WIFI_MQTT_CONNECTED
+} wifi_mqtt_state_t;
+
+typedef struct
+{
+    wifi_handle_t *wifi;
+    const char *host_ip;
+    uint16_t port;
+    const char *client_id;
+    uint16_t keep_alive_s;
+    wifi_mqtt_message_cb_t on_message;
+    void *context;
+    wifi_mqtt_state_t state;
+
+    uint16_t next_packet_id;
+    uint32_t last_tx_ms;          // Keep-alive is measured from the last packet sent.
+    uint32_t ping_sent_ms;
+    uint8_t ping_outstanding;
+
+    // Acknowledgement a blocking call is waiting for.
+    uint8_t wait_type;            // Packet type (upper nibble), 0 when nothing is awaited.
+    uint16_t wait_packet_id;
+    volatile uint8_t wait_done;
+    uint8_t wait_code;            // CONNACK return code or SUBACK granted QoS.
+
+    // PUBACKs owed for incoming QoS 1 messages. A message is only delivered once its PUBACK has a
+    // slot here. The first ack_queued slots are in the driver's command queue, which completes them
+    // in order; the rest wait for room there.
+    uint8_t acks[WIFI_MQTT_ACK_QUEUE_LEN][4];
+    uint8_t ack_head;
+    uint8_t ack_count;
+    uint8_t ack_queued;
+
+    // Incoming packet reassembly.
+    uint8_t rx[WIFI_MQTT_RX_LEN];
+    uint16_t rx_len;
+    uint32_t rx_remaining;        // Bytes of the current packet still to come.
+    uint8_t rx_header_len;        // Fixed header bytes seen (type byte plus remaining-length bytes).
+    uint32_t rx_multiplier;
+    uint8_t rx_skip;              // Current packet does not fit rx and is being discarded.
+
+    uint8_t tx[WIFI_MQTT_TX_LEN];
+    uint32_t dropped;             // Incoming packets not delivered: too large, or a QoS 1 message with no free PUBACK slot.
+} wifi_mqtt_client_t;
+
+// Do not re-initialise a client while WiFi_Command_Pending() is non-zero: queued PUBACKs point into it.
+void WiFi_MQTT_Init(wifi_mqtt_client_t *client, wifi_handle_t *wifi, const char *host_ip, uint16_t port, const char *client_id,
+                    wifi_mqtt_message_cb_t on_message, void *context);
+// Open the TCP link and send CONNECT (clean session). username/password may be NULL, but a password
+// needs a username (MQTT 3.1.1 section 3.1.2.9).
+wifi_status_t WiFi_MQTT_Connect(wifi_mqtt_client_t *client, const char *username, const char *password, uint16_t keep_alive_s,
+                                uint32_t timeout_ms);
+// QoS 0 returns once the packet is sent; QoS 1 waits for the PUBACK.
+wifi_status_t WiFi_MQTT_Publish(wifi_mqtt_client_t *client, const char *topic, const uint8_t *payload, uint16_t length, uint8_t qos,
+                                uint8_t retain, uint32_t timeout_ms);
+wifi_status_t WiFi_MQTT_Subscribe(wifi_mqtt_client_t *client, const char *topic_filter, uint8_t qos, uint32_t timeout_ms);
+// Call from the main loop: receives messages, queues PUBACKs that are still waiting, and keeps the
+// connection alive.
+void WiFi_MQTT_Poll(wifi_mqtt_client_t *client);
+wifi_status_t WiFi_MQTT_Disconnect(wifi_mqtt_client_t *client);
+uint8_t WiFi_MQTT_IsConnected(const wifi_mqtt_client_t *client);
+
+#endif
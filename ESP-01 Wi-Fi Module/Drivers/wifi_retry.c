@@ -0,0 +1,220 @@
+#include "wifi_retry.h"
+
+typedef struct
+{
+    char host[WIFI_BREAKER_HOST_LEN];      // Empty when the slot is free.
+    uint8_t host_len;
+    uint16_t port;
+    wifi_breaker_state_t state;
+    uint8_t failures;                      // Consecutive failures while closed.
+    uint32_t opened_ms;
+    uint32_t last_used_ms;
+} wifi_breaker_t;
+
+const wifi_retry_policy_t WiFi_Retry_DefaultPolicy = {
+    .base_delay_ms = 250,
+    .max_delay_ms = 4000,
+    .multiplier = 2,
+    .jitter_percent = 50,
+    .max_elapsed_ms = 0,
+};
+
+static wifi_breaker_t wifi_breakers[WIFI_BREAKER_HOSTS];
+static uint32_t wifi_retry_seed = 0;
+
+static uint32_t wifi_retry_random(void);
+static wifi_breaker_t *wifi_breaker_find(const char *host, uint16_t port, uint8_t create);
+
+void WiFi_Retry_Begin(wifi_retry_t *retry, const wifi_retry_policy_t *policy, uint8_t max_attempts)
+{
+    if (retry == NULL)
+    {
+        return;
+    }
+
+    retry->policy = (policy != NULL) ? policy : &WiFi_Retry_DefaultPolicy;
+    retry->max_attempts = max_attempts;
+    retry->attempt = 0;
+    retry->started_ms = HAL_GetTick();
+    retry->delay_ms = retry->policy->base_delay_ms;
+}
+
+uint8_t WiFi_Retry_Next(wifi_retry_t *retry)
+{
+    if (retry == NULL || retry->attempt >= retry->max_attempts)
+    {
+        return 0;
+    }
+
+    if (retry->attempt > 0)
+    {
+        const wifi_retry_policy_t *policy = retry->policy;
+        uint32_t delay = WiFi_Retry_Backoff(retry);
+        if (policy->max_elapsed_ms > 0 && (HAL_GetTick() - retry->started_ms + delay) >= policy->max_elapsed_ms)
+        {
+            return 0; // The next attempt would start past the budget.
+        }
+        HAL_Delay(delay);
+    }
+
+    retry->attempt++;
+    return 1;
+}
+
+uint32_t WiFi_Retry_Backoff(wifi_retry_t *retry)
+{
+    if (retry == NULL)
+    {
+        return 0;
+    }
+
+    const wifi_retry_policy_t *policy = retry->policy;
+    uint32_t delay = retry->delay_ms;
+    if (policy->jitter_percent > 0 && delay > 0)
+    {
+        uint32_t spread = (delay * policy->jitter_percent) / 100U;
+        if (spread > 0)
+        {
+            delay -= wifi_retry_random() % (spread + 1U);
+        }
+    }
+
+    uint32_t next = retry->delay_ms * ((policy->multiplier > 0) ? policy->multiplier : 1U);
+    retry->delay_ms = (next > policy->max_delay_ms || next < retry->delay_ms) ? policy->max_delay_ms : next;
+    return delay;
+}
+
+uint8_t WiFi_Breaker_Allow(const char *host, uint16_t port)
+{
+    wifi_breaker_t *breaker = wifi_breaker_find(host, port, 0);
+    if (breaker == NULL)
+    {
+        return 1; // Never failed, so nothing to guard.
+    }
+
+    uint32_t now = HAL_GetTick();
+    breaker->last_used_ms = now;
+    switch (breaker->state)
+    {
+    case WIFI_BREAKER_OPEN:
+        if ((now - breaker->opened_ms) < WIFI_BREAKER_COOLDOWN_MS)
+        {
+            return 0;
+        }
+        breaker->state = WIFI_BREAKER_HALF_OPEN; // Let exactly one probe through.
+        breaker->opened_ms = now;                // Probe start, so a lost probe can expire.
+        return 1;
+
+    case WIFI_BREAKER_HALF_OPEN:
+        if ((now - breaker->opened_ms) < WIFI_BREAKER_COOLDOWN_MS)
+        {
+            return 0; // The probe has not reported back yet.
+        }
+        breaker->opened_ms = now; // The probe never reported back; let another one through.
+        return 1;
+
+    default:
+        return 1;
+    }
+}
+
+void WiFi_Breaker_Report(const char *host, uint16_t port, uint8_t success)
+{
+    wifi_breaker_t *breaker = wifi_breaker_find(host, port, success ? 0U : 1U);
+    if (breaker == NULL)
+    {
+        return;
+    }
+
+    breaker->last_used_ms = HAL_GetTick();
+    if (success)
+    {
+        breaker->state = WIFI_BREAKER_CLOSED;
+        breaker->failures = 0;
+        return;
+    }
+
+    if (breaker->state == WIFI_BREAKER_HALF_OPEN || ++breaker->failures >= WIFI_BREAKER_THRESHOLD)
+    {
+        if (breaker->state != WIFI_BREAKER_OPEN)
+        {
+            WIFI_LOG_TEXT(breaker->host, DLOG_WIFI_BREAKER_OPEN, breaker->port);
+        }
+        breaker->state = WIFI_BREAKER_OPEN;
+        breaker->opened_ms = breaker->last_used_ms;
+    }
+}
+
+wifi_breaker_state_t WiFi_Breaker_GetState(const char *host, uint16_t port)
+{
+    wifi_breaker_t *breaker = wifi_breaker_find(host, port, 0);
+    return (breaker != NULL) ? breaker->state : WIFI_BREAKER_CLOSED;
+}
+
+void WiFi_Breaker_Reset(void)
+{
+    memset(wifi_breakers, 0, sizeof(wifi_breakers));
+}
+
+// xorshift32, seeded from the tick counter so nodes that boot together still diverge over time.
+static uint32_t wifi_retry_random(void)
+{
+    if (wifi_retry_seed == 0)
+    {
+        wifi_retry_seed = HAL_GetTick() ^ 0x9E3779B9U;
+    }
+    wifi_retry_seed ^= wifi_retry_seed << 13;
+    wifi_retry_seed ^= wifi_retry_seed >> 17;
+    wifi_retry_seed ^= wifi_retry_seed << 5;
+    return wifi_retry_seed;
+}
+
+static wifi_breaker_t *wifi_breaker_find(const char *host, uint16_t port, uint8_t create)
+{
+    if (host == NULL)
+    {
+        return NULL;
+    }
+    size_t length = 0; // Bounded: a name that does not fit is not tracked, so it is not scanned further.
+    while (length < WIFI_BREAKER_HOST_LEN && host[length] != '\0')
+    {
+        length++;
+    }
+    if (length == 0 || length >= WIFI_BREAKER_HOST_LEN)
+    {
+        return NULL;
+    }
+
+    wifi_breaker_t *victim = &wifi_breakers[0];
+    for (uint8_t i = 0; i < WIFI_BREAKER_HOSTS; i++)
+    {
+        wifi_breaker_t *breaker = &wifi_breakers[i];
+        if (breaker->host[0] != '\0' && breaker->port == port && breaker->host_len == length && memcmp(breaker->host, host, length) == 0)
+        {
+            return breaker;
+        }
+        if (breaker->host[0] == '\0')
+        {
+            if (victim->host[0] != '\0')
+            {
+                victim = breaker; // Prefer a free slot.
+            }
+        }
+        else if (victim->host[0] != '\0' && (int32_t)(breaker->last_used_ms - victim->last_used_ms) < 0)
+        {
+            victim = breaker; // Older by tick distance, which stays right across the 49-day wrap.
+        }
+    }
+
+    if (!create)
+    {
+        return NULL;
+    }
+
+    memset(victim, 0, sizeof(*victim));
+    memcpy(victim->host, host, length);
+    victim->host_len = (uint8_t)length;
+    victim->port = port;
+    victim->state = WIFI_BREAKER_CLOSED;
+    return victim;
+}
@@ -0,0 +1,58 @@
+#ifndef WIFI_RETRY_H
+#define WIFI_RETRY_H
+
+#include "wifi_basic_driver.h"
+
+#define WIFI_BREAKER_HOSTS 4               // Destinations tracked at once; the least recently used is recycled.
+#define WIFI_BREAKER_HOST_LEN WIFI_DNS_NAME_LEN // Including the terminator; longer names get no breaker.
+#define WIFI_BREAKER_THRESHOLD 3           // Consecutive failures that open the breaker.
+#define WIFI_BREAKER_COOLDOWN_MS 30000U    // Time an open breaker fails fast before letting one probe through.
+
+// Exponential backoff: the delay before attempt n+1 is base * multiplier^(n-1), capped at
+// max_delay_ms, then reduced by a random share of up to jitter_percent so nodes spread out.
+typedef struct
+{
+    uint32_t base_delay_ms;
+    uint32_t max_delay_ms;
+    uint8_t multiplier;
+    uint8_t jitter_percent;
+    uint32_t max_elapsed_ms;               // No new attempt starts after this much time; 0 disables.
+} wifi_retry_policy_t;
+
+// One retry loop in progress.
+typedef struct
+{
+    const wifi_retry_policy_t *policy;
+    uint8_t max_attempts;
+    uint8_t attempt;                       // Attempts started so far.
+    uint32_t started_ms;
+    uint32_t delay_ms;                     // Un-jittered delay before the next attempt.
+} wifi_retry_t;
+
+typedef enum
+{
+    WIFI_BREAKER_CLOSED,                   // Requests flow normally.
+    WIFI_BREAKER_OPEN,                     // Host considered down; requests fail fast.
+    WIFI_BREAKER_HALF_OPEN                 // Cooldown over; one probe request is in flight (for up to one cooldown).
+} wifi_breaker_state_t;
+
+extern const wifi_retry_policy_t WiFi_Retry_DefaultPolicy;
+
+void WiFi_Retry_Begin(wifi_retry_t *retry, const wifi_retry_policy_t *policy, uint8_t max_attempts);
+// Returns 1 if another attempt may start, after sleeping the backoff delay (not before the first).
+uint8_t WiFi_Retry_Next(wifi_retry_t *retry);
+// Non-blocking form for state machines: returns the jittered delay to wait before the next attempt
+// and advances the backoff. Does not count attempts.
+uint32_t WiFi_Retry_Backoff(wifi_retry_t *retry);
+
+// Returns 0 while the destination's breaker is open, so callers can fail without touching the radio.
+// Every call that returns 1 must be followed by WiFi_Breaker_Report once the attempt is over.
+// Hosts are matched by their full name. A name that does not fit WIFI_BREAKER_HOST_LEN is never
+// tracked, rather than sharing a breaker with another name that starts the same way.
+uint8_t WiFi_Breaker_Allow(const char *host, uint16_t port);
+// Feed back the outcome of an attempt. Only transport failures should count as failures.
+void WiFi_Breaker_Report(const char *host, uint16_t port, uint8_t success);
+wifi_breaker_state_t WiFi_Breaker_GetState(const char *host, uint16_t port);
+void WiFi_Breaker_Reset(void);
+
+#endif
@@ -0,0 +1,179 @@
+#include "wifi_socket.h"
+#include "wifi_retry.h"
+
+#if (WIFI_SOCKET_RX_LEN & (WIFI_SOCKET_RX_LEN - 1U)) != 0
+#error "WIFI_SOCKET_RX_LEN must be a power of two"
+#endif
+
+#define WIFI_SOCKET_RX_MASK (WIFI_SOCKET_RX_LEN - 1U)
+
+static void wifi_socket_on_data(uint8_t link_id, const uint8_t *data, uint16_t length, void *context);
+
+wifi_status_t WiFi_Socket_Begin(wifi_sockets_t *sockets, wifi_handle_t *wifi)
+{
+    if (sockets == NULL || wifi == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    memset(sockets, 0, sizeof(*sockets));
+    sockets->wifi = wifi;
+    wifi_status_t status = WiFi_Send_Command(wifi, "AT+CIPMUX=1\r\n", "OK", 1000);
+    if (status != WIFI_OK)
+    {
+        return status;
+    }
+
+    WiFi_SetDataHandler(wifi, wifi_socket_on_data, sockets);
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Socket_Open(wifi_sockets_t *sockets, wifi_socket_type_t type, const char *host_ip, uint16_t port, uint8_t *link_id)
+{
+    if (sockets == NULL || sockets->wifi == NULL || host_ip == NULL || host_ip[0] == '\0' || link_id == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    // Pick the link and resolve the host first: once the breaker lets an attempt through, it has to
+    // hear the outcome.
+    uint8_t id = 0;
+    while (id < WIFI_MAX_LINKS && (sockets->links[id].in_use || WiFi_IsLinkIdOpen(sockets->wifi, id)))
+    {
+        id++;
+    }
+    if (id == WIFI_MAX_LINKS)
+    {
+        return WIFI_BUSY; // All five links are taken.
+    }
+
+    char cmd[128];
+    char address[WIFI_IP_LEN];
+    if (WiFi_IsNetworkDown(sockets->wifi) || WiFi_Resolve(sockets->wifi, host_ip, address, sizeof(address)) != WIFI_OK ||
+        !WiFi_Breaker_Allow(host_ip, port))
+    {
+        return WIFI_ERROR;
+    }
+    snprintf(cmd, sizeof(cmd), "AT+CIPSTART=%u,\"%s\",\"%s\",%u\r\n", id, (type == WIFI_SOCKET_UDP) ? "UDP" : "TCP", address, port);
+    if (WiFi_Send_Command(sockets->wifi, cmd, "OK", 5000) != WIFI_OK && !WiFi_IsLinkIdOpen(sockets->wifi, id))
+    {
+        WiFi_Breaker_Report(host_ip, port, 0);
+        return WIFI_ERROR;
+    }
+    WiFi_Breaker_Report(host_ip, port, 1);
+
+    wifi_socket_t *socket = &sockets->links[id];
+    socket->in_use = 1;
+    socket->rx_head = 0;
+    socket->rx_tail = 0;
+    socket->rx_dropped = 0;
+
+    *link_id = id;
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Socket_Send(wifi_sockets_t *sockets, uint8_t link_id, const uint8_t *data, uint16_t length, uint32_t timeout_ms)
+{
+    if (!WiFi_Socket_IsOpen(sockets, link_id) || data == NULL || length == 0)
+    {
+        return WIFI_ERROR;
+    }
+
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u,%u\r\n", link_id, length);
+    return WiFi_Send_Payload(sockets->wifi, cmd, data, length, "SEND OK", timeout_ms);
+}
+
+wifi_status_t WiFi_Socket_SendAsync(wifi_sockets_t *sockets, uint8_t link_id, const uint8_t *data, uint16_t length, uint32_t timeout_ms,
+                                    wifi_command_cb_t callback, void *context)
+{
+    if (!WiFi_Socket_IsOpen(sockets, link_id) || data == NULL || length == 0)
+    {
+        return WIFI_ERROR;
+    }
+
+    char cmd[32];
+    snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u,%u\r\n", link_id, length);
+    return WiFi_Command_EnqueueSend(sockets->wifi, cmd, data, length, "SEND OK", timeout_ms, callback, context);
+}
+
+uint16_t WiFi_Socket_Available(wifi_sockets_t *sockets, uint8_t link_id)
+{
+    if (sockets == NULL || link_id >= WIFI_MAX_LINKS)
+    {
+        return 0;
+    }
+    return (uint16_t)(sockets->links[link_id].rx_head - sockets->links[link_id].rx_tail);
+}
+
+uint16_t WiFi_Socket_Read(wifi_sockets_t *sockets, uint8_t link_id, uint8_t *out, uint16_t max_len)
+{
+    if (sockets == NULL || link_id >= WIFI_MAX_LINKS || out == NULL)
+    {
+        return 0;
+    }
+
+    wifi_socket_t *socket = &sockets->links[link_id];
+    uint16_t count = 0;
+    while (count < max_len && socket->rx_tail != socket->rx_head)
+    {
+        out[count++] = socket->rx[socket->rx_tail & WIFI_SOCKET_RX_MASK];
+        socket->rx_tail++;
+    }
+    return count;
+}
+
+uint32_t WiFi_Socket_GetDropped(wifi_sockets_t *sockets, uint8_t link_id)
+{
+    return (sockets != NULL && link_id < WIFI_MAX_LINKS) ? sockets->links[link_id].rx_dropped : 0U;
+}
+
+uint8_t WiFi_Socket_IsOpen(wifi_sockets_t *sockets, uint8_t link_id)
+{
+    if (sockets == NULL || link_id >= WIFI_MAX_LINKS)
+    {
+        return 0;
+    }
+    return (sockets->links[link_id].in_use && WiFi_IsLinkIdOpen(sockets->wifi, link_id)) ? 1U : 0U;
+}
+
+wifi_status_t WiFi_Socket_Close(wifi_sockets_t *sockets, uint8_t link_id)
+{
+    if (sockets == NULL || link_id >= WIFI_MAX_LINKS)
+    {
+        return WIFI_ERROR;
+    }
+
+    wifi_status_t status = WIFI_OK;
+    if (WiFi_IsLinkIdOpen(sockets->wifi, link_id))
+    {
+        char cmd[24];
+        snprintf(cmd, sizeof(cmd), "AT+CIPCLOSE=%u\r\n", link_id);
+        status = WiFi_Send_Command(sockets->wifi, cmd, "OK", 2000);
+    }
+
+    sockets->links[link_id].in_use = 0; // Unread bytes are discarded with the link.
+    return status;
+}
+
+// Demultiplex "+IPD,<id>,<len>:" payloads into the owning socket's queue.
+static void wifi_socket_on_data(uint8_t link_id, const uint8_t *data, uint16_t length, void *context)
+{
+    wifi_sockets_t *sockets = (wifi_sockets_t *)context;
+    if (link_id >= WIFI_MAX_LINKS)
+    {
+        return; // Single-link frame; not ours.
+    }
+
+    wifi_socket_t *socket = &sockets->links[link_id];
+    for (uint16_t i = 0; i < length; i++)
+    {
+        if ((uint16_t)(socket->rx_head - socket->rx_tail) >= WIFI_SOCKET_RX_LEN)
+        {
+            socket->rx_dropped += (uint32_t)(length - i);
+            return;
+        }
+        socket->rx[socket->rx_head & WIFI_SOCKET_RX_MASK] = data[i];
+        socket->rx_head++;
+    }
+}
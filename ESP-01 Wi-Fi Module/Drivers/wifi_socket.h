@@ -0,0 +1,50 @@
+#ifndef WIFI_SOCKET_H
+#define WIFI_SOCKET_H
+
+#include "wifi_basic_driver.h"
+
+#define WIFI_SOCKET_RX_LEN 256 // Per-socket receive queue; must be a power of two.
+
+typedef enum
+{
+    WIFI_SOCKET_TCP,
+    WIFI_SOCKET_UDP
+} wifi_socket_type_t;
+
+// One link ID and the payload bytes the module delivered for it.
+typedef struct
+{
+    uint8_t in_use;
+    uint8_t rx[WIFI_SOCKET_RX_LEN];
+    uint16_t rx_head; // Free-running write index (WiFi_Poll context).
+    uint16_t rx_tail; // Free-running read index (application).
+    uint32_t rx_dropped;
+} wifi_socket_t;
+
+// The five links of one module. Allocate one per wifi_handle_t running in multi-connection mode.
+typedef struct
+{
+    wifi_handle_t *wifi;
+    wifi_socket_t links[WIFI_MAX_LINKS];
+} wifi_sockets_t;
+
+// Switch the module to multi-connection mode (AT+CIPMUX=1) and start routing +IPD frames per link.
+// The single-connection helpers (WiFi_SendTCP, WiFi_HTTP_*) need AT+CIPMUX=0 and cannot be mixed in.
+wifi_status_t WiFi_Socket_Begin(wifi_sockets_t *sockets, wifi_handle_t *wifi);
+// Open a TCP or UDP link and return its link ID (0..WIFI_MAX_LINKS-1).
+wifi_status_t WiFi_Socket_Open(wifi_sockets_t *sockets, wifi_socket_type_t type, const char *host_ip, uint16_t port, uint8_t *link_id);
+// Blocking send on one link (AT+CIPSEND=<id>,<len>).
+wifi_status_t WiFi_Socket_Send(wifi_sockets_t *sockets, uint8_t link_id, const uint8_t *data, uint16_t length, uint32_t timeout_ms);
+// Queue a send and return immediately; data must stay valid until the callback runs.
+wifi_status_t WiFi_Socket_SendAsync(wifi_sockets_t *sockets, uint8_t link_id, const uint8_t *data, uint16_t length, uint32_t timeout_ms,
+                                    wifi_command_cb_t callback, void *context);
+// Bytes waiting in the link's receive queue (filled from WiFi_Poll()).
+uint16_t WiFi_Socket_Available(wifi_sockets_t *sockets, uint8_t link_id);
+uint16_t WiFi_Socket_Read(wifi_sockets_t *sockets, uint8_t link_id, uint8_t *out, uint16_t max_len);
+// Bytes dropped because the link's receive queue was full.
+uint32_t WiFi_Socket_GetDropped(wifi_sockets_t *sockets, uint8_t link_id);
+// 1 while the link is handed out and the module has not reported it closed.
+uint8_t WiFi_Socket_IsOpen(wifi_sockets_t *sockets, uint8_t link_id);
+wifi_status_t WiFi_Socket_Close(wifi_sockets_t *sockets, uint8_t link_id);
+
+#endif
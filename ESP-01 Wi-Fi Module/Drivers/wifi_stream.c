@@ -0,0 +1,167 @@
+#include "wifi_stream.h"
+
+static void wifi_stream_written(wifi_status_t status, void *context);
+static wifi_status_t wifi_stream_wait(wifi_stream_t *stream, wifi_stream_buffer_t *buffer);
+
+wifi_status_t WiFi_Stream_Begin(wifi_stream_t *stream, wifi_handle_t *wifi, const char *host_ip, uint16_t port)
+{
+    // The passthrough flag lives on the handle: the stream may be uninitialised, and a second
+    // stream on the same module must not send AT commands into the first one's data.
+    if (stream == NULL || wifi == NULL || host_ip == NULL || host_ip[0] == '\0' || wifi->passthrough)
+    {
+        return WIFI_ERROR;
+    }
+    if (WiFi_IsNetworkDown(wifi)) // No AP.
+    {
+        return WIFI_ERROR;
+    }
+    memset(stream, 0, sizeof(*stream));
+    stream->wifi = wifi;
+
+    char cmd[128];
+    char address[WIFI_IP_LEN];
+    if (WiFi_Resolve(wifi, host_ip, address, sizeof(address)) != WIFI_OK)
+    {
+        WIFI_LOG(DLOG_WIFI_STREAM_CONNECT_FAILED);
+        return WIFI_ERROR;
+    }
+    snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"TCP\",\"%s\",%u\r\n", address, port);
+    if (WiFi_Send_Command(stream->wifi, cmd, "OK", 5000) != WIFI_OK && !WiFi_IsLinkOpen(stream->wifi))
+    {
+        WIFI_LOG(DLOG_WIFI_STREAM_CONNECT_FAILED);
+        return WIFI_ERROR;
+    }
+
+    wifi_status_t status = WiFi_Send_Command(stream->wifi, "AT+CIPMODE=1\r\n", "OK", 1000);
+    if (status == WIFI_OK)
+    {
+        status = WiFi_Send_Command(stream->wifi, "AT+CIPSEND\r\n", ">", 2000); // No length: transparent transmission starts.
+    }
+    if (status != WIFI_OK)
+    {
+        WiFi_Send_Command(stream->wifi, "AT+CIPMODE=0\r\n", "OK", 1000);
+        WiFi_Send_Command(stream->wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+        return status;
+    }
+
+    stream->active = 1;
+    wifi->passthrough = 1;
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Stream_Write(wifi_stream_t *stream, const uint8_t *data, uint16_t length)
+{
+    if (stream == NULL || !stream->active)
+    {
+        return WIFI_ERROR;
+    }
+    return WiFi_SendRaw(stream->wifi, data, length);
+}
+
+wifi_status_t WiFi_Stream_Source(wifi_stream_t *stream, wifi_stream_producer_t producer, void *context, uint32_t *bytes_sent)
+{
+    if (stream == NULL || !stream->active || producer == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    uint32_t total = 0;
+    wifi_status_t status = WIFI_OK;
+    uint8_t current = 0;
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        stream->buffers[i].busy = 0;
+        stream->buffers[i].status = WIFI_OK;
+    }
+    while (status == WIFI_OK)
+    {
+        wifi_stream_buffer_t *buffer = &stream->buffers[current];
+        status = wifi_stream_wait(stream, buffer); // This half's previous transmit must be done before refilling it.
+        if (status != WIFI_OK)
+        {
+            break;
+        }
+
+        uint16_t length = producer(buffer->data, WIFI_STREAM_CHUNK_LEN, context);
+        if (length == 0)
+        {
+            break;
+        }
+        if (length > WIFI_STREAM_CHUNK_LEN)
+        {
+            length = WIFI_STREAM_CHUNK_LEN;
+        }
+
+        buffer->busy = 1;
+        status = WiFi_Command_EnqueueRaw(stream->wifi, buffer->data, length, NULL, 1000, wifi_stream_written, buffer);
+        if (status != WIFI_OK)
+        {
+            buffer->busy = 0;
+            break;
+        }
+        total += length;
+        current ^= 1U;
+    }
+
+    // Drain both halves before returning so the caller's producer state can be released.
+    wifi_status_t drained = wifi_stream_wait(stream, &stream->buffers[0]);
+    if (drained == WIFI_OK)
+    {
+        drained = wifi_stream_wait(stream, &stream->buffers[1]);
+    }
+    if (status == WIFI_OK)
+    {
+        status = drained;
+    }
+
+    if (bytes_sent != NULL)
+    {
+        *bytes_sent = total;
+    }
+    return status;
+}
+
+// "+++" must arrive as its own packet, so the line has to stay quiet for the guard time on both sides.
+wifi_status_t WiFi_Stream_End(wifi_stream_t *stream)
+{
+    if (stream == NULL || !stream->active)
+    {
+        return WIFI_OK;
+    }
+
+    HAL_Delay(WIFI_STREAM_GUARD_MS);
+    WiFi_SendRaw(stream->wifi, (const uint8_t *)"+++", 3);
+    HAL_Delay(WIFI_STREAM_GUARD_MS);
+    stream->active = 0;
+    stream->wifi->passthrough = 0;
+
+    wifi_status_t status = WiFi_Send_Command(stream->wifi, "AT+CIPMODE=0\r\n", "OK", 1000);
+    if (WiFi_IsLinkOpen(stream->wifi))
+    {
+        WiFi_Send_Command(stream->wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+    }
+    return status;
+}
+
+uint8_t WiFi_Stream_IsActive(const wifi_stream_t *stream)
+{
+    return (stream != NULL) ? stream->active : 0U;
+}
+
+static void wifi_stream_written(wifi_status_t status, void *context)
+{
+    wifi_stream_buffer_t *buffer = (wifi_stream_buffer_t *)context;
+    buffer->status = status;
+    buffer->busy = 0;
+}
+
+// Wait for a buffer's transmit to finish and report how it went.
+static wifi_status_t wifi_stream_wait(wifi_stream_t *stream, wifi_stream_buffer_t *buffer)
+{
+    while (buffer->busy)
+    {
+        WiFi_Poll(stream->wifi);
+    }
+    return buffer->status;
+}
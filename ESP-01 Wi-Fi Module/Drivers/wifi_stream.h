@@ -0,0 +1,41 @@
+#ifndef WIFI_STREAM_H
+#define WIFI_STREAM_H
+
+#include "wifi_basic_driver.h"
+
+#define WIFI_STREAM_CHUNK_LEN 256  // Size of each of the two buffers WiFi_Stream_Source alternates between.
+#define WIFI_STREAM_GUARD_MS 1000  // Silence required before and after "+++" to leave passthrough.
+
+// Fills buf with up to max_len bytes and returns how many were written; 0 ends the stream.
+typedef uint16_t (*wifi_stream_producer_t)(uint8_t *buf, uint16_t max_len, void *context);
+
+// Double buffer for WiFi_Stream_Source: one half is transmitting while the producer fills the other.
+typedef struct
+{
+    uint8_t data[WIFI_STREAM_CHUNK_LEN];
+    volatile uint8_t busy;
+    volatile wifi_status_t status;
+} wifi_stream_buffer_t;
+
+typedef struct
+{
+    wifi_handle_t *wifi;
+    wifi_stream_buffer_t buffers[2];
+    uint8_t active;
+} wifi_stream_t;
+
+// Open a TCP link and switch the module to transparent transmission (AT+CIPMODE=1, AT+CIPSEND).
+// From then on every byte written goes straight to the server without a per-packet CIPSEND.
+// Uses the single-connection link (AT+CIPMUX=0). Begin initialises the stream. It refuses while the
+// module has no AP, and while a stream is already active on the handle, since the module would take
+// any AT command as data.
+wifi_status_t WiFi_Stream_Begin(wifi_stream_t *stream, wifi_handle_t *wifi, const char *host_ip, uint16_t port);
+// Blocking write of raw bytes while streaming.
+wifi_status_t WiFi_Stream_Write(wifi_stream_t *stream, const uint8_t *data, uint16_t length);
+// Pull bytes from producer until it returns 0. One buffer is on the wire while the next is filled.
+wifi_status_t WiFi_Stream_Source(wifi_stream_t *stream, wifi_stream_producer_t producer, void *context, uint32_t *bytes_sent);
+// Leave transparent mode with the "+++" guard sequence, restore AT+CIPMODE=0 and close the link.
+wifi_status_t WiFi_Stream_End(wifi_stream_t *stream);
+uint8_t WiFi_Stream_IsActive(const wifi_stream_t *stream);
+
+#endif
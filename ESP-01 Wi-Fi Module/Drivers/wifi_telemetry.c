@@ -0,0 +1,245 @@
+#include "wifi_telemetry.h"
+
+// Body layout: [{"t":<timestamp>,"d":<payload>},{"t":...}]
+#define WIFI_TELEMETRY_PIECE_LEN (WIFI_TELEMETRY_RECORD_LEN + 32)
+
+static const wifi_http_header_t wifi_telemetry_headers[] = {
+    {"Content-Type", "application/json"},
+    {NULL, NULL}
+};
+
+static wifi_telemetry_record_t *wifi_telemetry_at(wifi_telemetry_t *telemetry, uint16_t index);
+static uint16_t wifi_telemetry_render(const wifi_telemetry_record_t *record, uint8_t first, char *out, uint16_t out_len);
+static uint16_t wifi_telemetry_piece(wifi_telemetry_t *telemetry, uint16_t index, char *out);
+static void wifi_telemetry_drop_front(wifi_telemetry_t *telemetry, uint16_t count);
+static void wifi_telemetry_spill(wifi_telemetry_t *telemetry, uint16_t count);
+static uint16_t wifi_telemetry_produce(uint32_t offset, uint8_t *buf, uint16_t max_len, void *context);
+
+void WiFi_Telemetry_Init(wifi_telemetry_t *telemetry, const wifi_telemetry_config_t *config)
+{
+    if (telemetry == NULL || config == NULL || config->wifi == NULL)
+    {
+        return;
+    }
+
+    memset(telemetry, 0, sizeof(*telemetry));
+    telemetry->config = *config;
+    if (telemetry->config.max_records == 0 || telemetry->config.max_records > WIFI_TELEMETRY_QUEUE_LEN)
+    {
+        telemetry->config.max_records = WIFI_TELEMETRY_QUEUE_LEN;
+    }
+    WiFi_HTTP_Session_Init(&telemetry->session, config->wifi, config->host_ip, config->port);
+}
+
+wifi_status_t WiFi_Telemetry_Add(wifi_telemetry_t *telemetry, uint32_t timestamp, const char *payload)
+{
+    if (telemetry == NULL || payload == NULL || strlen(payload) >= WIFI_TELEMETRY_RECORD_LEN)
+    {
+        return WIFI_ERROR;
+    }
+
+    if (telemetry->count == WIFI_TELEMETRY_QUEUE_LEN)
+    {
+        telemetry->dropped++;
+        if (telemetry->config.overflow == WIFI_TELEMETRY_DROP_NEWEST)
+        {
+            return WIFI_BUSY;
+        }
+        wifi_telemetry_drop_front(telemetry, 1);
+    }
+
+    wifi_telemetry_record_t *record = wifi_telemetry_at(telemetry, telemetry->count);
+    record->timestamp = timestamp;
+    record->queued_ms = HAL_GetTick();
+    strcpy(record->payload, payload);
+    telemetry->count++;
+    telemetry->added++;
+
+    // Only the first record's separator differs, so lengths are tracked as if each record had a
+    // leading comma, plus the two brackets, minus one comma.
+    char piece[WIFI_TELEMETRY_PIECE_LEN];
+    telemetry->body_length += wifi_telemetry_render(record, 0, piece, sizeof(piece));
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_Telemetry_Poll(wifi_telemetry_t *telemetry)
+{
+    if (telemetry == NULL || telemetry->count == 0)
+    {
+        return WIFI_OK;
+    }
+
+    const wifi_telemetry_config_t *config = &telemetry->config;
+    uint8_t due = (telemetry->count >= config->max_records);
+    if (config->max_bytes > 0 && (telemetry->body_length + 1U) >= config->max_bytes)
+    {
+        due = 1;
+    }
+    if (config->max_age_ms > 0 && (HAL_GetTick() - wifi_telemetry_at(telemetry, 0)->queued_ms) >= config->max_age_ms)
+    {
+        due = 1;
+    }
+
+    if (due && WiFi_IsNetworkDown(telemetry->config.wifi))
+    {
+        // Hold the batch while the AP is gone (Add keeps applying the overflow policy), or move it
+        // to the journal so it survives a long outage and a reset.
+        wifi_telemetry_spill(telemetry, telemetry->count);
+        return WIFI_OK;
+    }
+    return due ? WiFi_Telemetry_Flush(telemetry) : WIFI_OK;
+}
+
+wifi_status_t WiFi_Telemetry_Flush(wifi_telemetry_t *telemetry)
+{
+    if (telemetry == NULL)
+    {
+        return WIFI_ERROR;
+    }
+    if (telemetry->count == 0)
+    {
+        return WIFI_OK;
+    }
+
+    wifi_journal_t *journal = telemetry->config.journal;
+    if (journal != NULL && WiFi_Journal_Pending(journal) > 0)
+    {
+        wifi_status_t backlog = WiFi_Journal_Poll(journal);
+        if (backlog != WIFI_OK)
+        {
+            wifi_telemetry_spill(telemetry, telemetry->count); // Queue behind the backlog to keep the order.
+            return backlog;
+        }
+    }
+
+    telemetry->flush_count = telemetry->count;
+    telemetry->render_index = 0;
+    telemetry->render_offset = 0;
+
+    wifi_http_request_t request = {0};
+    request.method = "POST";
+    request.path = telemetry->config.path;
+    request.headers = wifi_telemetry_headers;
+    request.body_length = telemetry->body_length + 1U; // '[' and ']' replace the first record's comma.
+    request.body_producer = wifi_telemetry_produce;
+    request.body_context = telemetry;
+
+    wifi_status_t status = WiFi_HTTP_Session_Send(&telemetry->session, &request, NULL, telemetry->config.timeout_ms,
+                                                  telemetry->config.max_retries);
+    if (status != WIFI_OK)
+    {
+        telemetry->failed_flushes++;
+        WIFI_LOG(DLOG_WIFI_TELEMETRY_FAILED, telemetry->flush_count);
+        wifi_telemetry_spill(telemetry, telemetry->flush_count);
+        return status;
+    }
+
+    telemetry->flushes++;
+    telemetry->sent += telemetry->flush_count;
+    wifi_telemetry_drop_front(telemetry, telemetry->flush_count);
+    return WIFI_OK;
+}
+
+uint16_t WiFi_Telemetry_Count(const wifi_telemetry_t *telemetry)
+{
+    return (telemetry != NULL) ? telemetry->count : 0U;
+}
+
+static wifi_telemetry_record_t *wifi_telemetry_at(wifi_telemetry_t *telemetry, uint16_t index)
+{
+    return &telemetry->records[(telemetry->head + index) % WIFI_TELEMETRY_QUEUE_LEN];
+}
+
+static uint16_t wifi_telemetry_render(const wifi_telemetry_record_t *record, uint8_t first, char *out, uint16_t out_len)
+{
+    int length = snprintf(out, out_len, "%s{\"t\":%lu,\"d\":%s}", first ? "" : ",", (unsigned long)record->timestamp, record->payload);
+    return (length > 0) ? (uint16_t)length : 0U;
+}
+
+// Piece index 0 is '[', 1..flush_count are the records, flush_count + 1 is ']'.
+static uint16_t wifi_telemetry_piece(wifi_telemetry_t *telemetry, uint16_t index, char *out)
+{
+    if (index == 0)
+    {
+        out[0] = '[';
+        return 1;
+    }
+    if (index > telemetry->flush_count)
+    {
+        out[0] = ']';
+        return 1;
+    }
+    return wifi_telemetry_render(wifi_telemetry_at(telemetry, (uint16_t)(index - 1U)), (index == 1), out, WIFI_TELEMETRY_PIECE_LEN);
+}
+
+static void wifi_telemetry_drop_front(wifi_telemetry_t *telemetry, uint16_t count)
+{
+    char piece[WIFI_TELEMETRY_PIECE_LEN];
+    while (count-- > 0 && telemetry->count > 0)
+    {
+        telemetry->body_length -= wifi_telemetry_render(wifi_telemetry_at(telemetry, 0), 0, piece, sizeof(piece));
+        telemetry->head = (uint16_t)((telemetry->head + 1U) % WIFI_TELEMETRY_QUEUE_LEN);
+        telemetry->count--;
+    }
+}
+
+// Move the oldest records to the journal, if one is set. Records the journal rejects stay queued.
+static void wifi_telemetry_spill(wifi_telemetry_t *telemetry, uint16_t count)
+{
+    uint16_t moved = 0;
+    if (telemetry->config.journal == NULL)
+    {
+        return;
+    }
+
+    while (moved < count && moved < telemetry->count)
+    {
+        const wifi_telemetry_record_t *record = wifi_telemetry_at(telemetry, moved);
+        if (WiFi_Journal_Append(telemetry->config.journal, record->timestamp, record->payload) != WIFI_OK)
+        {
+            break;
+        }
+        moved++;
+    }
+    telemetry->journaled += moved;
+    wifi_telemetry_drop_front(telemetry, moved);
+}
+
+// Body producer: renders the pieces that overlap [offset, offset + max_len). Offsets normally grow
+// from call to call, so rendering resumes from the last piece; a retry restarts at offset 0.
+static uint16_t wifi_telemetry_produce(uint32_t offset, uint8_t *buf, uint16_t max_len, void *context)
+{
+    wifi_telemetry_t *telemetry = (wifi_telemetry_t *)context;
+    char piece[WIFI_TELEMETRY_PIECE_LEN];
+
+    if (offset < telemetry->render_offset)
+    {
+        telemetry->render_index = 0;
+        telemetry->render_offset = 0;
+    }
+
+    uint16_t written = 0;
+    while (written < max_len && telemetry->render_index <= (uint16_t)(telemetry->flush_count + 1U))
+    {
+        uint16_t length = wifi_telemetry_piece(telemetry, telemetry->render_index, piece);
+        uint32_t piece_end = telemetry->render_offset + length;
+        uint32_t position = offset + written;
+
+        if (position >= piece_end)
+        {
+            telemetry->render_offset = piece_end; // Piece already sent; move on.
+            telemetry->render_index++;
+            continue;
+        }
+
+        uint16_t from = (uint16_t)(position - telemetry->render_offset);
+        uint16_t count = (uint16_t)(length - from);
+        if (count > (uint16_t)(max_len - written))
+        {
+            count = (uint16_t)(max_len - written);
+        }
+        memcpy(buf + written, piece + from, count);
+        written += count;
+    }
+    return written;
+}
@@ -0,0 +1,73 @@
+#ifndef WIFI_TELEMETRY_H
+#define WIFI_TELEMETRY_H
+
+#include "wifi_journal.h"
+
+#define WIFI_TELEMETRY_QUEUE_LEN 32   // Records held between uploads.
+#define WIFI_TELEMETRY_RECORD_LEN 48  // Longest payload of one record, including the terminator.
+
+typedef enum
+{
+    WIFI_TELEMETRY_DROP_OLDEST, // A full queue discards its oldest record to make room.
+    WIFI_TELEMETRY_DROP_NEWEST  // A full queue rejects the new record.
+} wifi_telemetry_overflow_t;
+
+typedef struct
+{
+    wifi_handle_t *wifi;                 // Module the uploads go out on.
+    const char *host_ip;
+    uint16_t port;
+    const char *path;
+    uint16_t max_records;                // Flush once this many records are queued (1..WIFI_TELEMETRY_QUEUE_LEN).
+    uint32_t max_bytes;                  // Flush once the body would reach this size; 0 disables.
+    uint32_t max_age_ms;                 // Flush once the oldest record is this old; 0 disables.
+    wifi_telemetry_overflow_t overflow;
+    uint32_t timeout_ms;                 // Passed to the HTTP request.
+    uint8_t max_retries;
+    wifi_journal_t *journal;             // Optional: records that cannot be uploaded are moved here; NULL keeps them queued.
+} wifi_telemetry_config_t;
+
+typedef struct
+{
+    uint32_t timestamp;                  // Caller's timestamp, sent as "t".
+    uint32_t queued_ms;                  // HAL_GetTick() when queued, for the age threshold.
+    char payload[WIFI_TELEMETRY_RECORD_LEN];
+} wifi_telemetry_record_t;
+
+// Bounded record queue flushed as a single JSON array POST over a keep-alive session.
+typedef struct
+{
+    wifi_telemetry_config_t config;
+    wifi_http_session_t session;
+    wifi_telemetry_record_t records[WIFI_TELEMETRY_QUEUE_LEN];
+    uint16_t head;                       // Oldest record.
+    uint16_t count;
+    uint32_t body_length;                // Size of the JSON body for the queued records.
+
+    // Counters.
+    uint32_t added;
+    uint32_t dropped;                    // Records lost to the overflow policy.
+    uint32_t flushes;                    // Successful uploads.
+    uint32_t failed_flushes;
+    uint32_t sent;                       // Records delivered.
+    uint32_t journaled;                  // Records moved to the journal.
+
+    // Body rendering state while a flush is running.
+    uint16_t flush_count;
+    uint16_t render_index;
+    uint32_t render_offset;
+} wifi_telemetry_t;
+
+void WiFi_Telemetry_Init(wifi_telemetry_t *telemetry, const wifi_telemetry_config_t *config);
+// Queue one record. payload is inserted into the body as-is, so it must be a JSON value
+// (a number, a quoted string or an object). Returns WIFI_BUSY when DROP_NEWEST rejected it.
+wifi_status_t WiFi_Telemetry_Add(wifi_telemetry_t *telemetry, uint32_t timestamp, const char *payload);
+// Flush if a count, size or age threshold has been reached; call it from the main loop. With a
+// journal, a due batch goes to the journal while the network is down.
+wifi_status_t WiFi_Telemetry_Poll(wifi_telemetry_t *telemetry);
+// Upload everything that is queued now, after any journal backlog so the server sees records in
+// order. Records stay queued if the request fails, or move to the journal when one is set.
+wifi_status_t WiFi_Telemetry_Flush(wifi_telemetry_t *telemetry);
+uint16_t WiFi_Telemetry_Count(const wifi_telemetry_t *telemetry);
+
+#endif
@@ -0,0 +1,129 @@
+#include "wifi_udp.h"
+
+static void wifi_udp_sent(wifi_status_t status, void *context);
+
+wifi_status_t WiFi_UDP_Open(wifi_udp_t *udp, wifi_handle_t *wifi, const char *host_ip, uint16_t port)
+{
+    if (udp == NULL || wifi == NULL || host_ip == NULL || host_ip[0] == '\0' || WiFi_IsNetworkDown(wifi))
+    {
+        return WIFI_ERROR;
+    }
+
+    char cmd[128];
+    char address[WIFI_IP_LEN];
+    if (WiFi_Resolve(wifi, host_ip, address, sizeof(address)) != WIFI_OK)
+    {
+        return WIFI_ERROR;
+    }
+    snprintf(cmd, sizeof(cmd), "AT+CIPSTART=\"UDP\",\"%s\",%u\r\n", address, port);
+    if (WiFi_Send_Command(wifi, cmd, "OK", 5000) != WIFI_OK && !WiFi_IsLinkOpen(wifi))
+    {
+        return WIFI_ERROR;
+    }
+
+    memset(udp, 0, sizeof(*udp));
+    udp->wifi = wifi;
+    for (uint8_t i = 0; i < WIFI_UDP_SLOTS; i++)
+    {
+        udp->slots[i].stats = &udp->stats;
+    }
+    udp->open = 1;
+    return WIFI_OK;
+}
+
+wifi_status_t WiFi_UDP_Send(wifi_udp_t *udp, const uint8_t *data, uint16_t length)
+{
+    if (!WiFi_UDP_IsOpen(udp) || data == NULL || length == 0 || length > WIFI_UDP_MAX_PAYLOAD)
+    {
+        return WIFI_ERROR;
+    }
+
+    uint32_t sequence = udp->stats.next_sequence++;
+
+    uint8_t slot = 0;
+    while (slot < WIFI_UDP_SLOTS && udp->slots[slot].in_use)
+    {
+        slot++;
+    }
+    if (slot == WIFI_UDP_SLOTS)
+    {
+        udp->stats.dropped++; // Loss-tolerant by design: shed load instead of blocking.
+        return WIFI_BUSY;
+    }
+
+    uint8_t *buf = udp->slots[slot].data;
+    buf[0] = (uint8_t)(sequence >> 24);
+    buf[1] = (uint8_t)(sequence >> 16);
+    buf[2] = (uint8_t)(sequence >> 8);
+    buf[3] = (uint8_t)sequence;
+    memcpy(buf + WIFI_UDP_HEADER_LEN, data, length);
+
+    char cmd[32];
+    uint16_t total = (uint16_t)(WIFI_UDP_HEADER_LEN + length);
+    snprintf(cmd, sizeof(cmd), "AT+CIPSEND=%u\r\n", total);
+    udp->slots[slot].in_use = 1;
+    wifi_status_t status = WiFi_Command_EnqueueSend(udp->wifi, cmd, buf, total, "SEND OK", 1000, wifi_udp_sent, &udp->slots[slot]);
+    if (status != WIFI_OK)
+    {
+        udp->slots[slot].in_use = 0;
+        udp->stats.dropped++; // Command queue full, or no AP.
+    }
+    return status;
+}
+
+// Open until the module reports the link closed (for example after WIFI DISCONNECT).
+uint8_t WiFi_UDP_IsOpen(wifi_udp_t *udp)
+{
+    if (udp == NULL)
+    {
+        return 0;
+    }
+    if (udp->open && !WiFi_IsLinkOpen(udp->wifi))
+    {
+        udp->open = 0;
+    }
+    return udp->open;
+}
+
+void WiFi_UDP_GetStats(const wifi_udp_t *udp, wifi_udp_stats_t *stats)
+{
+    if (udp != NULL && stats != NULL)
+    {
+        *stats = udp->stats;
+    }
+}
+
+wifi_status_t WiFi_UDP_Close(wifi_udp_t *udp)
+{
+    if (udp == NULL || udp->wifi == NULL)
+    {
+        return WIFI_ERROR;
+    }
+
+    while (WiFi_Command_Pending(udp->wifi) > 0)
+    {
+        WiFi_Poll(udp->wifi); // Let queued datagrams finish so their slots are released.
+    }
+
+    udp->open = 0;
+    if (!WiFi_IsLinkOpen(udp->wifi))
+    {
+        return WIFI_OK;
+    }
+    return WiFi_Send_Command(udp->wifi, "AT+CIPCLOSE\r\n", "OK", 2000);
+}
+
+static void wifi_udp_sent(wifi_status_t status, void *context)
+{
+    wifi_udp_slot_t *slot = (wifi_udp_slot_t *)context;
+    slot->in_use = 0;
+
+    if (status == WIFI_OK)
+    {
+        slot->stats->sent++;
+    }
+    else
+    {
+        slot->stats->failed++;
+    }
+}
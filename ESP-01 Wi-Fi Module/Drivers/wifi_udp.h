@@ -0,0 +1,45 @@
+#ifndef WIFI_UDP_H
+#define WIFI_UDP_H
+
+#include "wifi_basic_driver.h"
+
+#define WIFI_UDP_MAX_PAYLOAD 256                // Largest datagram body accepted by WiFi_UDP_Send.
+#define WIFI_UDP_HEADER_LEN 4                   // Big-endian sequence number in front of every datagram.
+#define WIFI_UDP_SLOTS WIFI_CMD_QUEUE_LEN       // Datagrams that can wait for the module at once.
+
+typedef struct
+{
+    uint32_t next_sequence; // Sequence number the next WiFi_UDP_Send call will use.
+    uint32_t sent;          // Datagrams the module accepted (SEND OK).
+    uint32_t dropped;       // Datagrams discarded locally because every slot was busy.
+    uint32_t failed;        // Datagrams the module rejected or timed out on.
+} wifi_udp_stats_t;
+
+// One datagram waiting in the command queue: header and body in one buffer for a single CIPSEND.
+typedef struct
+{
+    uint8_t in_use;
+    wifi_udp_stats_t *stats; // Owner's counters, updated from the send callback.
+    uint8_t data[WIFI_UDP_HEADER_LEN + WIFI_UDP_MAX_PAYLOAD];
+} wifi_udp_slot_t;
+
+// One UDP uplink on a module's single link.
+typedef struct
+{
+    wifi_handle_t *wifi;
+    wifi_udp_slot_t slots[WIFI_UDP_SLOTS];
+    wifi_udp_stats_t stats;
+    uint8_t open;
+} wifi_udp_t;
+
+// Open the single-connection UDP link (AT+CIPSTART="UDP") and keep it for all later sends. Uses the
+// same link as WiFi_SendTCP and the HTTP helpers, so close it before using those.
+wifi_status_t WiFi_UDP_Open(wifi_udp_t *udp, wifi_handle_t *wifi, const char *host_ip, uint16_t port);
+// Queue one datagram and return immediately; WiFi_Poll() sends it. data is copied, so it may be
+// reused at once. Every call consumes a sequence number, so local drops show up as gaps at the receiver.
+wifi_status_t WiFi_UDP_Send(wifi_udp_t *udp, const uint8_t *data, uint16_t length);
+uint8_t WiFi_UDP_IsOpen(wifi_udp_t *udp);
+void WiFi_UDP_GetStats(const wifi_udp_t *udp, wifi_udp_stats_t *stats);
+wifi_status_t WiFi_UDP_Close(wifi_udp_t *udp);
+
+#endif
@@ -1,6 +1,11 @@
 #include "wifi_basic_driver.h"
 #include "wifi_http_support.h"
 
+static wifi_handle_t wifi; // ONE HANDLE PER ESP-01 MODULE
+
+// DRIVER MESSAGES GO THROUGH THE DEFERRED LOGGER: ADD deferred_log.c AND deferred_log_format.c FROM
+// "Deferred Logger/drivers" TO THE BUILD (OR DEFINE WIFI_DEBUG=0). WITHOUT DLog_Init() THEY ARE PRINTED WITH printf.
+
 int main(void)
 {
     HAL_Init();
@@ -8,14 +13,14 @@ int main(void)
     MX_USART1_UART_Init();    // USART CONNECTED TO ESP-01
     MX_USART3_UART_Init();    // SERIAL TERMINAL FOR LOGS
 
-    WiFi_Init(&huart1);       // INITIALIZE WI-FI MODULE
-    WiFi_Connect("MySSID", "MyPassword"); // CONNECT TO WIFI
+    WiFi_Init(&wifi, &huart1); // INITIALIZE WI-FI MODULE
+    WiFi_Connect(&wifi, "MySSID", "MyPassword"); // CONNECT TO WIFI
 
     char ip[64];
-    WiFi_GetIP(ip, sizeof(ip));    // FETCH THE IP ADDRESS
+    WiFi_GetIP(&wifi, ip, sizeof(ip));    // FETCH THE IP ADDRESS
     printf("IP: %s\r\n", ip);
 
-    WiFi_SendTCP("192.168.1.105", 5000, "Hello from STM32!\r\n");
+    WiFi_SendTCP(&wifi, "192.168.1.105", 5000, "Hello from STM32!\r\n");
 
     // SIMPLE HTTP HELPERS
     // Create an optional header list. Terminate with {NULL, NULL}.
@@ -25,14 +30,14 @@ int main(void)
     };
 
     // GET without a body
-    WiFi_HTTP_GET("192.168.1.200", 80, "/status", NULL, 5000, 3);
+    WiFi_HTTP_GET(&wifi, "192.168.1.200", 80, "/status", NULL, 5000, 3);
 
     // POST with a JSON body
-    WiFi_HTTP_POST("192.168.1.200", 80, "/items", headers, "{\"name\":\"demo\"}", 5000, 3);
+    WiFi_HTTP_POST(&wifi, "192.168.1.200", 80, "/items", headers, "{\"name\":\"demo\"}", 5000, 3);
 
     // PUT to update a resource
-    WiFi_HTTP_PUT("192.168.1.200", 80, "/items/1", headers, "{\"name\":\"updated\"}", 5000, 3);
+    WiFi_HTTP_PUT(&wifi, "192.168.1.200", 80, "/items/1", headers, "{\"name\":\"updated\"}", 5000, 3);
 
     // DELETE without a body
-    WiFi_HTTP_DELETE("192.168.1.200", 80, "/items/1", NULL, 5000, 3);
+    WiFi_HTTP_DELETE(&wifi, "192.168.1.200", 80, "/items/1", NULL, 5000, 3);
 }
@@ -0,0 +1,141 @@
+// Host benchmark behind the CBOR vs JSON table in the README. It encodes one telemetry sample (a
+// timestamp, a BME280 reading, an MQ-2 reading and a distance) both ways and reports the size and
+// the average encode time. Build from this directory:
+//
+//     BME="../../BME-280 Environmental Sensor/drivers"; MQ2="../../MQ-2 Gas Sensor/drivers"
+//     gcc -std=c11 -O2 -DWIFI_DEBUG=0 -Ihost -I../Drivers -I"$BME" -I"$MQ2" cbor_bench.c ../Drivers/wifi_cbor*.c -o cbor_bench
+//     ./cbor_bench [iterations] [output.cbor]
+//
+// The optional file receives the CBOR message, so it can be checked with any decoder
+// (python3 -c "import cbor2,sys; print(cbor2.load(open(sys.argv[1],'rb')))" output.cbor).
+
+#define _POSIX_C_SOURCE 200809L
+#include "wifi_cbor_sensors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct
+{
+    uint32_t timestamp;
+    bme280_reading_t environment;
+    gas_sensor_reading_t gas;
+    float distance_cm;
+} bench_sample_t;
+
+static void bench_encode(wifi_cbor_t *cbor, void *context);
+static int bench_json(char *out, size_t out_len, const bench_sample_t *sample);
+static double bench_seconds(void);
+
+int main(int argc, char **argv)
+{
+    long iterations = (argc > 1) ? strtol(argv[1], NULL, 10) : 1000000L;
+    if (iterations <= 0)
+    {
+        iterations = 1;
+    }
+
+    bench_sample_t sample = {1234567U, {21.37f, 45.12f, 101325.4f}, {2048U, 1.65f, 9876.5f, 0.873f}, 123.45f};
+    wifi_cbor_body_t body = {bench_encode, &sample};
+    uint8_t cbor[256];
+    char json[256];
+
+    uint32_t cbor_len = WiFi_CBOR_Measure(&body);
+    uint16_t written = WiFi_CBOR_Produce(0, cbor, sizeof(cbor), &body);
+    int json_len = bench_json(json, sizeof(json), &sample);
+    if (written != cbor_len)
+    {
+        fprintf(stderr, "measured %lu bytes but produced %u\n", (unsigned long)cbor_len, written);
+        return 1;
+    }
+
+    // The HTTP layer pulls the body in staging-buffer windows; they must add up to the same bytes.
+    uint8_t windowed[256];
+    uint32_t offset = 0;
+    while (offset < cbor_len)
+    {
+        uint16_t count = WiFi_CBOR_Produce(offset, &windowed[offset], 7, &body);
+        if (count == 0)
+        {
+            break;
+        }
+        offset += count;
+    }
+    if (offset != cbor_len || memcmp(windowed, cbor, cbor_len) != 0)
+    {
+        fprintf(stderr, "windowed output differs from the whole message\n");
+        return 1;
+    }
+
+    volatile uint32_t sink = 0;
+    double start = bench_seconds();
+    for (long i = 0; i < iterations; i++)
+    {
+        sample.timestamp = (uint32_t)i;
+        sink += WiFi_CBOR_Produce(0, cbor, sizeof(cbor), &body);
+    }
+    double cbor_time = (bench_seconds() - start) / (double)iterations;
+
+    start = bench_seconds();
+    for (long i = 0; i < iterations; i++)
+    {
+        sample.timestamp = (uint32_t)i;
+        sink += (uint32_t)bench_json(json, sizeof(json), &sample);
+    }
+    double json_time = (bench_seconds() - start) / (double)iterations;
+    (void)sink;
+
+    sample.timestamp = 1234567U;
+    WiFi_CBOR_Produce(0, cbor, sizeof(cbor), &body);
+    bench_json(json, sizeof(json), &sample);
+    printf("JSON: %s\n\n", json);
+    printf("%-24s %6s %12s\n", "Format", "Bytes", "Encode time");
+    printf("%-24s %6d %9.2f us\n", "JSON via snprintf (%.2f)", json_len, json_time * 1e6);
+    printf("%-24s %6lu %9.2f us\n", "CBOR", (unsigned long)cbor_len, cbor_time * 1e6);
+
+    if (argc > 2)
+    {
+        FILE *out = fopen(argv[2], "wb");
+        if (out == NULL || fwrite(cbor, 1, cbor_len, out) != cbor_len)
+        {
+            perror(argv[2]);
+            return 1;
+        }
+        fclose(out);
+    }
+    return 0;
+}
+
+// The same message the README example sends, plus the gas reading.
+static void bench_encode(wifi_cbor_t *cbor, void *context)
+{
+    const bench_sample_t *sample = (const bench_sample_t *)context;
+    WiFi_CBOR_Map(cbor, 4);
+    WiFi_CBOR_Text(cbor, "ts");
+    WiFi_CBOR_Uint(cbor, sample->timestamp);
+    WiFi_CBOR_Text(cbor, "env");
+    WiFi_CBOR_BME280(cbor, &sample->environment);
+    WiFi_CBOR_Text(cbor, "gas");
+    WiFi_CBOR_GasSensor(cbor, &sample->gas);
+    WiFi_CBOR_Text(cbor, "dist");
+    WiFi_CBOR_Distance(cbor, sample->distance_cm);
+}
+
+// The JSON a firmware would typically build for the same keys, rounded the usual way.
+static int bench_json(char *out, size_t out_len, const bench_sample_t *sample)
+{
+    return snprintf(out, out_len,
+                    "{\"ts\":%lu,\"env\":{\"t\":%.2f,\"h\":%.2f,\"p\":%.2f},\"gas\":{\"n\":%u,\"v\":%.3f,\"r\":%.1f,\"q\":%.3f},"
+                    "\"dist\":{\"d\":%.2f}}",
+                    (unsigned long)sample->timestamp, sample->environment.temperature_c, sample->environment.humidity_rh,
+                    sample->environment.pressure_pa, sample->gas.raw_counts, sample->gas.voltage_volts, sample->gas.resistance_ohms,
+                    sample->gas.ratio_vs_r0, sample->distance_cm);
+}
+
+static double bench_seconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
@@ -0,0 +1,734 @@
+#define _POSIX_C_SOURCE 200809L
+#include "esp_emulator.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define ESP_EMU_SEGMENT_LEN 1536 // Largest reply piece: an +IPD header plus ESP_EMU_IPD_LEN bytes.
+#define ESP_EMU_QUEUE_LEN 16     // Reply pieces waiting to go out on the wire.
+#define ESP_EMU_QUEUE_SPARE 4    // Kept free for command replies; server data waits instead.
+#define ESP_EMU_LINE_LEN 256
+#define ESP_EMU_SEND_LEN 2048    // Largest AT+CIPSEND the firmware accepts.
+#define ESP_EMU_RESET_US 300000U
+#define ESP_EMU_AP_BSSID "5c:cf:7f:00:00:aa" // The only AP in range.
+
+// A reply on its way to the driver. Bytes leave at the wire speed from due_us onwards.
+typedef struct
+{
+    uint64_t due_us;
+    uint32_t baud;       // Rate the module sent this piece at.
+    uint16_t length;
+    uint16_t sent;
+    uint8_t data[ESP_EMU_SEGMENT_LEN];
+} esp_emu_segment_t;
+
+typedef struct
+{
+    int fd; // -1 while the link is closed.
+    uint8_t udp;
+} esp_emu_link_t;
+
+static esp_emulator_config_t esp_emu_config;
+static esp_emulator_stats_t esp_emu_stats;
+static UART_HandleTypeDef *esp_emu_uart;
+static uint32_t esp_emu_seed;
+static uint32_t esp_emu_baud; // The module's own rate, changed by AT+UART_CUR.
+
+static esp_emu_segment_t esp_emu_queue[ESP_EMU_QUEUE_LEN];
+static uint8_t esp_emu_head;
+static uint8_t esp_emu_count;
+static uint64_t esp_emu_wire_free_us; // When the last queued byte has left the module.
+static uint64_t esp_emu_rx_end_us;    // When the last byte the driver sent has reached the module.
+
+static char esp_emu_line[ESP_EMU_LINE_LEN];
+static uint16_t esp_emu_line_len;
+static uint8_t esp_emu_echo;
+static uint8_t esp_emu_mux;
+static uint8_t esp_emu_cipmode;
+static uint8_t esp_emu_passthrough;
+static uint8_t esp_emu_joined;
+static char esp_emu_ssid[33];
+static uint8_t esp_emu_static_ip;      // AT+CIPSTA turned DHCP off.
+static char esp_emu_ip[16] = "192.168.4.2";
+
+static esp_emu_link_t esp_emu_links[ESP_EMU_LINKS];
+static uint8_t esp_emu_send_buf[ESP_EMU_SEND_LEN];
+static uint8_t esp_emu_send_link;
+static uint16_t esp_emu_send_len;      // Announced by AT+CIPSEND; 0 when no payload is expected.
+static uint16_t esp_emu_send_received;
+
+static void esp_emu_on_tx(const uint8_t *data, uint16_t length, void *context);
+static void esp_emu_service(void *context);
+static void esp_emu_command(const char *cmd);
+static void esp_emu_cipstart(const char *args, uint32_t delay_us);
+static void esp_emu_cipsend(const char *args, uint32_t delay_us);
+static void esp_emu_cipclose(const char *args, uint32_t delay_us);
+static void esp_emu_uart_cur(const char *args, uint32_t delay_us);
+static void esp_emu_send_done(void);
+static void esp_emu_poll_links(void);
+static void esp_emu_close(uint8_t id);
+static void esp_emu_close_all(uint32_t delay_us);
+static uint8_t esp_emu_parse_link(const char **args);
+static void esp_emu_queue_bytes(const uint8_t *data, uint16_t length, uint32_t delay_us);
+static void esp_emu_reply(uint32_t delay_us, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static void esp_emu_trace(const char *text);
+static uint32_t esp_emu_random(void);
+static uint32_t esp_emu_delay(void);
+static uint8_t esp_emu_inject(uint8_t percent);
+
+void ESP_Emulator_DefaultConfig(esp_emulator_config_t *config)
+{
+    memset(config, 0, sizeof(*config));
+    config->latency_us = 2000;  // Typical AT firmware turnaround for a short command.
+    config->join_ms = 300;      // DHCP on a quiet network.
+    config->seed = 1;
+}
+
+void ESP_Emulator_Start(const esp_emulator_config_t *config, UART_HandleTypeDef *huart)
+{
+    esp_emu_config = *config;
+    esp_emu_uart = huart;
+    esp_emu_seed = config->seed ? config->seed : 1U; // xorshift never leaves 0.
+    esp_emu_baud = huart->Init.BaudRate ? huart->Init.BaudRate : 115200U;
+    esp_emu_echo = 1; // The AT firmware boots with echo on.
+    for (uint8_t i = 0; i < ESP_EMU_LINKS; i++)
+    {
+        esp_emu_links[i].fd = -1;
+    }
+
+    fake_uart_peer_t peer = {esp_emu_on_tx, esp_emu_service, NULL};
+    Fake_UART_Attach(&peer);
+}
+
+void ESP_Emulator_GetStats(esp_emulator_stats_t *stats)
+{
+    *stats = esp_emu_stats;
+}
+
+void ESP_Emulator_DropAP(void)
+{
+    esp_emu_close_all(0);
+    esp_emu_joined = 0;
+    esp_emu_reply(0, "WIFI DISCONNECT\r\n");
+}
+
+// Bytes the driver transmitted: command lines, CIPSEND payloads, or passthrough data.
+// The fake UART hands over a whole transmission when it starts; the module only sees its end once
+// every byte has crossed the wire, so nothing it sends in reply may leave before that.
+static void esp_emu_on_tx(const uint8_t *data, uint16_t length, void *context)
+{
+    (void)context;
+    esp_emu_rx_end_us = Fake_HAL_Micros() + (uint64_t)length * 10000000U / esp_emu_uart->Init.BaudRate;
+    if (esp_emu_uart->Init.BaudRate != esp_emu_baud)
+    {
+        esp_emu_stats.garbled += length; // Framing errors at the module's rate; nothing is understood.
+        if (esp_emu_config.verbose)
+        {
+            fprintf(stderr, "%10.3f esp < %u bytes at %u baud, unreadable at %u\n", (double)Fake_HAL_Micros() / 1000.0, length,
+                    (unsigned int)esp_emu_uart->Init.BaudRate, (unsigned int)esp_emu_baud);
+        }
+        return;
+    }
+
+    uint16_t i = 0;
+    while (i < length)
+    {
+        if (esp_emu_send_len != 0)
+        {
+            uint16_t count = (uint16_t)(esp_emu_send_len - esp_emu_send_received);
+            if (count > length - i)
+            {
+                count = (uint16_t)(length - i);
+            }
+            memcpy(&esp_emu_send_buf[esp_emu_send_received], &data[i], count);
+            esp_emu_send_received = (uint16_t)(esp_emu_send_received + count);
+            i = (uint16_t)(i + count);
+            if (esp_emu_send_received == esp_emu_send_len)
+            {
+                esp_emu_send_done();
+            }
+            continue;
+        }
+
+        if (esp_emu_passthrough)
+        {
+            // "+++" on its own leaves passthrough; everything else goes straight to the link.
+            if (length - i == 3 && memcmp(&data[i], "+++", 3) == 0)
+            {
+                esp_emu_passthrough = 0;
+            }
+            else if (esp_emu_links[0].fd >= 0 && send(esp_emu_links[0].fd, &data[i], length - i, MSG_NOSIGNAL) > 0)
+            {
+                esp_emu_stats.bytes_up += (uint64_t)(length - i);
+            }
+            return;
+        }
+
+        char c = (char)data[i++];
+        if (esp_emu_line_len < ESP_EMU_LINE_LEN - 1)
+        {
+            esp_emu_line[esp_emu_line_len++] = c;
+        }
+        if (c == '\n')
+        {
+            esp_emu_line[esp_emu_line_len] = '\0';
+            if (esp_emu_echo)
+            {
+                esp_emu_queue_bytes((const uint8_t *)esp_emu_line, esp_emu_line_len, 0);
+            }
+            esp_emu_line[strcspn(esp_emu_line, "\r\n")] = '\0';
+            esp_emu_line_len = 0;
+            if (esp_emu_line[0] != '\0')
+            {
+                esp_emu_command(esp_emu_line);
+            }
+        }
+    }
+}
+
+static void esp_emu_command(const char *cmd)
+{
+    esp_emu_stats.commands++;
+    if (esp_emu_config.verbose)
+    {
+        const char *shown = (strncmp(cmd, "AT+CWJAP=", 9) == 0) ? "AT+CWJAP=..." : cmd; // Keep the passphrase out of logs.
+        fprintf(stderr, "%10.3f esp < %s\n", (double)Fake_HAL_Micros() / 1000.0, shown);
+    }
+    if (esp_emu_inject(esp_emu_config.busy_percent))
+    {
+        esp_emu_stats.injected_busy++;
+        esp_emu_reply(esp_emu_delay(), "busy p...\r\n");
+        return;
+    }
+
+    uint32_t delay = esp_emu_delay();
+    if (strcmp(cmd, "ATE0") == 0 || strcmp(cmd, "ATE1") == 0)
+    {
+        esp_emu_echo = (uint8_t)(cmd[3] - '0');
+        esp_emu_reply(delay, "\r\nOK\r\n");
+    }
+    else if (strcmp(cmd, "AT+RST") == 0)
+    {
+        esp_emu_reply(delay, "\r\nOK\r\n");
+        esp_emu_close_all(0);
+        esp_emu_joined = 0;
+        esp_emu_mux = 0;
+        esp_emu_cipmode = 0;
+        esp_emu_echo = 1;
+        esp_emu_reply(ESP_EMU_RESET_US, "\r\nready\r\n");
+    }
+    else if (strcmp(cmd, "AT+CWJAP?") == 0 || strcmp(cmd, "AT+CWJAP_CUR?") == 0)
+    {
+        if (esp_emu_joined)
+        {
+            esp_emu_reply(delay, "+CWJAP:\"%s\",\"" ESP_EMU_AP_BSSID "\",6,-55\r\n\r\nOK\r\n", esp_emu_ssid);
+        }
+        else
+        {
+            esp_emu_reply(delay, "No AP\r\n\r\nOK\r\n");
+        }
+    }
+    else if (strncmp(cmd, "AT+CWJAP=", 9) == 0 || strncmp(cmd, "AT+CWJAP_CUR=", 13) == 0)
+    {
+        if (esp_emu_joined)
+        {
+            esp_emu_close_all(delay);
+            esp_emu_reply(0, "WIFI DISCONNECT\r\n");
+        }
+        char bssid[18] = "";
+        if (sscanf(strchr(cmd, '=') + 1, "\"%32[^\"]\",\"%*[^\"]\",\"%17[^\"]\"", esp_emu_ssid, bssid) < 1)
+        {
+            esp_emu_reply(delay, "\r\nERROR\r\n");
+            return;
+        }
+        // A BSSID pins the AP, so only a join by SSID scans the channels first. A BSSID that is not
+        // in range fails once the scan has not found it (+CWJAP:3, "cannot find the target AP").
+        uint32_t connected_us = delay + ((bssid[0] != '\0') ? 0U : esp_emu_config.scan_ms * 1000U);
+        if (bssid[0] != '\0' && strcmp(bssid, ESP_EMU_AP_BSSID) != 0)
+        {
+            esp_emu_reply(delay + esp_emu_config.scan_ms * 1000U, "+CWJAP:3\r\n\r\nFAIL\r\n");
+            return;
+        }
+        esp_emu_joined = 1;
+        esp_emu_reply(connected_us, "WIFI CONNECTED\r\n");
+        esp_emu_reply(connected_us + (esp_emu_static_ip ? 0U : esp_emu_config.join_ms * 1000U), "WIFI GOT IP\r\n\r\nOK\r\n");
+    }
+    else if (strcmp(cmd, "AT+CWQAP") == 0)
+    {
+        esp_emu_reply(delay, "\r\nOK\r\n");
+        if (esp_emu_joined)
+        {
+            esp_emu_close_all(0);
+            esp_emu_joined = 0;
+            esp_emu_reply(0, "WIFI DISCONNECT\r\n");
+        }
+    }
+    else if (strcmp(cmd, "AT+CIFSR") == 0)
+    {
+        esp_emu_reply(delay, "+CIFSR:STAIP,\"%s\"\r\n+CIFSR:STAMAC,\"5c:cf:7f:00:00:01\"\r\n\r\nOK\r\n",
+                      esp_emu_joined ? esp_emu_ip : "0.0.0.0");
+    }
+    else if (strncmp(cmd, "AT+CIPSTA=", 10) == 0)
+    {
+        // The address is kept like the firmware keeps it in flash; DHCP stays off from here on.
+        if (sscanf(cmd + 10, "\"%15[^\"]\"", esp_emu_ip) != 1)
+        {
+            esp_emu_reply(delay, "\r\nERROR\r\n");
+            return;
+        }
+        esp_emu_static_ip = 1;
+        esp_emu_reply(delay, "\r\nOK\r\n");
+    }
+    else if (strncmp(cmd, "AT+CIPMUX=", 10) == 0)
+    {
+        esp_emu_mux = (uint8_t)(cmd[10] == '1');
+        esp_emu_reply(delay, "\r\nOK\r\n");
+    }
+    else if (strncmp(cmd, "AT+CIPMODE=", 11) == 0)
+    {
+        esp_emu_cipmode = (uint8_t)(cmd[11] == '1');
+        esp_emu_reply(delay, "\r\nOK\r\n");
+    }
+    else if (strncmp(cmd, "AT+CIPDOMAIN=", 13) == 0)
+    {
+        // Every link ends up on 127.0.0.1, so that is what every name resolves to.
+        if (esp_emu_joined)
+        {
+            esp_emu_reply(delay, "+CIPDOMAIN:127.0.0.1\r\n\r\nOK\r\n");
+        }
+        else
+        {
+            esp_emu_reply(delay, "DNS Fail\r\n\r\nERROR\r\n");
+        }
+    }
+    else if (strncmp(cmd, "AT+CIPSTART=", 12) == 0)
+    {
+        esp_emu_cipstart(cmd + 12, delay);
+    }
+    else if (strcmp(cmd, "AT+CIPSEND") == 0)
+    {
+        if (!esp_emu_cipmode || esp_emu_mux || esp_emu_links[0].fd < 0)
+        {
+            esp_emu_reply(delay, "\r\nERROR\r\n");
+            return;
+        }
+        esp_emu_passthrough = 1;
+        esp_emu_reply(delay, "\r\nOK\r\n\r\n>");
+    }
+    else if (strncmp(cmd, "AT+CIPSEND=", 11) == 0)
+    {
+        esp_emu_cipsend(cmd + 11, delay);
+    }
+    else if (strncmp(cmd, "AT+CIPCLOSE", 11) == 0)
+    {
+        esp_emu_cipclose(cmd + 11, delay);
+    }
+    else if (strncmp(cmd, "AT+UART_CUR=", 12) == 0)
+    {
+        esp_emu_uart_cur(cmd + 12, delay);
+    }
+    else
+    {
+        // AT, AT+CWMODE and the rest of the setup commands.
+        esp_emu_reply(delay, "\r\nOK\r\n");
+    }
+}
+
+// "TCP","192.168.1.10",80 or, with AT+CIPMUX=1, 0,"TCP","192.168.1.10",80. The address is ignored:
+// the link goes to 127.0.0.1 on the requested port, or on forward_port when one is configured.
+static void esp_emu_cipstart(const char *args, uint32_t delay_us)
+{
+    uint8_t id = esp_emu_parse_link(&args);
+    char type[8];
+    char host[64];
+    unsigned int port;
+    if (id >= ESP_EMU_LINKS || sscanf(args, "\"%7[^\"]\",\"%63[^\"]\",%u", type, host, &port) != 3 || port == 0 || port > 65535U)
+    {
+        esp_emu_reply(delay_us, "\r\nERROR\r\n");
+        return;
+    }
+    if (!esp_emu_joined)
+    {
+        esp_emu_reply(delay_us, "no ip\r\n\r\nERROR\r\n");
+        return;
+    }
+    if (esp_emu_links[id].fd >= 0)
+    {
+        esp_emu_reply(delay_us, "ALREADY CONNECTED\r\n\r\nERROR\r\n");
+        return;
+    }
+
+    uint8_t udp = (uint8_t)(strcmp(type, "UDP") == 0);
+    int fd = -1;
+    if (esp_emu_inject(esp_emu_config.error_percent))
+    {
+        esp_emu_stats.injected_errors++;
+    }
+    else
+    {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)(esp_emu_config.forward_port ? esp_emu_config.forward_port : port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0)
+        {
+            close(fd);
+            fd = -1;
+            esp_emu_stats.refused++;
+        }
+    }
+    if (fd < 0)
+    {
+        esp_emu_reply(delay_us, "\r\nERROR\r\nCLOSED\r\n");
+        return;
+    }
+
+    int one = 1;
+    if (!udp)
+    {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // The module sends each CIPSEND as one segment.
+    }
+    esp_emu_links[id].fd = fd;
+    esp_emu_links[id].udp = udp;
+    esp_emu_stats.connects++;
+    if (esp_emu_mux)
+    {
+        esp_emu_reply(delay_us, "%u,CONNECT\r\n\r\nOK\r\n", id);
+    }
+    else
+    {
+        esp_emu_reply(delay_us, "CONNECT\r\n\r\nOK\r\n");
+    }
+}
+
+static void esp_emu_cipsend(const char *args, uint32_t delay_us)
+{
+    uint8_t id = esp_emu_parse_link(&args);
+    unsigned int length = (unsigned int)strtoul(args, NULL, 10);
+    if (id >= ESP_EMU_LINKS || esp_emu_links[id].fd < 0)
+    {
+        esp_emu_reply(delay_us, "link is not valid\r\n\r\nERROR\r\n");
+        return;
+    }
+    if (length == 0 || length > ESP_EMU_SEND_LEN)
+    {
+        esp_emu_reply(delay_us, "\r\nERROR\r\n");
+        return;
+    }
+    if (esp_emu_inject(esp_emu_config.error_percent))
+    {
+        esp_emu_stats.injected_errors++;
+        esp_emu_reply(delay_us, "\r\nERROR\r\n");
+        return;
+    }
+
+    esp_emu_send_link = id;
+    esp_emu_send_len = (uint16_t)length;
+    esp_emu_send_received = 0;
+    esp_emu_reply(delay_us, "\r\nOK\r\n> ");
+}
+
+static void esp_emu_send_done(void)
+{
+    uint8_t id = esp_emu_send_link;
+    uint16_t length = esp_emu_send_len;
+    esp_emu_send_len = 0;
+
+    uint32_t delay = esp_emu_delay();
+    esp_emu_reply(delay, "\r\nRecv %u bytes\r\n", length);
+    if (esp_emu_links[id].fd >= 0 && send(esp_emu_links[id].fd, esp_emu_send_buf, length, MSG_NOSIGNAL) == (ssize_t)length)
+    {
+        esp_emu_stats.bytes_up += length;
+        esp_emu_reply(0, "\r\nSEND OK\r\n");
+    }
+    else
+    {
+        esp_emu_reply(0, "\r\nSEND FAIL\r\n");
+    }
+}
+
+static void esp_emu_cipclose(const char *args, uint32_t delay_us)
+{
+    uint8_t id = 0;
+    if (args[0] == '=')
+    {
+        id = (uint8_t)atoi(args + 1);
+    }
+    if (esp_emu_mux && id == ESP_EMU_LINKS) // AT+CIPCLOSE=5 closes every link.
+    {
+        esp_emu_close_all(delay_us);
+        esp_emu_reply(0, "\r\nOK\r\n");
+        return;
+    }
+    if (id >= ESP_EMU_LINKS || esp_emu_links[id].fd < 0)
+    {
+        esp_emu_reply(delay_us, "\r\nERROR\r\n");
+        return;
+    }
+
+    esp_emu_close(id);
+    if (esp_emu_mux)
+    {
+        esp_emu_reply(delay_us, "%u,CLOSED\r\n\r\nOK\r\n", id);
+    }
+    else
+    {
+        esp_emu_reply(delay_us, "CLOSED\r\n\r\nOK\r\n");
+    }
+}
+
+// <baud>,8,1,0,0. The OK still goes out at the old rate; everything after it uses the new one.
+static void esp_emu_uart_cur(const char *args, uint32_t delay_us)
+{
+    unsigned long baud = strtoul(args, NULL, 10);
+    if (baud < 80 || baud > 5000000UL)
+    {
+        esp_emu_reply(delay_us, "\r\nERROR\r\n");
+        return;
+    }
+    esp_emu_reply(delay_us, "\r\nOK\r\n");
+    esp_emu_baud = (uint32_t)baud;
+    esp_emu_stats.baud_changes++;
+}
+
+// Forward what the server sent as +IPD frames (or raw bytes in passthrough), and report links the
+// server closed. Server data waits in the socket while the reply queue is nearly full.
+static void esp_emu_poll_links(void)
+{
+    static uint8_t frame[ESP_EMU_SEGMENT_LEN];
+    for (uint8_t id = 0; id < ESP_EMU_LINKS; id++)
+    {
+        if (esp_emu_links[id].fd < 0)
+        {
+            continue;
+        }
+        if (esp_emu_count > ESP_EMU_QUEUE_LEN - ESP_EMU_QUEUE_SPARE)
+        {
+            return;
+        }
+
+        uint8_t *payload = &frame[32];
+        ssize_t count = recv(esp_emu_links[id].fd, payload, ESP_EMU_IPD_LEN, MSG_DONTWAIT);
+        if (count > 0)
+        {
+            esp_emu_stats.bytes_down += (uint64_t)count;
+            int header = 0;
+            if (!esp_emu_passthrough)
+            {
+                char text[32];
+                header = esp_emu_mux ? snprintf(text, sizeof(text), "\r\n+IPD,%u,%d:", id, (int)count)
+                                     : snprintf(text, sizeof(text), "\r\n+IPD,%d:", (int)count);
+                memcpy(payload - header, text, (size_t)header);
+            }
+            esp_emu_queue_bytes(payload - header, (uint16_t)(count + header), esp_emu_delay());
+        }
+        else if ((count == 0 && !esp_emu_links[id].udp) || (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            esp_emu_close(id);
+            if (esp_emu_mux)
+            {
+                esp_emu_reply(esp_emu_delay(), "%u,CLOSED\r\n", id);
+            }
+            else
+            {
+                esp_emu_reply(esp_emu_delay(), "CLOSED\r\n");
+            }
+        }
+    }
+}
+
+// Runs from HAL_GetTick()/HAL_Delay(): move reply bytes that have crossed the wire into the driver's
+// receive buffer. The line goes idle after each reply piece, and every fragment_len bytes if set.
+static void esp_emu_service(void *context)
+{
+    (void)context;
+    esp_emu_poll_links();
+
+    uint64_t now = Fake_HAL_Micros();
+    while (esp_emu_count > 0)
+    {
+        esp_emu_segment_t *segment = &esp_emu_queue[esp_emu_head];
+        if (now < segment->due_us)
+        {
+            return;
+        }
+
+        uint64_t on_wire = (now - segment->due_us) * segment->baud / 10000000U;
+        uint16_t arrived = (on_wire >= segment->length) ? segment->length : (uint16_t)on_wire;
+        uint16_t ready = (uint16_t)(arrived - segment->sent);
+        if (esp_emu_config.fragment_len != 0 && ready > esp_emu_config.fragment_len - segment->sent % esp_emu_config.fragment_len)
+        {
+            ready = (uint16_t)(esp_emu_config.fragment_len - segment->sent % esp_emu_config.fragment_len);
+        }
+
+        // Received at the wrong rate, or too fast for the line, every byte is a framing error.
+        const uint8_t *data = &segment->data[segment->sent];
+        uint8_t noise[ESP_EMU_SEGMENT_LEN];
+        if (segment->baud != esp_emu_uart->Init.BaudRate || (esp_emu_config.max_baud != 0 && segment->baud > esp_emu_config.max_baud))
+        {
+            memset(noise, 0xF8, ready);
+            data = noise;
+        }
+        uint16_t accepted = Fake_UART_Receive(data, ready);
+        esp_emu_stats.garbled += (data == noise) ? accepted : 0U;
+        segment->sent = (uint16_t)(segment->sent + accepted);
+        if (accepted < ready)
+        {
+            return; // Reception is not armed; keep the bytes.
+        }
+        if (ready > 0 && (segment->sent == segment->length ||
+                          (esp_emu_config.fragment_len != 0 && segment->sent % esp_emu_config.fragment_len == 0)))
+        {
+            Fake_UART_Idle();
+        }
+        if (segment->sent < segment->length)
+        {
+            return; // The rest is still on the wire.
+        }
+        esp_emu_head = (uint8_t)((esp_emu_head + 1U) % ESP_EMU_QUEUE_LEN);
+        esp_emu_count--;
+    }
+}
+
+static void esp_emu_close(uint8_t id)
+{
+    close(esp_emu_links[id].fd);
+    esp_emu_links[id].fd = -1;
+    if (id == 0)
+    {
+        esp_emu_passthrough = 0;
+    }
+}
+
+static void esp_emu_close_all(uint32_t delay_us)
+{
+    for (uint8_t id = 0; id < ESP_EMU_LINKS; id++)
+    {
+        if (esp_emu_links[id].fd >= 0)
+        {
+            esp_emu_close(id);
+            if (esp_emu_mux)
+            {
+                esp_emu_reply(delay_us, "%u,CLOSED\r\n", id);
+            }
+            else
+            {
+                esp_emu_reply(delay_us, "CLOSED\r\n");
+            }
+            delay_us = 0;
+        }
+    }
+}
+
+// With AT+CIPMUX=1 the arguments start with "<id>,"; without it everything uses link 0.
+static uint8_t esp_emu_parse_link(const char **args)
+{
+    if (!esp_emu_mux)
+    {
+        return 0;
+    }
+    const char *text = *args;
+    if (text[0] < '0' || text[0] > '9' || text[1] != ',')
+    {
+        return ESP_EMU_LINKS;
+    }
+    *args = text + 2;
+    return (uint8_t)(text[0] - '0');
+}
+
+// Queue bytes for the driver. The first byte leaves delay_us after the driver's last byte has
+// arrived, or when the wire is free.
+static void esp_emu_queue_bytes(const uint8_t *data, uint16_t length, uint32_t delay_us)
+{
+    uint64_t now = Fake_HAL_Micros();
+    uint64_t due = ((now > esp_emu_rx_end_us) ? now : esp_emu_rx_end_us) + delay_us;
+    if (due < esp_emu_wire_free_us)
+    {
+        due = esp_emu_wire_free_us;
+    }
+
+    while (length > 0)
+    {
+        if (esp_emu_count == ESP_EMU_QUEUE_LEN)
+        {
+            fprintf(stderr, "esp: reply queue full, %u bytes dropped\n", length);
+            return;
+        }
+        esp_emu_segment_t *segment = &esp_emu_queue[(esp_emu_head + esp_emu_count) % ESP_EMU_QUEUE_LEN];
+        uint16_t count = (length < ESP_EMU_SEGMENT_LEN) ? length : ESP_EMU_SEGMENT_LEN;
+        memcpy(segment->data, data, count);
+        segment->length = count;
+        segment->sent = 0;
+        segment->due_us = due;
+        segment->baud = esp_emu_baud;
+        esp_emu_count++;
+
+        due += (uint64_t)count * 10000000U / esp_emu_baud;
+        data += count;
+        length = (uint16_t)(length - count);
+    }
+    esp_emu_wire_free_us = due;
+}
+
+static void esp_emu_reply(uint32_t delay_us, const char *format, ...)
+{
+    char text[160];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length > 0 && esp_emu_config.verbose)
+    {
+        esp_emu_trace(text);
+    }
+    if (length > 0)
+    {
+        esp_emu_queue_bytes((const uint8_t *)text, (uint16_t)((length < (int)sizeof(text)) ? length : (int)sizeof(text) - 1), delay_us);
+    }
+}
+
+// Replies are printed on one line, with '|' where the module sends CR LF.
+static void esp_emu_trace(const char *text)
+{
+    fprintf(stderr, "%10.3f esp >", (double)Fake_HAL_Micros() / 1000.0);
+    for (; *text != '\0'; text++)
+    {
+        if (*text == '\n')
+        {
+            fputs(" |", stderr);
+        }
+        else if (*text != '\r')
+        {
+            fputc(*text, stderr);
+        }
+    }
+    fputc('\n', stderr);
+}
+
+static uint32_t esp_emu_random(void)
+{
+    esp_emu_seed ^= esp_emu_seed << 13;
+    esp_emu_seed ^= esp_emu_seed >> 17;
+    esp_emu_seed ^= esp_emu_seed << 5;
+    return esp_emu_seed;
+}
+
+static uint32_t esp_emu_delay(void)
+{
+    uint32_t jitter = esp_emu_config.jitter_us ? esp_emu_random() % (esp_emu_config.jitter_us + 1U) : 0U;
+    return esp_emu_config.latency_us + jitter;
+}
+
+static uint8_t esp_emu_inject(uint8_t percent)
+{
+    return (uint8_t)(percent != 0 && esp_emu_random() % 100U < percent);
+}
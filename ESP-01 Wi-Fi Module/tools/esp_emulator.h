@@ -0,0 +1,57 @@
+#ifndef ESP_EMULATOR_H
+#define ESP_EMULATOR_H
+
+#include "main.h"
+#include <stdint.h>
+
+// An ESP8266 running the AT firmware, played by the host. It sits on the far side of the fake UART
+// (host/fake_hal.c) and answers the subset of commands the drivers send:
+// AT, ATE0/ATE1, AT+RST, AT+CWMODE, AT+CWJAP (set, with or without a BSSID, and query), AT+CWQAP,
+// AT+CIFSR, AT+CIPSTA, AT+CIPMUX, AT+CIPMODE, AT+CIPSTART (TCP and UDP), AT+CIPSEND (length and
+// passthrough), AT+CIPCLOSE, AT+CIPDOMAIN and AT+UART_CUR. Anything else is acknowledged with OK.
+// Every link is forwarded to a real socket on 127.0.0.1, and whatever the server sends comes back
+// as +IPD frames, so the drivers can be measured against a real server without hardware.
+// The module keeps its own baud rate. It starts at the rate the UART handle has when the emulator
+// starts and switches on AT+UART_CUR right after its OK has gone out. While the two ends disagree,
+// the module ignores what it receives and its replies reach the driver as noise.
+
+#define ESP_EMU_LINKS 5          // Link IDs 0..4, as with AT+CIPMUX=1.
+#define ESP_EMU_IPD_LEN 1460     // Largest +IPD payload, one TCP segment.
+
+typedef struct
+{
+    uint32_t latency_us;     // Module processing time before each reply or +IPD frame starts.
+    uint32_t jitter_us;      // Random extra delay, 0..jitter_us.
+    uint16_t fragment_len;   // The line goes idle every fragment_len bytes, splitting replies into more RX events.
+    uint8_t error_percent;   // Chance that AT+CIPSTART or AT+CIPSEND answers ERROR.
+    uint8_t busy_percent;    // Chance that any command is refused with "busy p...".
+    uint16_t forward_port;   // Port every link connects to; 0 keeps the port the driver asked for.
+    uint32_t scan_ms;        // Channel scan before WIFI CONNECTED when AT+CWJAP names no BSSID. 0 by default.
+    uint32_t join_ms;        // DHCP: time between WIFI CONNECTED and WIFI GOT IP. Skipped after AT+CIPSTA.
+    uint32_t max_baud;       // Fastest rate the line carries; replies sent faster arrive as noise. 0 for no limit.
+    uint32_t seed;           // Seed for jitter and error injection, so runs can be repeated.
+    uint8_t verbose;         // Print the AT traffic to stderr.
+} esp_emulator_config_t;
+
+typedef struct
+{
+    uint32_t commands;
+    uint32_t injected_errors;
+    uint32_t injected_busy;
+    uint32_t connects;       // Links opened to the server.
+    uint32_t refused;        // Links the server refused.
+    uint32_t baud_changes;   // AT+UART_CUR commands the module acted on.
+    uint32_t garbled;        // Bytes that crossed the wire unreadable: mismatched rates or above max_baud.
+    uint64_t bytes_up;       // Payload bytes forwarded to the server.
+    uint64_t bytes_down;     // Payload bytes delivered as +IPD.
+} esp_emulator_stats_t;
+
+void ESP_Emulator_DefaultConfig(esp_emulator_config_t *config);
+// Attach the emulator to the fake UART. huart is the handle given to WiFi_Init(); its Init.BaudRate
+// is the module's starting rate.
+void ESP_Emulator_Start(const esp_emulator_config_t *config, UART_HandleTypeDef *huart);
+void ESP_Emulator_GetStats(esp_emulator_stats_t *stats);
+// Drop the Wi-Fi association ("WIFI DISCONNECT") and close every link, as when the AP goes away.
+void ESP_Emulator_DropAP(void);
+
+#endif
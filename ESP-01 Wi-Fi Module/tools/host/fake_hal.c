@@ -0,0 +1,200 @@
+// Fake HAL for running the drivers as a Linux process: a real millisecond tick, one UART whose
+// transmitter hands bytes to a peer (the ESP emulator), and ReceiveToIdle in both the IT and the
+// circular DMA flavour. Callbacks run from HAL_GetTick()/HAL_Delay(), which every driver wait
+// loop calls, so they interrupt the driver at the same points a real IRQ could.
+
+#define _POSIX_C_SOURCE 200809L
+#include "main.h"
+#include <string.h>
+#include <time.h>
+
+static fake_uart_peer_t fake_peer;
+static UART_HandleTypeDef *fake_uart;
+static uint8_t *fake_rx_buf;
+static uint16_t fake_rx_len;
+static uint16_t fake_rx_count;     // IT: bytes received since the buffer was armed.
+static uint16_t fake_rx_pos;       // DMA: write position inside fake_rx_buf.
+static uint16_t fake_rx_reported;  // DMA: position passed with the last event.
+static uint8_t fake_rx_dma;
+static uint8_t fake_tx_pending;
+static uint64_t fake_tx_done_us;   // When the last transmitted byte leaves the wire.
+static uint8_t fake_in_service;    // Callbacks must not nest, just like one interrupt priority.
+
+static void fake_rx_it_event(void);
+static void fake_service(void);
+static void fake_tx_check(void);
+
+uint64_t Fake_HAL_Micros(void)
+{
+    static uint64_t start;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t us = (uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U;
+    if (start == 0)
+    {
+        start = us;
+    }
+    return us - start;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    fake_service();
+    return (uint32_t)(Fake_HAL_Micros() / 1000U);
+}
+
+void HAL_Delay(uint32_t delay)
+{
+    uint64_t end = Fake_HAL_Micros() + (uint64_t)delay * 1000U;
+    while (Fake_HAL_Micros() < end)
+    {
+        fake_service();
+        struct timespec pause = {0, 50000};
+        nanosleep(&pause, NULL);
+    }
+}
+
+void Fake_UART_Attach(const fake_uart_peer_t *peer)
+{
+    fake_peer = *peer;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    huart->RxState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart)
+{
+    huart->RxState = HAL_UART_STATE_READY;
+    fake_rx_buf = NULL;
+    fake_tx_pending = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size)
+{
+    if (fake_tx_pending)
+    {
+        return HAL_BUSY;
+    }
+
+    // Ten bits per byte at the configured baud rate; TxCplt fires once they have all gone out.
+    uint32_t baud = huart->Init.BaudRate ? huart->Init.BaudRate : 115200U;
+    fake_uart = huart;
+    fake_tx_pending = 1;
+    fake_tx_done_us = Fake_HAL_Micros() + (uint64_t)size * 10000000U / baud;
+    if (fake_peer.on_tx != NULL)
+    {
+        fake_peer.on_tx(data, size, fake_peer.context);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size)
+{
+    return HAL_UART_Transmit_IT(huart, data, size);
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size)
+{
+    fake_uart = huart;
+    fake_rx_buf = data;
+    fake_rx_len = size;
+    fake_rx_count = 0;
+    fake_rx_dma = 0;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size)
+{
+    HAL_UARTEx_ReceiveToIdle_IT(huart, data, size);
+    fake_rx_dma = 1;
+    fake_rx_pos = 0;
+    fake_rx_reported = 0;
+    return HAL_OK;
+}
+
+uint16_t Fake_UART_Receive(const uint8_t *data, uint16_t length)
+{
+    uint16_t accepted = 0;
+    while (accepted < length && fake_rx_buf != NULL)
+    {
+        if (!fake_rx_dma)
+        {
+            fake_rx_buf[fake_rx_count++] = data[accepted++];
+            if (fake_rx_count == fake_rx_len)
+            {
+                fake_rx_it_event(); // A full buffer ends the reception like IDLE does.
+            }
+            continue;
+        }
+
+        fake_rx_buf[fake_rx_pos++] = data[accepted++];
+        if (fake_rx_pos == fake_rx_len / 2U || fake_rx_pos == fake_rx_len) // Half-transfer and transfer-complete.
+        {
+            uint16_t position = fake_rx_pos;
+            fake_rx_reported = (position == fake_rx_len) ? 0U : position;
+            fake_rx_pos = fake_rx_reported;
+            HAL_UARTEx_RxEventCallback(fake_uart, position);
+        }
+    }
+    return accepted;
+}
+
+void Fake_UART_Idle(void)
+{
+    if (fake_rx_buf == NULL)
+    {
+        return;
+    }
+    if (!fake_rx_dma && fake_rx_count > 0)
+    {
+        fake_rx_it_event();
+    }
+    else if (fake_rx_dma && fake_rx_pos != fake_rx_reported)
+    {
+        fake_rx_reported = fake_rx_pos;
+        HAL_UARTEx_RxEventCallback(fake_uart, fake_rx_pos);
+    }
+}
+
+// ReceiveToIdle_IT stops after each event; the driver re-arms from the callback.
+static void fake_rx_it_event(void)
+{
+    uint16_t size = fake_rx_count;
+    fake_rx_buf = NULL;
+    fake_rx_count = 0;
+    fake_uart->RxState = HAL_UART_STATE_READY;
+    HAL_UARTEx_RxEventCallback(fake_uart, size);
+}
+
+static void fake_service(void)
+{
+    if (fake_in_service)
+    {
+        return;
+    }
+
+    fake_in_service = 1;
+    fake_tx_check();
+    if (fake_peer.service != NULL)
+    {
+        fake_peer.service(fake_peer.context);
+    }
+    // The peer may have run for a while (or the process was descheduled). On the MCU the TC
+    // interrupt would have fired on time, before any reply to those bytes could be parsed.
+    fake_tx_check();
+    fake_in_service = 0;
+}
+
+static void fake_tx_check(void)
+{
+    if (fake_tx_pending && Fake_HAL_Micros() >= fake_tx_done_us)
+    {
+        fake_tx_pending = 0;
+        HAL_UART_TxCpltCallback(fake_uart);
+    }
+}
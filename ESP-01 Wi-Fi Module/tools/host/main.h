@@ -0,0 +1,99 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+// Stand-in for the CubeMX main.h when the drivers are built on a PC (see ../esp_emulator.h).
+// Only the part of the HAL the drivers use is declared; fake_hal.c implements it for one UART.
+// The I2C, ADC and TIM handles are just enough for the sensor driver headers to compile.
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+#define HAL_UART_STATE_READY 0x20U
+#define HAL_UART_STATE_BUSY_RX 0x22U
+
+typedef struct
+{
+    uint32_t BaudRate;
+} UART_InitTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    UART_InitTypeDef Init;
+    volatile uint32_t RxState;
+} UART_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} I2C_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} ADC_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+    uint32_t Channel;
+} TIM_HandleTypeDef;
+
+// Milliseconds since the process started. Every call also runs the fake peripherals, the way
+// interrupts would preempt the driver's wait loops on a real MCU.
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+// A process has no interrupts to mask; the fake peripherals only run inside HAL_GetTick()/HAL_Delay().
+static inline uint32_t __get_PRIMASK(void)
+{
+    return 0U;
+}
+
+static inline void __set_PRIMASK(uint32_t primask)
+{
+    (void)primask;
+}
+
+static inline void __disable_irq(void)
+{
+}
+
+// Hooks between the fake UART and whatever plays the module on the other end of the wire.
+typedef struct
+{
+    void (*on_tx)(const uint8_t *data, uint16_t length, void *context); // Bytes the driver transmitted.
+    void (*service)(void *context);                                     // Called from HAL_GetTick()/HAL_Delay().
+    void *context;
+} fake_uart_peer_t;
+
+void Fake_UART_Attach(const fake_uart_peer_t *peer);
+// Bytes that arrived on RX. Events fire when the buffer fills (IT) or at half/full (circular DMA).
+// Returns how many were taken; nothing is taken while reception is not armed.
+uint16_t Fake_UART_Receive(const uint8_t *data, uint16_t length);
+// The line went idle: raise the IDLE event for whatever arrived since the last event.
+void Fake_UART_Idle(void);
+// Microseconds since the process started, for latency measurements and the emulated wire speed.
+uint64_t Fake_HAL_Micros(void);
+
+#endif
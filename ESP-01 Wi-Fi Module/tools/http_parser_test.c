@@ -0,0 +1,118 @@
+// Host-side checks for the streaming HTTP response parser: canned responses go straight into
+// WiFi_HTTP_Response_Feed(), once in one piece and once a byte at a time, the way a slow link
+// splits them into +IPD frames. No module or server is involved. Build from this directory:
+//
+//     SRC="http_parser_test.c host/fake_hal.c ../Drivers/wifi_http_support.c ../Drivers/wifi_basic_driver.c"
+//     gcc -std=c11 -O2 -DWIFI_DEBUG=0 -Ihost -I../Drivers $SRC ../Drivers/wifi_retry.c ../Drivers/uart_dispatch.c -o http_parser_test
+//     ./http_parser_test
+//
+// Each case checks the status code, the decoded body and when the response counts as complete.
+// Each check prints "ok" or "FAIL". The exit status is the number of failures.
+
+#include "wifi_http_support.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_BODY_LEN 256
+
+typedef struct
+{
+    const char *name;
+    const char *response;
+    uint16_t status_code;
+    const char *body;
+    uint8_t until_close;      // The body ends with the connection, so only WiFi_HTTP_Response_Closed() completes it.
+} test_case_t;
+
+static const test_case_t test_cases[] = {
+    {"Content-Length", "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\ncontent-length: 11\r\n\r\nhello world", 200, "hello world", 0},
+    {"Content-Length, bytes after the body", "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nokHTTP/1.1 500", 200, "ok", 0},
+    {"Content-Length: 0", "HTTP/1.1 201 Created\r\nContent-Length: 0\r\n\r\n", 201, "", 0},
+    {"chunked", "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n6;name=x\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\n", 200,
+     "hello world", 0},
+    {"chunked, upper-case hex sizes", "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nA\r\n0123456789\r\n0\r\n\r\n", 200, "0123456789", 0},
+    {"close-delimited", "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\n\r\nuntil the link closes", 200, "until the link closes", 1},
+    {"204 No Content", "HTTP/1.1 204 No Content\r\nDate: Sat, 17 Oct 2026 12:00:00 GMT\r\n\r\n", 204, "", 0},
+    {"304 Not Modified with the length of the cached body", "HTTP/1.1 304 Not Modified\r\nETag: \"7\"\r\nContent-Length: 1234\r\n\r\n", 304, "",
+     0},
+    {"100 Continue, then Content-Length", "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\ndone", 200, "done", 0},
+    {"103 Early Hints with framing headers, then close-delimited",
+     "HTTP/1.1 103 Early Hints\r\nLink: </style.css>; rel=preload\r\nContent-Length: 0\r\nTransfer-Encoding: chunked\r\n\r\n"
+     "HTTP/1.1 200 OK\r\n\r\nuntil close",
+     200, "until close", 1},
+    {"100 Continue, then 404 with a chunked body", "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 404 Not Found\r\nTransfer-Encoding: chunked\r\n\r\n"
+     "9\r\nnot found\r\n0\r\n\r\n", 404, "not found", 0},
+};
+
+typedef struct
+{
+    char data[TEST_BODY_LEN];
+    uint16_t length;
+    uint32_t calls;
+} test_body_t;
+
+static int test_failures;
+
+static void check(int ok, const char *what)
+{
+    printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        test_failures++;
+    }
+}
+
+static void on_body(const uint8_t *data, uint16_t length, void *context)
+{
+    test_body_t *body = (test_body_t *)context;
+    if (body->length + length <= TEST_BODY_LEN)
+    {
+        memcpy(body->data + body->length, data, length);
+    }
+    body->length = (uint16_t)(body->length + length);
+    body->calls++;
+}
+
+static void test_run(const test_case_t *test, uint16_t piece)
+{
+    printf("%s, %s\n", test->name, (piece == 1U) ? "a byte at a time" : "one piece");
+    wifi_http_response_t response;
+    test_body_t body;
+    memset(&body, 0, sizeof(body));
+    WiFi_HTTP_Response_Init(&response, on_body, &body);
+    check(response.status_code == 0U && response.content_length == -1 && !WiFi_HTTP_Response_IsComplete(&response), "fresh parser");
+
+    const uint8_t *data = (const uint8_t *)test->response;
+    uint16_t length = (uint16_t)strlen(test->response);
+    for (uint16_t offset = 0; offset < length; offset = (uint16_t)(offset + piece))
+    {
+        WiFi_HTTP_Response_Feed(&response, data + offset, (length - offset < piece) ? (uint16_t)(length - offset) : piece);
+    }
+
+    if (test->until_close)
+    {
+        check(!WiFi_HTTP_Response_IsComplete(&response), "not complete while the link is open");
+        WiFi_HTTP_Response_Closed(&response);
+    }
+    check(WiFi_HTTP_Response_IsComplete(&response), "complete");
+
+    char what[64];
+    snprintf(what, sizeof(what), "status %u", test->status_code);
+    check(response.status_code == test->status_code, what);
+
+    uint16_t expected = (uint16_t)strlen(test->body);
+    snprintf(what, sizeof(what), "body \"%s\" (%u bytes)", test->body, expected);
+    check(body.length == expected && response.body_received == expected && memcmp(body.data, test->body, expected) == 0, what);
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(test_cases) / sizeof(test_cases[0]); i++)
+    {
+        test_run(&test_cases[i], 0xFFFFU);
+        test_run(&test_cases[i], 1U);
+    }
+
+    printf("%d failure%s\n", test_failures, (test_failures == 1) ? "" : "s");
+    return test_failures;
+}
@@ -0,0 +1,297 @@
+// Host benchmark for the offline journal: records are appended to a journal in a file
+// (wifi_journal_file.c), the last append is torn as by a power loss, and the journal is reopened
+// and replayed through the emulated module in esp_emulator.c to a built-in HTTP server on
+// 127.0.0.1. Build from this directory:
+//
+//     SRC="journal_bench.c esp_emulator.c host/fake_hal.c ../Drivers/wifi_basic_driver.c ../Drivers/wifi_http_support.c"
+//     DRV="../Drivers/wifi_journal.c ../Drivers/wifi_journal_file.c ../Drivers/wifi_retry.c ../Drivers/uart_dispatch.c"
+//     gcc -std=c11 -O2 -DWIFI_DEBUG=0 -Ihost -I../Drivers $SRC $DRV -lpthread -o journal_bench
+//     ./journal_bench -n 2000 -b 115200 -B 4096
+//
+// Options:
+//     -n count     records to append; the last one is torn (default 2000)
+//     -b baud      UART rate; the wire time of every byte is modelled (default 115200)
+//     -B bytes     replay body size, config.batch_bytes (default 4096)
+//     -l us        module latency before each reply (default 2000)
+//     -f path      journal file (default /tmp/journal_bench.bin, recreated on every run)
+//
+// The server checks that the records arrive once each and in order. The replay rate is printed
+// next to the rate the UART could carry if it sent nothing but the JSON body.
+
+#define _POSIX_C_SOURCE 200809L
+#include "esp_emulator.h"
+#include "wifi_basic_driver.h"
+#include "wifi_journal.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define BENCH_SEGMENT_SIZE (16U * 1024U)
+#define BENCH_SEGMENT_COUNT 16U
+#define BENCH_REQUEST_LEN (16U * 1024U)
+
+static wifi_handle_t bench_wifi;
+static wifi_journal_flash_t bench_file_flash;
+static uint8_t bench_tear;                   // Tear the next record header that is programmed.
+static volatile uint32_t bench_received;     // Records the server got.
+static volatile uint32_t bench_out_of_order; // Records whose sequence number did not follow the previous one.
+static volatile uint64_t bench_body_bytes;
+
+static void *bench_server_main(void *arg);
+static void *bench_server_connection(void *arg);
+static uint16_t bench_server_start(void);
+static void bench_server_count(const char *body, size_t length);
+
+// Pass-through to the file backend, except that the torn write stores only the first word of a
+// record header: length and reserved land, timestamp and CRC stay erased.
+static wifi_status_t bench_tear_program(uint32_t address, const void *data, uint32_t length, void *context)
+{
+    (void)context;
+    if (bench_tear && length == sizeof(wifi_journal_record_t) - 4U)
+    {
+        bench_tear = 0;
+        length = 4U;
+    }
+    return bench_file_flash.program(address, data, length, bench_file_flash.context);
+}
+
+static wifi_status_t bench_tear_read(uint32_t address, void *data, uint32_t length, void *context)
+{
+    (void)context;
+    return bench_file_flash.read(address, data, length, bench_file_flash.context);
+}
+
+static wifi_status_t bench_tear_erase(uint16_t segment, void *context)
+{
+    (void)context;
+    return bench_file_flash.erase(segment, bench_file_flash.context);
+}
+
+int main(int argc, char **argv)
+{
+    esp_emulator_config_t config;
+    ESP_Emulator_DefaultConfig(&config);
+    uint32_t count = 2000;
+    uint32_t baud = 115200;
+    uint32_t batch_bytes = WIFI_JOURNAL_BATCH_BYTES;
+    const char *path = "/tmp/journal_bench.bin";
+    int option;
+    while ((option = getopt(argc, argv, "n:b:B:l:f:")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': count = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'b': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'B': batch_bytes = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'l': config.latency_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'f': path = optarg; break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-b baud] [-B bytes] [-l us] [-f path]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (count < 2)
+    {
+        count = 2;
+    }
+    if (batch_bytes > BENCH_REQUEST_LEN / 2U)
+    {
+        batch_bytes = BENCH_REQUEST_LEN / 2U;
+    }
+
+    uint16_t port = bench_server_start();
+    static UART_HandleTypeDef huart;
+    huart.Init.BaudRate = baud;
+    ESP_Emulator_Start(&config, &huart);
+    if (port == 0 || WiFi_Init(&bench_wifi, &huart) != WIFI_OK || WiFi_Connect(&bench_wifi, "bench", "benchmark") != WIFI_OK)
+    {
+        fprintf(stderr, "the driver did not come up against the emulator\n");
+        return 1;
+    }
+
+    // Fill the journal through the tearing wrapper, then "lose power" during the last append.
+    unlink(path);
+    static wifi_journal_file_t file;
+    static wifi_journal_t journal;
+    wifi_journal_config_t journal_config = {&bench_wifi, "127.0.0.1", port, "/journal", batch_bytes, 5000, 1};
+    if (WiFi_Journal_File_Open(&bench_file_flash, &file, path, BENCH_SEGMENT_SIZE, BENCH_SEGMENT_COUNT) != WIFI_OK)
+    {
+        fprintf(stderr, "cannot map %s\n", path);
+        return 1;
+    }
+    wifi_journal_flash_t tear_flash = bench_file_flash;
+    tear_flash.read = bench_tear_read;
+    tear_flash.program = bench_tear_program;
+    tear_flash.erase = bench_tear_erase;
+    WiFi_Journal_Open(&journal, &tear_flash, &journal_config);
+
+    uint64_t start = Fake_HAL_Micros();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        char payload[WIFI_JOURNAL_PAYLOAD_LEN];
+        snprintf(payload, sizeof(payload), "{\"seq\":%u,\"t_c\":21.37,\"rh\":45.12,\"p\":101325.4}", (unsigned int)i);
+        bench_tear = (uint8_t)(i == count - 1U);
+        WiFi_Journal_Append(&journal, i, payload);
+    }
+    double append_s = (double)(Fake_HAL_Micros() - start) / 1e6;
+    WiFi_Journal_File_Close(&file);
+
+    // Reset: map the file again and let the journal recover.
+    if (WiFi_Journal_File_Open(&bench_file_flash, &file, path, BENCH_SEGMENT_SIZE, BENCH_SEGMENT_COUNT) != WIFI_OK)
+    {
+        fprintf(stderr, "cannot map %s\n", path);
+        return 1;
+    }
+    start = Fake_HAL_Micros();
+    wifi_status_t status = WiFi_Journal_Open(&journal, &bench_file_flash, &journal_config);
+    double open_ms = (double)(Fake_HAL_Micros() - start) / 1000.0;
+    wifi_journal_stats_t stats;
+    WiFi_Journal_GetStats(&journal, &stats);
+    uint32_t pending = WiFi_Journal_Pending(&journal);
+    printf("%u records appended in %.1f ms, the last one torn\n", count, append_s * 1000.0);
+    printf("reopen: %s in %.1f ms, %u pending, %u torn record%s found\n", WiFi_StatusToString(status), open_ms, pending, stats.corrupt,
+           (stats.corrupt == 1U) ? "" : "s");
+
+    wifi_transport_stats_t before;
+    wifi_transport_stats_t after;
+    WiFi_GetTransportStats(&bench_wifi, &before);
+    start = Fake_HAL_Micros();
+    while (WiFi_Journal_Pending(&journal) > 0 && WiFi_Journal_Poll(&journal) == WIFI_OK)
+    {
+    }
+    double replay_s = (double)(Fake_HAL_Micros() - start) / 1e6;
+    WiFi_GetTransportStats(&bench_wifi, &after);
+    WiFi_Journal_GetStats(&journal, &stats);
+    HAL_Delay(20); // Let the server finish counting.
+
+    double line_bytes_s = (double)baud / 10.0;
+    double body_per_record = (bench_received > 0) ? (double)bench_body_bytes / bench_received : 0.0;
+    double records_s = (double)stats.replayed / replay_s;
+    printf("replay:  %u records in %u batches of up to %u bytes, %.1f s\n", stats.replayed, stats.batches, batch_bytes, replay_s);
+    printf("server:  %u records, %u out of order, %.1f body bytes per record\n", bench_received, bench_out_of_order, body_per_record);
+    printf("rate:    %.0f records/s, %.0f body bytes/s\n", records_s, records_s * body_per_record);
+    printf("line:    %u baud carries %.0f bytes/s, %.0f records/s of body alone: replay at %.0f %%\n", baud, line_bytes_s,
+           line_bytes_s / body_per_record, 100.0 * records_s * body_per_record / line_bytes_s);
+    printf("uart:    %.0f %% of the transmit time busy, %.0f bytes/s sent\n",
+           100.0 * (double)(after.tx_bytes - before.tx_bytes) / replay_s / line_bytes_s, (double)(after.tx_bytes - before.tx_bytes) / replay_s);
+
+    WiFi_Journal_File_Close(&file);
+    uint8_t ok = (uint8_t)(stats.corrupt == 1U && pending == count - 1U && bench_received == count - 1U && bench_out_of_order == 0U);
+    if (!ok)
+    {
+        printf("MISMATCH: expected %u records delivered in order and one torn record\n", count - 1U);
+    }
+    return ok ? 0 : 1;
+}
+
+static uint16_t bench_server_start(void)
+{
+    static int listener;
+    struct sockaddr_in address;
+    socklen_t address_len = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 8) != 0 ||
+        getsockname(listener, (struct sockaddr *)&address, &address_len) != 0)
+    {
+        perror("server");
+        return 0;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, bench_server_main, &listener) != 0)
+    {
+        return 0;
+    }
+    pthread_detach(thread);
+    return ntohs(address.sin_port);
+}
+
+static void *bench_server_main(void *arg)
+{
+    int listener = *(int *)arg;
+    for (;;)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0)
+        {
+            continue;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, bench_server_connection, (void *)(intptr_t)fd) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+// One keep-alive connection: count the records in each POST body and answer 200 with no body.
+static void *bench_server_connection(void *arg)
+{
+    int fd = (int)(intptr_t)arg;
+    static char request[BENCH_REQUEST_LEN + 1];
+    size_t used = 0;
+    for (;;)
+    {
+        ssize_t count = recv(fd, request + used, BENCH_REQUEST_LEN - used, 0);
+        if (count <= 0)
+        {
+            break;
+        }
+        used += (size_t)count;
+        request[used] = '\0';
+
+        char *end;
+        while ((end = strstr(request, "\r\n\r\n")) != NULL)
+        {
+            size_t header_len = (size_t)(end - request) + 4U;
+            const char *length = strstr(request, "Content-Length:");
+            size_t body_len = (length != NULL && length < end) ? strtoul(length + 15, NULL, 10) : 0U;
+            if (used < header_len + body_len)
+            {
+                break; // The body is still on its way.
+            }
+
+            bench_server_count(request + header_len, body_len);
+            static const char response[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+            send(fd, response, sizeof(response) - 1U, MSG_NOSIGNAL);
+
+            memmove(request, request + header_len + body_len, used - header_len - body_len);
+            used -= header_len + body_len;
+            request[used] = '\0';
+        }
+        if (used == BENCH_REQUEST_LEN)
+        {
+            used = 0; // Not a request this server understands; keep draining.
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+static void bench_server_count(const char *body, size_t length)
+{
+    static uint32_t next_sequence;
+    const char *end = body + length;
+    const char *seq = body;
+    while ((seq = strstr(seq, "\"seq\":")) != NULL && seq < end)
+    {
+        uint32_t sequence = (uint32_t)strtoul(seq + 6, NULL, 10);
+        bench_out_of_order += (sequence != next_sequence) ? 1U : 0U;
+        next_sequence = sequence + 1U;
+        bench_received++;
+        seq += 6;
+    }
+    bench_body_bytes += length;
+}
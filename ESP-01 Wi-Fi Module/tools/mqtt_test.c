@@ -0,0 +1,626 @@
+// Host-side checks for the MQTT client: the real driver and wifi_mqtt.c talk to the emulated module
+// in esp_emulator.c, which forwards the link to a small MQTT 3.1.1 broker stand-in on 127.0.0.1.
+// Build from this directory:
+//
+//     SRC="mqtt_test.c esp_emulator.c host/fake_hal.c ../Drivers/wifi_basic_driver.c ../Drivers/wifi_mqtt.c"
+//     gcc -std=c11 -O2 -DWIFI_DEBUG=0 -Ihost -I../Drivers $SRC ../Drivers/wifi_retry.c ../Drivers/uart_dispatch.c -lpthread -o mqtt_test
+//     ./mqtt_test          (-v prints the AT traffic)
+//
+// The broker answers CONNECT, SUBSCRIBE, PUBLISH and PINGREQ, and resends a QoS 1 message with the
+// DUP flag when its PUBACK has not arrived within BROKER_RESEND_MS. Each case prints "ok" or "FAIL"
+// per check. The exit status is the number of failures.
+
+#define _POSIX_C_SOURCE 200809L
+#include "esp_emulator.h"
+#include "wifi_basic_driver.h"
+#include "wifi_mqtt.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define BROKER_OUT_LEN 32        // QoS 1 messages the broker can have in flight.
+#define BROKER_PACKET_LEN 512
+#define BROKER_RESEND_MS 1000U
+#define TEST_MESSAGES 12         // Burst size, three times WIFI_MQTT_ACK_QUEUE_LEN.
+
+// A QoS 1 message from the broker that the client has not acknowledged yet.
+typedef struct
+{
+    uint16_t packet_id;
+    uint8_t acked;
+    uint64_t sent_us;
+    uint16_t length;
+    uint8_t packet[BROKER_PACKET_LEN];
+} broker_message_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    int fd;                      // Current connection, -1 when there is none.
+    uint8_t connack_code;        // Return code for the next CONNECT.
+
+    uint32_t connects;
+    uint8_t connect_flags;
+    uint16_t keep_alive;
+    char client_id[32];
+    char username[32];
+    char password[32];
+
+    uint32_t subscribes;
+    uint32_t publishes;          // PUBLISH packets from the client.
+    uint8_t last_qos;
+    char last_topic[64];
+    char last_payload[64];
+    uint32_t pings;
+    uint32_t disconnects;
+
+    broker_message_t out[BROKER_OUT_LEN];
+    uint8_t out_count;
+    uint16_t next_packet_id;
+    uint32_t pubacks;            // PUBACKs from the client that matched a message in flight.
+    uint32_t resends;
+
+    // The PUBACK for a client PUBLISH to "echo" is held back until the client has acknowledged the
+    // copy the broker sends it, so a client that only acks between calls times out.
+    uint8_t held;
+    uint16_t held_id;
+} broker_t;
+
+static broker_t broker = {.lock = PTHREAD_MUTEX_INITIALIZER, .fd = -1};
+static wifi_handle_t test_wifi;
+static wifi_mqtt_client_t test_client;
+static uint32_t test_received[TEST_MESSAGES];
+static uint32_t test_messages;
+static uint16_t test_last_length;
+static int test_failures;
+
+static uint16_t broker_start(void);
+static void *broker_main(void *arg);
+static void broker_connection(int fd);
+static void broker_packet(int fd, const uint8_t *packet, uint32_t header, uint32_t length);
+static uint16_t broker_build(uint8_t *out, const char *topic, const uint8_t *payload, uint16_t length, uint8_t qos, uint16_t packet_id);
+static void broker_queue(uint8_t *out, uint16_t length, uint16_t packet_id);
+static void broker_resend(int fd);
+static void broker_copy(char *out, size_t out_len, const uint8_t *data, uint16_t length);
+static uint16_t broker_publish(const char *topic, const char *payload, uint16_t length);
+static uint8_t broker_all_acked(void);
+
+static void check(int ok, const char *what)
+{
+    printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        test_failures++;
+    }
+}
+
+static void on_message(const char *topic, uint16_t topic_length, const uint8_t *payload, uint16_t length, void *context)
+{
+    (void)context;
+    unsigned int index;
+    test_messages++;
+    test_last_length = length;
+    if (topic_length == 5 && memcmp(topic, "burst", 5) == 0 && length == 3 && sscanf((const char *)payload, "m%2u", &index) == 1 &&
+        index < TEST_MESSAGES)
+    {
+        test_received[index]++;
+    }
+}
+
+// Keep the client running for ms milliseconds, as a main loop would.
+static void run(uint32_t ms)
+{
+    uint32_t start = HAL_GetTick();
+    while ((HAL_GetTick() - start) < ms)
+    {
+        WiFi_MQTT_Poll(&test_client);
+    }
+}
+
+static void test_connect(void)
+{
+    printf("connect\n");
+    esp_emulator_stats_t before;
+    esp_emulator_stats_t after;
+    ESP_Emulator_GetStats(&before);
+    wifi_status_t status = WiFi_MQTT_Connect(&test_client, NULL, "secret", 2, 5000);
+    ESP_Emulator_GetStats(&after);
+    check(status == WIFI_ERROR && after.connects == before.connects, "a password without a user name is refused before CIPSTART");
+
+    pthread_mutex_lock(&broker.lock);
+    broker.connack_code = 5;
+    pthread_mutex_unlock(&broker.lock);
+    status = WiFi_MQTT_Connect(&test_client, "node", "secret", 2, 5000);
+    run(50);
+    check(status == WIFI_ERROR && !WiFi_MQTT_IsConnected(&test_client) && !WiFi_IsLinkOpen(&test_wifi),
+          "CONNACK 5 (not authorised) fails and closes the link");
+
+    pthread_mutex_lock(&broker.lock);
+    broker.connack_code = 0;
+    pthread_mutex_unlock(&broker.lock);
+    status = WiFi_MQTT_Connect(&test_client, "node", "secret", 2, 5000);
+    check(status == WIFI_OK && WiFi_MQTT_IsConnected(&test_client), "CONNACK 0 connects");
+
+    pthread_mutex_lock(&broker.lock);
+    check(broker.connect_flags == 0xC2 && broker.keep_alive == 2, "CONNECT carries user name, password, clean session, keep-alive");
+    check(strcmp(broker.client_id, "test-node") == 0 && strcmp(broker.username, "node") == 0 && strcmp(broker.password, "secret") == 0,
+          "client ID, user name and password arrive intact");
+    pthread_mutex_unlock(&broker.lock);
+}
+
+static void test_publish(void)
+{
+    printf("publish\n");
+    wifi_status_t qos0 = WiFi_MQTT_Publish(&test_client, "nodes/1/temp", (const uint8_t *)"21.5", 4, 0, 0, 2000);
+    run(50);
+    pthread_mutex_lock(&broker.lock);
+    check(qos0 == WIFI_OK && broker.publishes == 1 && broker.last_qos == 0 && strcmp(broker.last_topic, "nodes/1/temp") == 0 &&
+              strcmp(broker.last_payload, "21.5") == 0,
+          "QoS 0 publish");
+    pthread_mutex_unlock(&broker.lock);
+
+    wifi_status_t qos1 = WiFi_MQTT_Publish(&test_client, "nodes/1/hum", (const uint8_t *)"45", 2, 1, 0, 2000);
+    pthread_mutex_lock(&broker.lock);
+    check(qos1 == WIFI_OK && broker.publishes == 2 && broker.last_qos == 1 && strcmp(broker.last_payload, "45") == 0,
+          "QoS 1 publish returns after its PUBACK");
+    pthread_mutex_unlock(&broker.lock);
+
+    check(WiFi_MQTT_Subscribe(&test_client, "burst", 1, 2000) == WIFI_OK, "subscribe, QoS 1 granted");
+    check(WiFi_MQTT_Subscribe(&test_client, "echo/reply", 1, 2000) == WIFI_OK, "second subscription");
+}
+
+// The broker's copy arrives while the client is blocked in WiFi_MQTT_Publish(). Its PUBACK has to go
+// out from inside that call, because the broker holds the client's own PUBACK until it does.
+static void test_ack_during_call(void)
+{
+    printf("PUBACK while a call is blocked\n");
+    uint32_t messages = test_messages;
+    wifi_status_t status = WiFi_MQTT_Publish(&test_client, "echo", (const uint8_t *)"ping", 4, 1, 0, 3000);
+    pthread_mutex_lock(&broker.lock);
+    check(status == WIFI_OK && broker_all_acked() && !broker.held, "publish completes; the incoming copy was acknowledged first");
+    pthread_mutex_unlock(&broker.lock);
+    check(test_messages == messages + 1U, "the copy was delivered once");
+}
+
+// Three times as many QoS 1 messages as there are PUBACK slots, in one TCP segment. Messages that
+// find every slot taken must not be delivered; the broker resends them and they arrive later.
+static void test_burst(void)
+{
+    printf("QoS 1 burst beyond the PUBACK slots\n");
+    memset(test_received, 0, sizeof(test_received));
+    uint32_t dropped = test_client.dropped;
+
+    static uint8_t burst[TEST_MESSAGES * 16];
+    uint16_t length = 0;
+    pthread_mutex_lock(&broker.lock);
+    uint32_t resends = broker.resends;
+    for (unsigned int i = 0; i < TEST_MESSAGES; i++)
+    {
+        char payload[4];
+        snprintf(payload, sizeof(payload), "m%02u", i);
+        uint16_t packet_id = broker.next_packet_id++;
+        uint16_t size = broker_build(&burst[length], "burst", (const uint8_t *)payload, 3, 1, packet_id);
+        broker_queue(&burst[length], size, packet_id);
+        length = (uint16_t)(length + size);
+    }
+    send(broker.fd, burst, length, MSG_NOSIGNAL);
+    pthread_mutex_unlock(&broker.lock);
+
+    uint32_t start = HAL_GetTick();
+    uint8_t done = 0;
+    while (!done && (HAL_GetTick() - start) < 6U * BROKER_RESEND_MS)
+    {
+        run(20);
+        pthread_mutex_lock(&broker.lock);
+        done = broker_all_acked();
+        pthread_mutex_unlock(&broker.lock);
+    }
+    // The broker has the last PUBACK once its bytes leave the module; the slot is freed at SEND OK.
+    start = HAL_GetTick();
+    while ((test_client.ack_count != 0 || WiFi_Command_Pending(&test_wifi) != 0) && (HAL_GetTick() - start) < 1000U)
+    {
+        run(5);
+    }
+
+    uint8_t once = 1;
+    for (unsigned int i = 0; i < TEST_MESSAGES; i++)
+    {
+        once = (uint8_t)(once && test_received[i] == 1U);
+    }
+    check(done, "every message was acknowledged");
+    check(once, "every message was delivered exactly once");
+    check(test_client.dropped > dropped && broker.resends > resends, "messages without a slot were left to the broker to resend");
+    check(test_client.ack_count == 0 && WiFi_Command_Pending(&test_wifi) == 0, "every PUBACK slot is free again");
+}
+
+static void test_oversize(void)
+{
+    printf("QoS 1 message larger than WIFI_MQTT_RX_LEN\n");
+    static char payload[WIFI_MQTT_RX_LEN + 100];
+    memset(payload, 'x', sizeof(payload));
+    uint32_t messages = test_messages;
+    uint32_t dropped = test_client.dropped;
+    uint16_t packet_id = broker_publish("burst", payload, sizeof(payload));
+
+    uint32_t start = HAL_GetTick();
+    uint8_t acked = 0;
+    while (!acked && (HAL_GetTick() - start) < BROKER_RESEND_MS / 2U)
+    {
+        run(20);
+        pthread_mutex_lock(&broker.lock);
+        acked = broker_all_acked();
+        pthread_mutex_unlock(&broker.lock);
+    }
+    check(acked && packet_id != 0, "acknowledged before the broker resends it");
+    check(test_messages == messages && test_client.dropped == dropped + 1U, "not delivered, counted as dropped");
+
+    uint16_t small = broker_publish("burst", "m00", 3);
+    run(200);
+    check(small != 0 && test_messages == messages + 1U && test_last_length == 3, "the next message is parsed normally");
+}
+
+static void test_keep_alive(void)
+{
+    printf("keep-alive\n");
+    pthread_mutex_lock(&broker.lock);
+    uint32_t pings = broker.pings;
+    pthread_mutex_unlock(&broker.lock);
+    run(1600); // Keep-alive 2 s: a PINGREQ is due after 1 s of silence.
+    pthread_mutex_lock(&broker.lock);
+    check(broker.pings > pings, "PINGREQ after half the keep-alive");
+    pthread_mutex_unlock(&broker.lock);
+    check(WiFi_MQTT_IsConnected(&test_client) && !test_client.ping_outstanding, "PINGRESP keeps the connection");
+}
+
+static void test_disconnect(void)
+{
+    printf("disconnect\n");
+    wifi_status_t status = WiFi_MQTT_Disconnect(&test_client);
+    run(100);
+    pthread_mutex_lock(&broker.lock);
+    check(status == WIFI_OK && broker.disconnects == 1 && !WiFi_IsLinkOpen(&test_wifi), "DISCONNECT sent and the link closed");
+    pthread_mutex_unlock(&broker.lock);
+}
+
+int main(int argc, char **argv)
+{
+    esp_emulator_config_t config;
+    ESP_Emulator_DefaultConfig(&config);
+    config.verbose = (uint8_t)(argc > 1 && strcmp(argv[1], "-v") == 0);
+    config.forward_port = broker_start();
+    if (config.forward_port == 0)
+    {
+        return 1;
+    }
+
+    static UART_HandleTypeDef huart;
+    huart.Init.BaudRate = 115200;
+    ESP_Emulator_Start(&config, &huart);
+    if (WiFi_Init(&test_wifi, &huart) != WIFI_OK || WiFi_Connect(&test_wifi, "test", "password") != WIFI_OK)
+    {
+        fprintf(stderr, "the driver did not come up against the emulator\n");
+        return 1;
+    }
+    WiFi_MQTT_Init(&test_client, &test_wifi, "127.0.0.1", 1883, "test-node", on_message, NULL);
+
+    test_connect();
+    test_publish();
+    test_ack_during_call();
+    test_burst();
+    test_oversize();
+    test_keep_alive();
+    test_disconnect();
+
+    printf("%d failure%s\n", test_failures, (test_failures == 1) ? "" : "s");
+    return test_failures;
+}
+
+// Called with the lock held.
+static uint8_t broker_all_acked(void)
+{
+    for (uint8_t i = 0; i < broker.out_count; i++)
+    {
+        if (!broker.out[i].acked)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Send one QoS 1 message to the client; returns its packet ID, or 0 when it did not fit.
+static uint16_t broker_publish(const char *topic, const char *payload, uint16_t length)
+{
+    static uint8_t packet[BROKER_PACKET_LEN];
+    pthread_mutex_lock(&broker.lock);
+    uint16_t packet_id = broker.next_packet_id++;
+    uint16_t size = broker_build(packet, topic, (const uint8_t *)payload, length, 1, packet_id);
+    if (size == 0 || broker.fd < 0)
+    {
+        pthread_mutex_unlock(&broker.lock);
+        return 0;
+    }
+    broker_queue(packet, size, packet_id);
+    send(broker.fd, packet, size, MSG_NOSIGNAL);
+    pthread_mutex_unlock(&broker.lock);
+    return packet_id;
+}
+
+static uint16_t broker_start(void)
+{
+    static int listener;
+    struct sockaddr_in address;
+    socklen_t address_len = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 4) != 0 ||
+        getsockname(listener, (struct sockaddr *)&address, &address_len) != 0)
+    {
+        perror("broker");
+        return 0;
+    }
+
+    broker.next_packet_id = 1;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, broker_main, &listener) != 0)
+    {
+        return 0;
+    }
+    pthread_detach(thread);
+    return ntohs(address.sin_port);
+}
+
+// One client at a time, which is all the single-link driver can open.
+static void *broker_main(void *arg)
+{
+    int listener = *(int *)arg;
+    for (;;)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if (fd >= 0)
+        {
+            broker_connection(fd);
+        }
+    }
+    return NULL;
+}
+
+static void broker_connection(int fd)
+{
+    struct timeval timeout = {0, 20000}; // Wake up regularly to resend unacknowledged messages.
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    pthread_mutex_lock(&broker.lock);
+    broker.fd = fd;
+    broker.out_count = 0;
+    broker.held = 0;
+    pthread_mutex_unlock(&broker.lock);
+
+    static uint8_t rx[4096];
+    uint32_t used = 0;
+    for (;;)
+    {
+        ssize_t count = recv(fd, rx + used, sizeof(rx) - used, 0);
+        if (count == 0 || (count < 0 && used == sizeof(rx)))
+        {
+            break;
+        }
+        used += (count > 0) ? (uint32_t)count : 0U;
+
+        pthread_mutex_lock(&broker.lock);
+        for (;;)
+        {
+            // Fixed header: type byte, then the remaining length in up to four 7-bit groups.
+            uint32_t length = 0;
+            uint32_t multiplier = 1;
+            uint32_t header = 1;
+            uint8_t complete = 0;
+            while (!complete && header < used && header < 5)
+            {
+                length += (uint32_t)(rx[header] & 0x7FU) * multiplier;
+                multiplier *= 128U;
+                complete = (uint8_t)((rx[header++] & 0x80U) == 0);
+            }
+            if (!complete || used < header + length)
+            {
+                break; // Incomplete.
+            }
+            broker_packet(fd, rx, header, length);
+            memmove(rx, rx + header + length, used - header - length);
+            used -= header + length;
+        }
+        broker_resend(fd);
+        pthread_mutex_unlock(&broker.lock);
+    }
+
+    pthread_mutex_lock(&broker.lock);
+    broker.fd = -1;
+    pthread_mutex_unlock(&broker.lock);
+    close(fd);
+}
+
+// Called with the lock held. packet holds header bytes of fixed header, then length bytes of body.
+static void broker_packet(int fd, const uint8_t *packet, uint32_t header, uint32_t length)
+{
+    const uint8_t *body = packet + header;
+    uint8_t type = packet[0] & 0xF0U;
+    switch (type)
+    {
+    case 0x10: // CONNECT: "MQTT", level, flags, keep-alive, then client ID, user name, password.
+    {
+        broker.connects++;
+        broker.connect_flags = body[7];
+        broker.keep_alive = (uint16_t)((body[8] << 8) | body[9]);
+        const uint8_t *field = body + 10;
+        char *fields[3] = {broker.client_id, broker.username, broker.password};
+        broker.username[0] = '\0';
+        broker.password[0] = '\0';
+        for (uint8_t i = 0; i < 3 && field + 2 <= body + length; i++)
+        {
+            if (i > 0 && !(broker.connect_flags & (i == 1 ? 0x80U : 0x40U)))
+            {
+                continue;
+            }
+            uint16_t size = (uint16_t)((field[0] << 8) | field[1]);
+            broker_copy(fields[i], 32, field + 2, size);
+            field += 2U + size;
+        }
+        uint8_t connack[4] = {0x20, 2, 0, broker.connack_code};
+        send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+        break;
+    }
+
+    case 0x30: // PUBLISH
+    {
+        uint8_t qos = (packet[0] >> 1) & 0x03U;
+        uint16_t topic_length = (uint16_t)((body[0] << 8) | body[1]);
+        uint32_t offset = 2U + topic_length + ((qos > 0) ? 2U : 0U);
+        broker.publishes++;
+        broker.last_qos = qos;
+        broker_copy(broker.last_topic, sizeof(broker.last_topic), body + 2, topic_length);
+        broker_copy(broker.last_payload, sizeof(broker.last_payload), body + offset, (uint16_t)(length - offset));
+        if (qos == 0)
+        {
+            break;
+        }
+
+        uint16_t packet_id = (uint16_t)((body[2U + topic_length] << 8) | body[3U + topic_length]);
+        if (strcmp(broker.last_topic, "echo") == 0)
+        {
+            static uint8_t copy[BROKER_PACKET_LEN];
+            uint16_t reply_id = broker.next_packet_id++;
+            uint16_t size = broker_build(copy, "echo/reply", body + offset, (uint16_t)(length - offset), 1, reply_id);
+            broker_queue(copy, size, reply_id);
+            send(fd, copy, size, MSG_NOSIGNAL);
+            broker.held = 1;
+            broker.held_id = packet_id;
+            break;
+        }
+        uint8_t puback[4] = {0x40, 2, (uint8_t)(packet_id >> 8), (uint8_t)packet_id};
+        send(fd, puback, sizeof(puback), MSG_NOSIGNAL);
+        break;
+    }
+
+    case 0x40: // PUBACK
+    {
+        uint16_t packet_id = (uint16_t)((body[0] << 8) | body[1]);
+        for (uint8_t i = 0; i < broker.out_count; i++)
+        {
+            if (broker.out[i].packet_id == packet_id && !broker.out[i].acked)
+            {
+                broker.out[i].acked = 1;
+                broker.pubacks++;
+            }
+        }
+        if (broker.held && broker_all_acked())
+        {
+            uint8_t puback[4] = {0x40, 2, (uint8_t)(broker.held_id >> 8), (uint8_t)broker.held_id};
+            send(fd, puback, sizeof(puback), MSG_NOSIGNAL);
+            broker.held = 0;
+        }
+        break;
+    }
+
+    case 0x80: // SUBSCRIBE: packet ID, then filter and QoS.
+    {
+        uint8_t suback[5] = {0x90, 3, body[0], body[1], body[length - 1U]};
+        broker.subscribes++;
+        send(fd, suback, sizeof(suback), MSG_NOSIGNAL);
+        break;
+    }
+
+    case 0xC0: // PINGREQ
+    {
+        static const uint8_t pingresp[2] = {0xD0, 0};
+        broker.pings++;
+        send(fd, pingresp, sizeof(pingresp), MSG_NOSIGNAL);
+        break;
+    }
+
+    case 0xE0:
+        broker.disconnects++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Returns the packet length, or 0 when it does not fit BROKER_PACKET_LEN.
+static uint16_t broker_build(uint8_t *out, const char *topic, const uint8_t *payload, uint16_t length, uint8_t qos, uint16_t packet_id)
+{
+    uint16_t topic_length = (uint16_t)strlen(topic);
+    uint32_t remaining = 2U + topic_length + ((qos > 0) ? 2U : 0U) + length;
+    if (remaining + 3U > BROKER_PACKET_LEN)
+    {
+        return 0;
+    }
+
+    uint8_t *p = out;
+    *p++ = (uint8_t)(0x30U | (qos << 1));
+    do
+    {
+        uint8_t byte = (uint8_t)(remaining % 128U);
+        remaining /= 128U;
+        *p++ = (uint8_t)(byte | ((remaining > 0) ? 0x80U : 0U));
+    } while (remaining > 0);
+    *p++ = (uint8_t)(topic_length >> 8);
+    *p++ = (uint8_t)topic_length;
+    memcpy(p, topic, topic_length);
+    p += topic_length;
+    if (qos > 0)
+    {
+        *p++ = (uint8_t)(packet_id >> 8);
+        *p++ = (uint8_t)packet_id;
+    }
+    memcpy(p, payload, length);
+    return (uint16_t)(p + length - out);
+}
+
+// Called with the lock held: remember a QoS 1 message until the client acknowledges it.
+static void broker_queue(uint8_t *out, uint16_t length, uint16_t packet_id)
+{
+    if (broker.out_count == BROKER_OUT_LEN)
+    {
+        memmove(&broker.out[0], &broker.out[1], (BROKER_OUT_LEN - 1U) * sizeof(broker.out[0])); // Forget the oldest.
+        broker.out_count--;
+    }
+    broker_message_t *message = &broker.out[broker.out_count++];
+    message->packet_id = packet_id;
+    message->acked = 0;
+    message->sent_us = Fake_HAL_Micros();
+    message->length = length;
+    memcpy(message->packet, out, length);
+}
+
+// Called with the lock held. Resent packets carry the DUP flag (MQTT 3.1.1 section 3.3.1.1).
+static void broker_resend(int fd)
+{
+    uint64_t now = Fake_HAL_Micros();
+    for (uint8_t i = 0; i < broker.out_count; i++)
+    {
+        broker_message_t *message = &broker.out[i];
+        if (!message->acked && now - message->sent_us >= (uint64_t)BROKER_RESEND_MS * 1000U)
+        {
+            message->packet[0] |= 0x08U;
+            message->sent_us = now;
+            broker.resends++;
+            send(fd, message->packet, message->length, MSG_NOSIGNAL);
+        }
+    }
+}
+
+static void broker_copy(char *out, size_t out_len, const uint8_t *data, uint16_t length)
+{
+    size_t count = (length < out_len) ? length : out_len - 1U;
+    memcpy(out, data, count);
+    out[count] = '\0';
+}
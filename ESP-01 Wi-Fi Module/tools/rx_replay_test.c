@@ -0,0 +1,289 @@
+// Host-side check that the receive ring loses no bytes: bursty module output is replayed onto the
+// fake UART at the wire speed of 921600 baud while the application reads the ring with
+// WiFi_Read() from a main loop that is busy elsewhere between reads. Build from this directory:
+//
+//     SRC="rx_replay_test.c esp_emulator.c host/fake_hal.c ../Drivers/wifi_basic_driver.c"
+//     gcc -std=c11 -O2 -DWIFI_DEBUG=0 -Ihost -I../Drivers $SRC ../Drivers/wifi_retry.c ../Drivers/uart_dispatch.c -o rx_replay_test
+//     ./rx_replay_test
+//
+// Add -DWIFI_TRANSPORT=WIFI_TRANSPORT_DMA to replay into the circular DMA receive path instead of IT.
+// Options:
+//     -k KiB       traffic to replay (default 256)
+//     -p ms        time the main loop spends elsewhere between two reads (default 5)
+//     -s seed      seed for the burst lengths and gaps (default 1)
+//
+// The traffic repeats SEND OK, an +IPD frame and CLOSED, cut into bursts of 1 to 3 x WIFI_RX_BUF_LEN
+// bytes. A quarter of the bursts follow the previous one with no gap, so no IDLE event separates
+// them; the others leave a gap of up to 400 us. A second case stops reading altogether and checks
+// that the ring keeps the oldest bytes and counts the rest as overruns, not as received.
+// Each check prints "ok" or "FAIL". The exit status is the number of failures.
+
+#define _POSIX_C_SOURCE 200809L
+#include "esp_emulator.h"
+#include "wifi_basic_driver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_BAUD 921600U
+#define TEST_MAX_GAP_US 400U
+#define TEST_MAX_STEP_NS 1000000U // Longer pauses of the test process stop the wire clock.
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t length;
+    size_t sent;              // Bytes put on the wire so far.
+    size_t burst_first;       // Offset of the burst on the wire.
+    size_t burst_end;
+    size_t max_burst;
+    uint64_t burst_start_ns;
+    uint64_t last_ns;         // Time of the previous service call.
+    uint32_t gap_ns;          // Silence after the current burst.
+    uint32_t bursts;
+    uint32_t back_to_back;    // Bursts with no IDLE event in front of them.
+    uint32_t refused;         // Bytes that found no reception armed.
+    uint8_t finished;         // Every byte is on the wire and the final IDLE event has been raised.
+} replay_t;
+
+static replay_t replay;
+static uint32_t replay_byte_ns;
+static uint32_t test_seed = 1;
+static int test_failures;
+
+static void check(int ok, const char *what)
+{
+    printf("  %-4s %s\n", ok ? "ok" : "FAIL", what);
+    if (!ok)
+    {
+        test_failures++;
+    }
+}
+
+static uint32_t test_random(void)
+{
+    test_seed = test_seed * 1103515245U + 12345U;
+    return (test_seed >> 16) & 0x7FFFU;
+}
+
+static void replay_next_burst(uint64_t start_ns)
+{
+    size_t length = 1U + test_random() % replay.max_burst;
+    replay.burst_first = replay.sent;
+    replay.burst_end = (replay.length - replay.sent < length) ? replay.length : replay.sent + length;
+    replay.burst_start_ns = start_ns;
+    replay.gap_ns = (test_random() % 4U == 0U) ? 0U : (1U + test_random() % TEST_MAX_GAP_US) * 1000U;
+    replay.bursts++;
+}
+
+static void replay_start(const uint8_t *data, size_t length, size_t max_burst)
+{
+    memset(&replay, 0, sizeof(replay));
+    replay.data = data;
+    replay.length = length;
+    replay.max_burst = max_burst;
+    replay.last_ns = Fake_HAL_Micros() * 1000U;
+    replay_next_burst(replay.last_ns);
+}
+
+// When the last byte of the current burst has left the wire.
+static uint64_t replay_burst_end_ns(void)
+{
+    return replay.burst_start_ns + (uint64_t)(replay.burst_end - replay.burst_first) * replay_byte_ns;
+}
+
+// Runs from HAL_GetTick()/HAL_Delay() like the RX interrupts: puts on the wire every byte whose
+// time has come, and raises IDLE one character time after a burst that has a gap behind it.
+// When the process was descheduled, the wire waits too: on the MCU the main loop would not have
+// stalled while the bytes kept coming, so a busy PC must not show up as overruns.
+static void replay_service(void *context)
+{
+    (void)context;
+    uint64_t now_ns = Fake_HAL_Micros() * 1000U;
+    if (now_ns - replay.last_ns > TEST_MAX_STEP_NS)
+    {
+        replay.burst_start_ns += now_ns - replay.last_ns - TEST_MAX_STEP_NS;
+    }
+    replay.last_ns = now_ns;
+    while (!replay.finished && now_ns >= replay.burst_start_ns)
+    {
+        size_t due = replay.burst_first + (size_t)((now_ns - replay.burst_start_ns) / replay_byte_ns) + 1U;
+        if (due > replay.burst_end)
+        {
+            due = replay.burst_end;
+        }
+        while (replay.sent < due)
+        {
+            uint16_t count = (due - replay.sent > 0xFFFFU) ? 0xFFFFU : (uint16_t)(due - replay.sent);
+            uint16_t accepted = Fake_UART_Receive(replay.data + replay.sent, count);
+            replay.refused += (uint32_t)(count - accepted);
+            replay.sent += count;
+        }
+        if (replay.sent < replay.burst_end)
+        {
+            return;
+        }
+
+        // The line always goes quiet after the last byte.
+        uint8_t last = (uint8_t)(replay.sent == replay.length);
+        if (replay.gap_ns >= replay_byte_ns || last)
+        {
+            if (now_ns < replay_burst_end_ns() + replay_byte_ns)
+            {
+                return;
+            }
+            Fake_UART_Idle();
+        }
+        if (last)
+        {
+            replay.finished = 1U;
+            return;
+        }
+        replay.back_to_back += (replay.gap_ns == 0U) ? 1U : 0U;
+        replay_next_burst(replay_burst_end_ns() + replay.gap_ns);
+    }
+}
+
+// SEND OK, one +IPD frame whose payload bytes all differ from their neighbours, and CLOSED.
+static void test_traffic(uint8_t *out, size_t length)
+{
+    size_t used = 0;
+    uint32_t exchange = 0;
+    while (used < length)
+    {
+        char head[48];
+        uint16_t payload = (uint16_t)(1U + exchange * 37U % 700U);
+        int head_len = snprintf(head, sizeof(head), "\r\nSEND OK\r\n\r\n+IPD,%u:", payload);
+        for (int i = 0; i < head_len && used < length; i++)
+        {
+            out[used++] = (uint8_t)head[i];
+        }
+        for (uint16_t i = 0; i < payload && used < length; i++)
+        {
+            out[used] = (uint8_t)(used * 131U + exchange);
+            used++;
+        }
+        static const char closed[] = "CLOSED\r\n";
+        for (size_t i = 0; i < sizeof(closed) - 1U && used < length; i++)
+        {
+            out[used++] = (uint8_t)closed[i];
+        }
+        exchange++;
+    }
+}
+
+static void test_bursts(wifi_handle_t *wifi, const uint8_t *traffic, size_t length, uint32_t poll_ms)
+{
+    printf("%.0f KiB in bursts at %u baud, reading every %u ms\n", (double)length / 1024.0, TEST_BAUD, poll_ms);
+    static uint8_t chunk[WIFI_RX_RING_LEN];
+    size_t read = 0;
+    uint32_t mismatches = 0;
+    uint16_t peak = 0;
+    uint32_t overruns = WiFi_GetRxOverruns(wifi);
+    WiFi_ResetTransportStats(wifi);
+    replay_start(traffic, length, 3U * WIFI_RX_BUF_LEN);
+
+    while (!replay.finished || WiFi_Available(wifi) > 0U)
+    {
+        HAL_Delay(poll_ms); // The rest of the main loop; the RX interrupts keep running.
+        uint16_t available = WiFi_Available(wifi);
+        peak = (available > peak) ? available : peak;
+        uint16_t count;
+        while ((count = WiFi_Read(wifi, chunk, sizeof(chunk))) > 0U)
+        {
+            for (uint16_t i = 0; i < count; i++)
+            {
+                mismatches += (read + i >= length || chunk[i] != traffic[read + i]) ? 1U : 0U;
+            }
+            read += count;
+        }
+    }
+
+    wifi_transport_stats_t stats;
+    WiFi_GetTransportStats(wifi, &stats);
+    printf("    %u bursts, %u back to back, ring peak %u of %u bytes, %lu RX interrupts\n", replay.bursts, replay.back_to_back, peak,
+           WIFI_RX_RING_LEN, (unsigned long)stats.rx_irqs);
+    check(replay.refused == 0U, "reception was armed for every byte");
+    check(read == length, "every byte on the wire was read");
+    check(mismatches == 0U, "bytes arrive in order and unchanged");
+    check(WiFi_GetRxOverruns(wifi) == overruns, "no overruns");
+    check(stats.rx_bytes == length, "rx_bytes counts every byte");
+}
+
+static void test_stall(wifi_handle_t *wifi, const uint8_t *traffic)
+{
+    size_t length = 3U * WIFI_RX_RING_LEN;
+    printf("one %u-byte burst while the application does not read\n", (unsigned int)length);
+    uint32_t overruns = WiFi_GetRxOverruns(wifi);
+    WiFi_ResetTransportStats(wifi);
+    replay_start(traffic, length, length);
+    while (!replay.finished)
+    {
+        HAL_Delay(1);
+    }
+
+    static uint8_t chunk[WIFI_RX_RING_LEN + 1U];
+    uint16_t read = WiFi_Read(wifi, chunk, sizeof(chunk));
+    wifi_transport_stats_t stats;
+    WiFi_GetTransportStats(wifi, &stats);
+    uint32_t dropped = WiFi_GetRxOverruns(wifi) - overruns;
+    check(read == WIFI_RX_RING_LEN && memcmp(chunk, traffic, read) == 0, "the ring keeps the oldest WIFI_RX_RING_LEN bytes");
+    check(dropped == length - WIFI_RX_RING_LEN, "the rest is counted as overruns");
+    check(stats.rx_bytes == WIFI_RX_RING_LEN, "rx_bytes counts only the stored bytes");
+    check(stats.rx_bytes + dropped == length, "rx_bytes plus overruns is what was on the wire");
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t kib = 256;
+    uint32_t poll_ms = 5;
+    int option;
+    while ((option = getopt(argc, argv, "k:p:s:")) != -1)
+    {
+        switch (option)
+        {
+        case 'k': kib = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'p': poll_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 's': test_seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default:
+            fprintf(stderr, "usage: %s [-k KiB] [-p ms] [-s seed]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t length = (size_t)kib * 1024U;
+    size_t traffic_len = (length > 3U * WIFI_RX_RING_LEN) ? length : 3U * WIFI_RX_RING_LEN;
+    uint8_t *traffic = malloc(traffic_len);
+    test_traffic(traffic, traffic_len);
+
+    // The emulator answers WiFi_Init(); after that the replay owns the wire.
+    esp_emulator_config_t config;
+    ESP_Emulator_DefaultConfig(&config);
+    static UART_HandleTypeDef huart;
+    static wifi_handle_t wifi;
+    huart.Init.BaudRate = TEST_BAUD;
+    ESP_Emulator_Start(&config, &huart);
+    if (WiFi_Init(&wifi, &huart) != WIFI_OK)
+    {
+        fprintf(stderr, "the driver did not come up against the emulator\n");
+        return 1;
+    }
+    WiFi_Poll(&wifi);
+    static uint8_t leftover[WIFI_RX_RING_LEN];
+    while (WiFi_Read(&wifi, leftover, sizeof(leftover)) > 0U)
+    {
+    }
+
+    replay_byte_ns = (uint32_t)(10000000000ULL / TEST_BAUD); // Start, 8 data and stop bits.
+    static const fake_uart_peer_t peer = {NULL, replay_service, NULL};
+    Fake_UART_Attach(&peer);
+    printf("transport %s\n", (WIFI_TRANSPORT == WIFI_TRANSPORT_DMA) ? "DMA" : "IT");
+
+    test_bursts(&wifi, traffic, length, poll_ms);
+    test_stall(&wifi, traffic);
+
+    free(traffic);
+    printf("%d failure%s\n", test_failures, (test_failures == 1) ? "" : "s");
+    return test_failures;
+}
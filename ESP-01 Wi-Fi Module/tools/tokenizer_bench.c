@@ -0,0 +1,172 @@
+// Host benchmark for the response tokenizer: canned module output is fed to the real driver through
+// the fake UART (host/fake_hal.c) and parsed by WiFi_Poll(), and the same bytes are run through the
+// shadow-buffer and strstr() handling the driver used before the tokenizer. Build from this directory:
+//
+//     SRC="tokenizer_bench.c esp_emulator.c host/fake_hal.c ../Drivers/wifi_basic_driver.c"
+//     gcc -std=c11 -O2 -DWIFI_DEBUG=0 -Ihost -I../Drivers $SRC ../Drivers/wifi_retry.c ../Drivers/uart_dispatch.c -o tokenizer_bench
+//     ./tokenizer_bench -k 4096 -c 64
+//
+// Add -DWIFI_TRANSPORT=WIFI_TRANSPORT_DMA to feed the circular DMA receive path instead of IT.
+// Options:
+//     -k KiB       traffic to parse (default 4096)
+//     -c bytes     bytes per receive event, 1..WIFI_RX_BUF_LEN (default 64)
+//     -S scans     strstr passes over each burst; the old wait loop rescanned until a new burst came (default 1)
+//
+// The traffic repeats one CIPSEND exchange with an HTTP response in an +IPD frame, a CLOSED, and a
+// garbled +IPD header that must not swallow the OK behind it. The emulator only answers WiFi_Init().
+
+#define _POSIX_C_SOURCE 200809L
+#include "esp_emulator.h"
+#include "wifi_basic_driver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_BODY_LEN 200
+
+typedef struct
+{
+    uint32_t ok;
+    uint32_t ipd;
+    uint32_t closed;
+    uint32_t lines;
+    uint64_t data_bytes;
+} bench_counts_t;
+
+static bench_counts_t bench_counts;
+
+static void bench_on_event(wifi_event_t event, const char *line, void *context)
+{
+    (void)line;
+    (void)context;
+    bench_counts.ok += (event == WIFI_EVENT_OK) ? 1U : 0U;
+    bench_counts.ipd += (event == WIFI_EVENT_IPD) ? 1U : 0U;
+    bench_counts.closed += (event == WIFI_EVENT_CLOSED) ? 1U : 0U;
+    bench_counts.lines += (event == WIFI_EVENT_LINE) ? 1U : 0U;
+}
+
+static void bench_on_data(uint8_t link_id, const uint8_t *data, uint16_t length, void *context)
+{
+    (void)link_id;
+    (void)data;
+    (void)context;
+    bench_counts.data_bytes += length;
+}
+
+static uint64_t bench_nanos(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+// One exchange: 2 OK, 1 +IPD with BENCH_BODY_LEN bytes of HTTP, 1 CLOSED.
+static size_t bench_script(char *out, size_t out_len)
+{
+    char body[BENCH_BODY_LEN + 1];
+    int head = snprintf(body, sizeof(body), "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\n");
+    memset(body + head, 'x', (size_t)(BENCH_BODY_LEN - head));
+    body[BENCH_BODY_LEN] = '\0';
+    return (size_t)snprintf(out, out_len,
+                            "AT+CIPSEND=18\r\n\r\nOK\r\n> \r\nRecv 18 bytes\r\n\r\nSEND OK\r\n\r\n+IPD,%d:%sCLOSED\r\n"
+                            "\r\n+IPD,99999:noise\r\nOK\r\n",
+                            BENCH_BODY_LEN, body);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t kib = 4096;
+    uint16_t chunk = 64;
+    uint32_t scans = 1;
+    int option;
+    while ((option = getopt(argc, argv, "k:c:S:")) != -1)
+    {
+        switch (option)
+        {
+        case 'k': kib = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'c': chunk = (uint16_t)strtoul(optarg, NULL, 10); break;
+        case 'S': scans = (uint32_t)strtoul(optarg, NULL, 10); break;
+        default:
+            fprintf(stderr, "usage: %s [-k KiB] [-c bytes] [-S scans]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (chunk == 0 || chunk > WIFI_RX_BUF_LEN)
+    {
+        chunk = 64;
+    }
+
+    static char script[1024];
+    size_t script_len = bench_script(script, sizeof(script));
+    uint32_t repeats = (uint32_t)(((uint64_t)kib * 1024U + script_len - 1U) / script_len);
+    size_t total = script_len * repeats;
+    char *traffic = malloc(total + 1U);
+    for (uint32_t i = 0; i < repeats; i++)
+    {
+        memcpy(traffic + (size_t)i * script_len, script, script_len);
+    }
+    traffic[total] = '\0';
+
+    esp_emulator_config_t config;
+    ESP_Emulator_DefaultConfig(&config);
+    static UART_HandleTypeDef huart;
+    static wifi_handle_t wifi;
+    huart.Init.BaudRate = 115200;
+    ESP_Emulator_Start(&config, &huart);
+    if (WiFi_Init(&wifi, &huart) != WIFI_OK)
+    {
+        fprintf(stderr, "the driver did not come up against the emulator\n");
+        return 1;
+    }
+    WiFi_Poll(&wifi);
+    WiFi_SetEventHandler(&wifi, bench_on_event, NULL);
+    WiFi_SetDataHandler(&wifi, bench_on_data, NULL);
+
+    // Tokenizer: every burst lands in the ring from the receive event, then WiFi_Poll() drains it.
+    uint64_t start = bench_nanos();
+    for (size_t offset = 0; offset < total; offset += chunk)
+    {
+        uint16_t count = (total - offset < chunk) ? (uint16_t)(total - offset) : chunk;
+        Fake_UART_Receive((const uint8_t *)traffic + offset, count);
+        Fake_UART_Idle();
+        WiFi_Poll(&wifi);
+    }
+    double tokenizer_s = (double)(bench_nanos() - start) / 1e9;
+
+    uint8_t exact = (uint8_t)(bench_counts.ok == 2U * repeats && bench_counts.ipd == repeats && bench_counts.closed == repeats &&
+                              bench_counts.data_bytes == (uint64_t)BENCH_BODY_LEN * repeats && WiFi_GetRxOverruns(&wifi) == 0);
+
+    // Old driver: each burst is copied to a shadow buffer, terminated and the landing buffer cleared;
+    // then the wait loop looks for the expected reply and for ERROR.
+    static uint8_t rx_buffer[WIFI_RX_BUF_LEN];
+    static char shadow[WIFI_RX_BUF_LEN + 1];
+    uint32_t found = 0;
+    start = bench_nanos();
+    for (size_t offset = 0; offset < total; offset += chunk)
+    {
+        uint16_t count = (total - offset < chunk) ? (uint16_t)(total - offset) : chunk;
+        memcpy(rx_buffer, traffic + offset, count);
+        memcpy(shadow, rx_buffer, count);
+        shadow[count] = '\0';
+        memset(rx_buffer, 0, sizeof(rx_buffer));
+        for (uint32_t pass = 0; pass < scans; pass++)
+        {
+            const char *ok = strstr(shadow, "\r\nOK\r\n");
+            const char *error = strstr(shadow, "ERROR");
+            found += (pass == 0 && ok != NULL) ? 1U : 0U;
+            found += (error != NULL) ? 1U : 0U;
+        }
+    }
+    double strstr_s = (double)(bench_nanos() - start) / 1e9;
+
+    printf("%.1f KiB in %u-byte bursts, %u exchanges\n", (double)total / 1024.0, chunk, repeats);
+    printf("%-10s %10s  %s\n", "parser", "MB/s", "replies seen");
+    printf("%-10s %10.1f  %u of %u OK, %u +IPD frames, %u CLOSED%s\n", "tokenizer", (double)total / tokenizer_s / 1e6, bench_counts.ok,
+           2U * repeats, bench_counts.ipd, bench_counts.closed, exact ? "" : "  (MISMATCH)");
+    printf("%-10s %10.1f  %u of %u OK (at most one per burst; split replies are missed)\n", "strstr", (double)total / strstr_s / 1e6,
+           found, 2U * repeats);
+    free(traffic);
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,479 @@
+// Host benchmark for the ESP-01 driver: the real driver code talks to the emulated module in
+// esp_emulator.c over the fake UART in host/fake_hal.c, and the emulator forwards every link to an
+// HTTP server on 127.0.0.1 (a built-in one, or your own with -p). Build from this directory:
+//
+//     SRC="wifi_bench.c esp_emulator.c host/fake_hal.c ../Drivers/wifi_basic_driver.c ../Drivers/wifi_http_support.c"
+//     DRV="../Drivers/wifi_udp.c ../Drivers/wifi_retry.c ../Drivers/uart_dispatch.c"
+//     gcc -std=c11 -O2 -DWIFI_DEBUG=0 -Ihost -I../Drivers $SRC $DRV -lpthread -o wifi_bench
+//     ./wifi_bench -n 200 -b 115200 -l 2000 -f 16 -e 5
+//     ./wifi_bench -U 921600             (negotiate up with WiFi_SetBaudRate() and measure again)
+//     ./wifi_bench -U 921600 -M 460800   (the line cannot carry 921600: the fallback path)
+//
+// Add -DWIFI_TRANSPORT=WIFI_TRANSPORT_DMA to measure the circular DMA receive path instead of IT.
+// Options:
+//     -n count     requests per API (default 100)
+//     -b baud      rate both ends start at; the wire time of every byte is modelled (default 115200)
+//     -U baud      after the first run, switch to this rate with WiFi_SetBaudRate() and run again
+//     -M baud      fastest rate the line carries; the module's replies above it arrive as noise (default 0: no limit)
+//     -l us        module latency before each reply (default 2000)
+//     -w ms        channel scan of a join that names no BSSID (default 1500)
+//     -j us        random extra latency, 0..us (default 0)
+//     -f bytes     idle gap every this many bytes, to reproduce UART fragmentation (default 0: idle between replies)
+//     -e percent   AT+CIPSTART/AT+CIPSEND answered with ERROR (default 0)
+//     -B percent   commands refused with "busy p..." (default 0)
+//     -r bytes     response body size of the built-in server (default 64)
+//     -R attempts  max_retries passed to the HTTP calls (default 1)
+//     -p port      use the server already listening on 127.0.0.1:port instead of the built-in one
+//     -s seed      seed for jitter and error injection (default 1)
+//     -v           print the AT commands the module receives
+//
+// Each API prints its request rate, the payload throughput in both directions and the 50th/99th
+// percentile of the call time. The built-in server answers every request with 200 and keeps the
+// connection open unless asked to close it. It also counts the datagrams that reach the same port
+// over UDP; the WiFi_UDP_Send row keeps every datagram slot busy and counts a datagram as ok once
+// the module has sent it.
+// After the first run, the station leaves the AP and joins again with WiFi_Connect() and with
+// WiFi_Connect_Fast() (plain, with the cached BSSID, and with the BSSID and a static IP). Each join
+// is timed until a WiFi_SendTCP() right after it has reached the server.
+
+#define _POSIX_C_SOURCE 200809L
+#include "esp_emulator.h"
+#include "wifi_basic_driver.h"
+#include "wifi_http_support.h"
+#include "wifi_retry.h"
+#include "wifi_udp.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define BENCH_REQUEST_LEN 4096
+#define BENCH_JOINS 5
+
+typedef struct
+{
+    const char *name;
+    uint32_t requests;
+    uint32_t ok;
+    uint64_t elapsed_us;
+    uint64_t payload_bytes;  // Bytes the emulator forwarded to and from the server during the run.
+    double *samples_ms;
+} bench_result_t;
+
+static wifi_handle_t bench_wifi;
+static wifi_http_session_t bench_session;
+static wifi_udp_t bench_udp;
+static volatile uint32_t bench_udp_received; // Datagrams the built-in server got.
+static uint16_t bench_port;
+static uint32_t bench_body_len = 64;
+static uint8_t bench_retries = 1;
+
+static void *bench_server_main(void *arg);
+static void *bench_server_connection(void *arg);
+static uint16_t bench_server_start(void);
+static void *bench_udp_server(void *arg);
+static wifi_status_t bench_send_tcp(void);
+static wifi_status_t bench_udp_send(void);
+static wifi_status_t bench_http_get(void);
+static wifi_status_t bench_http_post(void);
+static wifi_status_t bench_session_get(void);
+static void bench_all(uint32_t count);
+static void bench_join(uint32_t joins);
+static void bench_run(bench_result_t *result, wifi_status_t (*call)(void), uint32_t count);
+static void bench_print(const bench_result_t *result);
+static int bench_compare(const void *a, const void *b);
+
+int main(int argc, char **argv)
+{
+    esp_emulator_config_t config;
+    ESP_Emulator_DefaultConfig(&config);
+    config.scan_ms = 1500; // 13 channels at about 120 ms each.
+    uint32_t count = 100;
+    uint32_t baud = 115200;
+    uint32_t upgrade = 0;
+    int option;
+    while ((option = getopt(argc, argv, "n:b:U:M:l:w:j:f:e:B:r:R:p:s:v")) != -1)
+    {
+        switch (option)
+        {
+        case 'n': count = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'b': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'U': upgrade = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'M': config.max_baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'l': config.latency_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'w': config.scan_ms = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'j': config.jitter_us = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'f': config.fragment_len = (uint16_t)strtoul(optarg, NULL, 10); break;
+        case 'e': config.error_percent = (uint8_t)strtoul(optarg, NULL, 10); break;
+        case 'B': config.busy_percent = (uint8_t)strtoul(optarg, NULL, 10); break;
+        case 'r': bench_body_len = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'R': bench_retries = (uint8_t)strtoul(optarg, NULL, 10); break;
+        case 'p': bench_port = (uint16_t)strtoul(optarg, NULL, 10); break;
+        case 's': config.seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'v': config.verbose = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-n count] [-b baud] [-U baud] [-M baud] [-l us] [-w ms] [-j us] [-f bytes] [-e %%] [-B %%] [-r bytes] "
+                            "[-R attempts] [-p port] [-s seed] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (count == 0)
+    {
+        count = 1;
+    }
+    if (bench_port == 0 && (bench_port = bench_server_start()) == 0)
+    {
+        return 1;
+    }
+
+    static UART_HandleTypeDef huart;
+    huart.Init.BaudRate = baud;
+    ESP_Emulator_Start(&config, &huart);
+
+    uint64_t start = Fake_HAL_Micros();
+    if (WiFi_Init(&bench_wifi, &huart) != WIFI_OK || WiFi_Connect(&bench_wifi, "bench", "benchmark") != WIFI_OK)
+    {
+        fprintf(stderr, "the driver did not come up against the emulator\n");
+        return 1;
+    }
+    printf("%u baud, latency %u us (+%u), idle every %u bytes, %u%% errors, %u%% busy, server 127.0.0.1:%u\n", baud,
+           config.latency_us, config.jitter_us, config.fragment_len, config.error_percent, config.busy_percent, bench_port);
+    printf("WiFi_Init + WiFi_Connect: %.1f ms\n\n", (double)(Fake_HAL_Micros() - start) / 1000.0);
+    bench_all(count);
+    bench_join((count < BENCH_JOINS) ? count : BENCH_JOINS);
+
+    if (upgrade != 0)
+    {
+        start = Fake_HAL_Micros();
+        wifi_status_t status = WiFi_SetBaudRate(&bench_wifi, upgrade);
+        printf("\nWiFi_SetBaudRate(%u): %s after %.1f ms, running at %u baud\n\n", upgrade, WiFi_StatusToString(status),
+               (double)(Fake_HAL_Micros() - start) / 1000.0, huart.Init.BaudRate);
+        bench_all(count);
+    }
+
+    esp_emulator_stats_t stats;
+    ESP_Emulator_GetStats(&stats);
+    printf("\nemulator: %u commands, %u links, %u injected errors, %u busy, %llu bytes up, %llu bytes down, %u rate changes, "
+           "%u garbled bytes\n",
+           stats.commands, stats.connects, stats.injected_errors, stats.injected_busy, (unsigned long long)stats.bytes_up,
+           (unsigned long long)stats.bytes_down, stats.baud_changes, stats.garbled);
+    return 0;
+}
+
+static void bench_all(uint32_t count)
+{
+    bench_result_t results[] = {
+        {"WiFi_SendTCP", 0, 0, 0, 0, NULL},
+        {"WiFi_UDP_Send", 0, 0, 0, 0, NULL},
+        {"WiFi_HTTP_GET", 0, 0, 0, 0, NULL},
+        {"WiFi_HTTP_POST", 0, 0, 0, 0, NULL},
+        {"HTTP session GET", 0, 0, 0, 0, NULL},
+    };
+    wifi_status_t (*const calls[])(void) = {bench_send_tcp, bench_udp_send, bench_http_get, bench_http_post, bench_session_get};
+
+    printf("%-18s %8s %8s %9s %9s %9s %9s\n", "API", "requests", "ok", "req/s", "KB/s", "p50 ms", "p99 ms");
+    for (size_t i = 0; i < sizeof(results) / sizeof(results[0]); i++)
+    {
+        WiFi_Breaker_Reset(); // Each API starts with a closed breaker.
+        if (calls[i] == bench_session_get)
+        {
+            WiFi_HTTP_Session_Init(&bench_session, &bench_wifi, "127.0.0.1", bench_port);
+        }
+        if (calls[i] == bench_udp_send && WiFi_UDP_Open(&bench_udp, &bench_wifi, "127.0.0.1", bench_port) != WIFI_OK)
+        {
+            printf("%-18s the UDP link did not open\n", results[i].name);
+            continue;
+        }
+        uint32_t received = bench_udp_received;
+        bench_run(&results[i], calls[i], count);
+        if (calls[i] == bench_udp_send)
+        {
+            // The last datagrams are still queued when the loop ends; the time to send them counts.
+            uint64_t start = Fake_HAL_Micros();
+            WiFi_UDP_Close(&bench_udp);
+            results[i].elapsed_us += Fake_HAL_Micros() - start;
+            wifi_udp_stats_t stats;
+            WiFi_UDP_GetStats(&bench_udp, &stats);
+            results[i].ok = stats.sent;
+        }
+        bench_print(&results[i]);
+        if (calls[i] == bench_udp_send)
+        {
+            HAL_Delay(20); // Let the last datagrams reach the server.
+            printf("%-18s %u received by the server\n", "", (unsigned int)(bench_udp_received - received));
+        }
+        if (calls[i] == bench_session_get)
+        {
+            printf("%-18s %u connects for %u requests\n", "", (unsigned int)bench_session.connects, count);
+            WiFi_HTTP_Session_Close(&bench_session);
+        }
+        free(results[i].samples_ms);
+    }
+}
+
+// Leave the AP, then time each way of joining until the first packet has reached the server.
+static void bench_join(uint32_t joins)
+{
+    static const wifi_static_ip_t static_ip = {"192.168.4.50", "192.168.4.1", "255.255.255.0"};
+    wifi_join_cache_t cache;
+    if (WiFi_GetJoinCache(&bench_wifi, &cache) != WIFI_OK)
+    {
+        printf("\nAT+CWJAP? did not return the AP; no join timing\n");
+        return;
+    }
+    // The static IP goes last: the module keeps DHCP off once AT+CIPSTA has set an address.
+    const struct
+    {
+        const char *name;
+        uint8_t fast;
+        const wifi_join_cache_t *cache;
+        const wifi_static_ip_t *static_ip;
+    } modes[] = {
+        {"WiFi_Connect", 0, NULL, NULL},
+        {"Fast", 1, NULL, NULL},
+        {"Fast + BSSID", 1, &cache, NULL},
+        {"Fast + BSSID + IP", 1, &cache, &static_ip},
+    };
+
+    printf("\n%-18s %8s %8s %9s %9s %9s\n", "join to 1st packet", "joins", "ok", "p50 ms", "p99 ms", "got IP ms");
+    double *samples = calloc(joins, sizeof(double));
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+    {
+        uint32_t ok = 0;
+        double got_ip_ms = 0.0;
+        for (uint32_t i = 0; i < joins; i++)
+        {
+            WiFi_Send_Command(&bench_wifi, "AT+CWQAP\r\n", "OK", 2000);
+            WiFi_Breaker_Reset();
+            uint64_t begin = Fake_HAL_Micros();
+            wifi_status_t status = modes[m].fast ? WiFi_Connect_Fast(&bench_wifi, "bench", "benchmark", modes[m].cache,
+                                                                      modes[m].static_ip, 15000)
+                                                 : WiFi_Connect(&bench_wifi, "bench", "benchmark");
+            if (status == WIFI_OK)
+            {
+                status = bench_send_tcp();
+            }
+            samples[i] = (double)(Fake_HAL_Micros() - begin) / 1000.0;
+            ok += (status == WIFI_OK) ? 1U : 0U;
+            if (modes[m].fast)
+            {
+                wifi_join_stats_t stats;
+                WiFi_GetJoinStats(&bench_wifi, &stats);
+                got_ip_ms += (double)stats.got_ip_ms / joins;
+            }
+        }
+        qsort(samples, joins, sizeof(double), bench_compare);
+        uint32_t p50 = (joins * 50U + 99U) / 100U;
+        uint32_t p99 = (joins * 99U + 99U) / 100U;
+        printf("%-18s %8u %8u %9.1f %9.1f", modes[m].name, joins, ok, samples[p50 - 1U], samples[p99 - 1U]);
+        if (modes[m].fast)
+        {
+            printf(" %9.1f\n", got_ip_ms);
+        }
+        else
+        {
+            printf(" %9s\n", "-"); // WiFi_GetJoinStats() only times WiFi_Connect_Fast().
+        }
+    }
+    free(samples);
+}
+
+static wifi_status_t bench_send_tcp(void)
+{
+    return WiFi_SendTCP(&bench_wifi, "127.0.0.1", bench_port, "bench 0123456789\r\n");
+}
+
+// Wait for a free datagram slot, so the rate is what the module sustains and not how fast BUSY comes back.
+static wifi_status_t bench_udp_send(void)
+{
+    static const uint8_t payload[] = "bench 0123456789\r\n";
+    while (WiFi_Command_Pending(&bench_wifi) >= WIFI_UDP_SLOTS)
+    {
+        WiFi_Poll(&bench_wifi);
+    }
+    return WiFi_UDP_Send(&bench_udp, payload, (uint16_t)(sizeof(payload) - 1U));
+}
+
+static wifi_status_t bench_http_get(void)
+{
+    return WiFi_HTTP_GET(&bench_wifi, "127.0.0.1", bench_port, "/bench", NULL, 5000, bench_retries);
+}
+
+static wifi_status_t bench_http_post(void)
+{
+    static const wifi_http_header_t headers[] = {{"Content-Type", "application/json"}, {NULL, NULL}};
+    return WiFi_HTTP_POST(&bench_wifi, "127.0.0.1", bench_port, "/bench", headers, "{\"t\":21.37,\"h\":45.12,\"p\":101325.40}",
+                          5000, bench_retries);
+}
+
+static wifi_status_t bench_session_get(void)
+{
+    return WiFi_HTTP_Session_Request(&bench_session, "GET", "/bench", NULL, NULL, 5000, bench_retries);
+}
+
+static void bench_run(bench_result_t *result, wifi_status_t (*call)(void), uint32_t count)
+{
+    esp_emulator_stats_t before;
+    esp_emulator_stats_t after;
+    ESP_Emulator_GetStats(&before);
+    result->samples_ms = calloc(count, sizeof(double));
+    uint64_t start = Fake_HAL_Micros();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t begin = Fake_HAL_Micros();
+        wifi_status_t status = call();
+        result->samples_ms[i] = (double)(Fake_HAL_Micros() - begin) / 1000.0;
+        result->requests++;
+        result->ok += (status == WIFI_OK) ? 1U : 0U;
+    }
+    result->elapsed_us = Fake_HAL_Micros() - start;
+    ESP_Emulator_GetStats(&after);
+    result->payload_bytes = (after.bytes_up - before.bytes_up) + (after.bytes_down - before.bytes_down);
+}
+
+// Percentiles use the nearest-rank method over every call, failed ones included.
+static void bench_print(const bench_result_t *result)
+{
+    qsort(result->samples_ms, result->requests, sizeof(double), bench_compare);
+    uint32_t p50 = (result->requests * 50U + 99U) / 100U;
+    uint32_t p99 = (result->requests * 99U + 99U) / 100U;
+    double seconds = (double)result->elapsed_us / 1e6;
+    printf("%-18s %8u %8u %9.1f %9.2f %9.2f %9.2f\n", result->name, result->requests, result->ok, (double)result->ok / seconds,
+           (double)result->payload_bytes / 1000.0 / seconds, result->samples_ms[p50 - 1U], result->samples_ms[p99 - 1U]);
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static uint16_t bench_server_start(void)
+{
+    static int listener;
+    struct sockaddr_in address;
+    socklen_t address_len = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 8) != 0 ||
+        getsockname(listener, (struct sockaddr *)&address, &address_len) != 0)
+    {
+        perror("server");
+        return 0;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, bench_server_main, &listener) != 0)
+    {
+        return 0;
+    }
+    pthread_detach(thread);
+
+    // The same port number over UDP, for the WiFi_UDP_Send row.
+    static int datagrams;
+    datagrams = socket(AF_INET, SOCK_DGRAM, 0);
+    if (datagrams >= 0 && bind(datagrams, (struct sockaddr *)&address, sizeof(address)) == 0 &&
+        pthread_create(&thread, NULL, bench_udp_server, &datagrams) == 0)
+    {
+        pthread_detach(thread);
+    }
+    return ntohs(address.sin_port);
+}
+
+static void *bench_udp_server(void *arg)
+{
+    int fd = *(int *)arg;
+    uint8_t datagram[WIFI_UDP_HEADER_LEN + WIFI_UDP_MAX_PAYLOAD];
+    for (;;)
+    {
+        if (recv(fd, datagram, sizeof(datagram), 0) > 0)
+        {
+            bench_udp_received++;
+        }
+    }
+    return NULL;
+}
+
+static void *bench_server_main(void *arg)
+{
+    int listener = *(int *)arg;
+    for (;;)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0)
+        {
+            continue;
+        }
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, bench_server_connection, (void *)(intptr_t)fd) != 0)
+        {
+            close(fd);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+// One connection: answer each request (headers plus Content-Length body) with bench_body_len bytes.
+// Anything that is not HTTP, such as the WiFi_SendTCP payload, is read until the peer closes.
+static void *bench_server_connection(void *arg)
+{
+    int fd = (int)(intptr_t)arg;
+    char request[BENCH_REQUEST_LEN + 1];
+    size_t used = 0;
+    char *response = malloc(bench_body_len + 128U);
+    for (;;)
+    {
+        ssize_t count = recv(fd, request + used, BENCH_REQUEST_LEN - used, 0);
+        if (count <= 0)
+        {
+            break;
+        }
+        used += (size_t)count;
+        request[used] = '\0';
+
+        char *end;
+        while ((end = strstr(request, "\r\n\r\n")) != NULL)
+        {
+            size_t header_len = (size_t)(end - request) + 4U;
+            const char *length = strstr(request, "Content-Length:");
+            size_t body_len = (length != NULL && length < end) ? strtoul(length + 15, NULL, 10) : 0U;
+            if (used < header_len + body_len)
+            {
+                break; // The body is still on its way.
+            }
+
+            uint8_t close_after = (uint8_t)(strstr(request, "Connection: close") != NULL && strstr(request, "Connection: close") < end);
+            int head = snprintf(response, 128, "HTTP/1.1 200 OK\r\nContent-Length: %u\r\nConnection: %s\r\n\r\n",
+                                (unsigned int)bench_body_len, close_after ? "close" : "keep-alive");
+            memset(response + head, 'x', bench_body_len);
+            send(fd, response, (size_t)head + bench_body_len, MSG_NOSIGNAL);
+
+            memmove(request, request + header_len + body_len, used - header_len - body_len);
+            used -= header_len + body_len;
+            request[used] = '\0';
+            if (close_after)
+            {
+                free(response);
+                close(fd);
+                return NULL;
+            }
+        }
+        if (used == BENCH_REQUEST_LEN)
+        {
+            used = 0; // Not a request this server understands; keep draining.
+        }
+    }
+    free(response);
+    close(fd);
+    return NULL;
+}